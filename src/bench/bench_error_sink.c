@@ -0,0 +1,130 @@
+/**
+ * Measure the latency of `error_sink_push()`, that is the cost added to `last_error_set()` when the errors
+ * are written into a file.
+ *
+ * Usage: bench_error_sink [<number of errors per thread>]
+ *
+ * Each error is pushed individually and timed. The latencies are reported for 1 producer thread and for
+ * several producer threads. Under overload, the errors are dropped (the pushes never block).
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../pattern3/last_error.h"
+#include "../pattern3/error_sink.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define MAX_THREADS_COUNT 4
+#define ERROR_LINE 10
+
+struct Producer {
+    long     iterations;
+    int64_t *latencies;
+};
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+capture(
+        struct LastErrorRecord *out_record,
+        const char *in_fmt,
+        ...) {
+    va_list arguments;
+    va_start(arguments, in_fmt);
+    last_error_record_capture(out_record, 1, __FILE__, ERROR_LINE, "produce", in_fmt, arguments);
+    va_end(arguments);
+}
+
+static void *
+produce(void *in_producer) {
+    struct Producer *producer = (struct Producer *) in_producer;
+    struct LastErrorRecord record;
+
+    capture(&record, "retry #%d failed for %s", 1, "host");
+    for (long i = 0; i < producer->iterations; i++) {
+        int64_t start = now_ns();
+        error_sink_push(&record);
+        producer->latencies[i] = now_ns() - start;
+    }
+    return NULL;
+}
+
+static int
+compare_latencies(const void *in_a, const void *in_b) {
+    const int64_t a = *(const int64_t *) in_a;
+    const int64_t b = *(const int64_t *) in_b;
+    return (a > b) - (a < b);
+}
+
+static int
+run(const int in_threads_count, const long in_iterations, const char *in_path) {
+    const size_t count = (size_t)in_threads_count * (size_t)in_iterations;
+    struct Producer producers[MAX_THREADS_COUNT];
+    pthread_t threads[MAX_THREADS_COUNT];
+    int64_t *latencies = (int64_t *) malloc(count * sizeof(int64_t));
+    uint64_t dropped = error_sink_dropped();
+    double total = 0;
+
+    if (NULL == latencies) return 1;
+    if (failure == error_sink_open(in_path)) {
+        free(latencies);
+        return 1;
+    }
+    for (int i = 0; i < in_threads_count; i++) {
+        producers[i].iterations = in_iterations;
+        producers[i].latencies  = latencies + (size_t)i * (size_t)in_iterations;
+        if (0 != pthread_create(&threads[i], NULL, produce, &producers[i])) return 1;
+    }
+    for (int i = 0; i < in_threads_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    error_sink_close();
+    dropped = error_sink_dropped() - dropped;
+
+    qsort(latencies, count, sizeof(int64_t), compare_latencies);
+    for (size_t i = 0; i < count; i++) {
+        total += (double)latencies[i];
+    }
+    printf("%d thread(s): mean %6.1f ns, p50 %5lld ns, p99 %6lld ns, p99.9 %7lld ns, max %9lld ns"
+           " (%llu of %zu dropped)\n",
+           in_threads_count,
+           total / (double)count,
+           (long long) latencies[count / 2],
+           (long long) latencies[count * 99 / 100],
+           (long long) latencies[count * 999 / 1000],
+           (long long) latencies[count - 1],
+           (unsigned long long) dropped,
+           count);
+    free(latencies);
+    return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    char directory[] = "/tmp/bench_error_sink-XXXXXX";
+    char path[sizeof(directory) + 16];
+    int status = 0;
+
+    if (iterations <= 0) return 1;
+    if (NULL == mkdtemp(directory)) return 1;
+    snprintf(path, sizeof(path), "%s/errors.log", directory);
+
+    printf("iterations: %ld per thread\n", iterations);
+    for (int threads_count = 1; (threads_count <= MAX_THREADS_COUNT) && (0 == status); threads_count *= 2) {
+        status = run(threads_count, iterations, path);
+        unlink(path);
+    }
+    rmdir(directory);
+    return status;
+}
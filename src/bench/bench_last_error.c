@@ -0,0 +1,108 @@
+/**
+ * Measure the cost of `last_error_set()`.
+ *
+ * Usage: bench_last_error [<number of iterations>]
+ *
+ * - "eager": the previous implementation, which formats the message when the error is set.
+ * - "lazy": `last_error_set()` only (the message is never read, which is the common case).
+ * - "lazy + get": `last_error_set()` followed by `last_error_get_message()`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../pattern3/last_error.h"
+
+#define DEFAULT_ITERATIONS 5000000
+#define EAGER_FILE_BUFFER_CAPACITY 2048
+#define ERROR_LINE 10
+
+static char EAGER_FILE[EAGER_FILE_BUFFER_CAPACITY];
+static char EAGER_MESSAGE[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+static int  EAGER_ID;
+static int  EAGER_LINE;
+
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief The previous implementation of `last_error_set()`.
+ */
+
+static Status
+eager_last_error_set(
+        const int in_error_id,
+        const char *in_file,
+        int in_line,
+        const char *in_function,
+        const char *in_fmt,
+        ...) {
+    int    bytes_written;
+    size_t remaining_capacity = LAST_ERROR_MESSAGE_BUFFER_CAPACITY;
+    va_list arg_ptr;
+
+    EAGER_ID = in_error_id;
+    EAGER_LINE = in_line;
+    strncpy(EAGER_FILE, in_file, EAGER_FILE_BUFFER_CAPACITY);
+    EAGER_FILE[EAGER_FILE_BUFFER_CAPACITY-1] = 0;
+    bytes_written = snprintf(EAGER_MESSAGE,
+                             remaining_capacity,
+                             "#%010d [%s:%d %s()] ", in_error_id, in_file, in_line, in_function);
+    if ((bytes_written < 0) || ((size_t)bytes_written >= remaining_capacity)) {
+        EAGER_MESSAGE[0] = 0;
+        return failure;
+    }
+    remaining_capacity -= (size_t)bytes_written;
+    va_start(arg_ptr, in_fmt);
+    bytes_written = vsnprintf(EAGER_MESSAGE + bytes_written, remaining_capacity, in_fmt, arg_ptr);
+    va_end(arg_ptr);
+    if ((bytes_written < 0) || ((size_t)bytes_written >= remaining_capacity)) {
+        EAGER_MESSAGE[0] = 0;
+        return failure;
+    }
+    return success;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    double start, eager_time, lazy_time, lazy_get_time;
+    size_t checksum = 0;
+
+    start = now();
+    for (long i = 0; i < iterations; i++) {
+        eager_last_error_set(1, __FILE__, ERROR_LINE, __func__, "retry #%ld failed for %s", i, "host");
+        checksum += (size_t)EAGER_ID;
+    }
+    eager_time = now() - start;
+
+    start = now();
+    for (long i = 0; i < iterations; i++) {
+        last_error_set(1, __FILE__, ERROR_LINE, __func__, "retry #%ld failed for %s", i, "host");
+        checksum += (size_t)last_error_get_id();
+    }
+    lazy_time = now() - start;
+
+    start = now();
+    for (long i = 0; i < iterations; i++) {
+        last_error_set(1, __FILE__, ERROR_LINE, __func__, "retry #%ld failed for %s", i, "host");
+        checksum += strlen(last_error_get_message());
+    }
+    lazy_get_time = now() - start;
+
+    if (0 != strcmp(EAGER_MESSAGE, last_error_get_message())) {
+        printf("the messages are different:\n[%s]\n[%s]\n", EAGER_MESSAGE, last_error_get_message());
+        return 1;
+    }
+
+    printf("iterations: %ld (checksum %zu)\n", iterations, checksum);
+    printf("eager:      %8.1f ns/error\n", eager_time * 1e9 / (double)iterations);
+    printf("lazy:       %8.1f ns/error (x%.1f)\n", lazy_time * 1e9 / (double)iterations, eager_time / lazy_time);
+    printf("lazy + get: %8.1f ns/error\n", lazy_get_time * 1e9 / (double)iterations);
+    return 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * Compare the throughput of the `printf()` loop (formerly used by the patterns 1 and 2) with the bulk export.
+ *
+ * Usage: bench_ms_export [<number of rows>]
+ *
+ * The rows are written into "/dev/null", so that only the formatting cost is measured.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../my_struct/ms_export.h"
+
+#define DEFAULT_ROWS 10000000
+
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char *argv[]) {
+    size_t rows = argc > 1 ? (size_t)strtoul(argv[1], NULL, 10) : DEFAULT_ROWS;
+    struct my_struct *data;
+    struct my_struct **array;
+    FILE *out;
+    int fd;
+    double start, printf_time, csv_time, binary_time;
+
+    data = (struct my_struct *) malloc(sizeof(struct my_struct) * rows);
+    array = (struct my_struct **) malloc(sizeof(struct my_struct *) * rows);
+    if ((NULL == data) || (NULL == array)) return 1;
+    for (size_t i = 0; i < rows; i++) {
+        data[i].a = (int)i;
+        data[i].b = (int)i * 10;
+        array[i] = &data[i];
+    }
+
+    out = fopen("/dev/null", "w");
+    fd = open("/dev/null", O_WRONLY);
+    if ((NULL == out) || (fd < 0)) return 1;
+
+    start = now();
+    for (size_t i = 0; i < rows; i++) {
+        fprintf(out, "(%d, %d)\n", array[i]->a, array[i]->b);
+    }
+    fflush(out);
+    printf_time = now() - start;
+
+    start = now();
+    if (MS_failure == MS_export_csv(fd, array, rows)) return 1;
+    csv_time = now() - start;
+
+    start = now();
+    if (MS_failure == MS_export_binary(fd, array, rows)) return 1;
+    binary_time = now() - start;
+
+    printf("rows:   %zu\n", rows);
+    printf("printf: %8.3f s (%12.0f rows/s)\n", printf_time, (double)rows / printf_time);
+    printf("csv:    %8.3f s (%12.0f rows/s) x%.1f\n", csv_time, (double)rows / csv_time, printf_time / csv_time);
+    printf("binary: %8.3f s (%12.0f rows/s) x%.1f\n", binary_time, (double)rows / binary_time, printf_time / binary_time);
+
+    fclose(out);
+    close(fd);
+    free(array);
+    free(data);
+    return 0;
+}
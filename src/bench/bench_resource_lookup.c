@@ -0,0 +1,113 @@
+/**
+ * Compare the lookup of a resource from its name: linear scan (`strcmp()` on all the names) versus the perfect
+ * hash table generated by "pattern4.h".
+ *
+ * Usage: bench_resource_lookup [<number of lookups>]
+ *
+ * The number of declared resources is given at compilation time by `BENCH_RESOURCES_COUNT` (4, 64 or 512),
+ * in addition to the 2 base resources.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef BENCH_RESOURCES_COUNT
+#define BENCH_RESOURCES_COUNT 4
+#endif
+
+#define DEFAULT_LOOKUPS 10000000
+
+// Declare 4 resources ("mysql", "redis"...), or 64 or 512 resources named "res000", "res001"...
+#define DECLARE1(p) DECLARE(DRes##p, "res" #p, RM_none_handler, 0, 0)
+#define DECLARE8(p) \
+DECLARE1(p##0) DECLARE1(p##1) DECLARE1(p##2) DECLARE1(p##3) \
+DECLARE1(p##4) DECLARE1(p##5) DECLARE1(p##6) DECLARE1(p##7)
+#define DECLARE64(p) \
+DECLARE8(p##0) DECLARE8(p##1) DECLARE8(p##2) DECLARE8(p##3) \
+DECLARE8(p##4) DECLARE8(p##5) DECLARE8(p##6) DECLARE8(p##7)
+#define DECLARE512() \
+DECLARE64(0) DECLARE64(1) DECLARE64(2) DECLARE64(3) \
+DECLARE64(4) DECLARE64(5) DECLARE64(6) DECLARE64(7)
+
+#if BENCH_RESOURCES_COUNT == 4
+#define RESOURCES_TYPES \
+DECLARE(DMysql, "mysql", RM_none_handler, 0, 0) DECLARE(DRedis, "redis", RM_none_handler, 0, 0) \
+DECLARE(DSocket, "socket", RM_none_handler, 0, 0) DECLARE(DPipe, "pipe", RM_none_handler, 0, 0)
+#elif BENCH_RESOURCES_COUNT == 64
+#define RESOURCES_TYPES DECLARE64(0)
+#elif BENCH_RESOURCES_COUNT == 512
+#define RESOURCES_TYPES DECLARE512()
+#else
+#error "BENCH_RESOURCES_COUNT must be 4, 64 or 512."
+#endif
+
+#include "../pattern4.h"
+
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static enum Resource
+linear_lookup(const char *in_name) {
+    for (int e = 0; e < EOR; e++) {
+        if (0 == strcmp(resource_name[e], in_name)) return (enum Resource) e;
+    }
+    return EOR;
+}
+
+int
+main(int argc, char *argv[]) {
+    long lookups = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_LOOKUPS;
+    char *names[EOR];
+    double start, linear_time, hash_time;
+    size_t checksum_linear = 0;
+    size_t checksum_hash = 0;
+
+    if (lookups <= 0) return 1;
+    start = now();
+    if (0 != resource_index_init()) return 1;
+    printf("resources:  %d (table built in %.1f us)\n", (int) EOR, (now() - start) * 1e6);
+
+    // The names to look up are copies (the pointers of `resource_name[]` are not reused), in a shuffled order.
+    srand(1);
+    for (int e = 0; e < EOR; e++) {
+        names[e] = strdup(resource_name[e]);
+        if (NULL == names[e]) return 1;
+    }
+    for (int e = EOR - 1; e > 0; e--) {
+        int other = rand() % (e + 1);
+        char *name = names[e];
+        names[e] = names[other];
+        names[other] = name;
+    }
+
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        checksum_linear += (size_t)linear_lookup(names[i % EOR]);
+    }
+    linear_time = now() - start;
+
+    start = now();
+    for (long i = 0; i < lookups; i++) {
+        checksum_hash += (size_t)resource_lookup(names[i % EOR]);
+    }
+    hash_time = now() - start;
+
+    for (int e = 0; e < EOR; e++) {
+        free(names[e]);
+    }
+    if (checksum_linear != checksum_hash) {
+        printf("the lookups are different: %zu / %zu\n", checksum_linear, checksum_hash);
+        return 1;
+    }
+
+    printf("lookups:    %ld (checksum %zu)\n", lookups, checksum_hash);
+    printf("linear:     %8.1f ns/lookup\n", linear_time * 1e9 / (double)lookups);
+    printf("hash:       %8.1f ns/lookup (x%.1f)\n", hash_time * 1e9 / (double)lookups, linear_time / hash_time);
+    return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * Compare borrowing N buffers one by one with borrowing them in a batch (see `RM_mem_handler_borrow_many()`).
+ *
+ * Usage: bench_rm_batch [<number of iterations>]
+ *
+ * Each iteration borrows 8 buffers and gives them back. The test is run without report file, and with a report
+ * file (each call to `borrow()` / `give_back()` writes a record, a batch writes a single record).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_mem.h"
+
+#define DEFAULT_ITERATIONS 100000
+#define BATCH_SIZE 8
+#define OBJECT_SIZE 256
+#define CAPACITY 64
+#define PATH_CAPACITY 256
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+one_by_one(const long in_iterations) {
+    void *buffers[BATCH_SIZE];
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        for (int j = 0; j < BATCH_SIZE; j++) {
+            if (RM_failure == RM_mem_handler_borrow(&buffers[j], 1, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+                return -1;
+            }
+        }
+        for (int j = 0; j < BATCH_SIZE; j++) {
+            RM_mem_handler_give_back(&buffers[j], 2, __FILE__, __LINE__, (char *) __func__);
+        }
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+static double
+batch(const long in_iterations) {
+    void *buffers[BATCH_SIZE];
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        if (RM_failure == RM_mem_handler_borrow_many(buffers, BATCH_SIZE, 1, __FILE__, __LINE__, (char *) __func__,
+                                                     RM_false)) {
+            return -1;
+        }
+        RM_mem_handler_give_back_many(buffers, BATCH_SIZE, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+static int
+run(
+        const char *in_name,
+        char *in_report_path,
+        const long in_iterations) {
+    double single;
+    double many;
+
+    RM_init(-1, 0, in_report_path);
+    single = one_by_one(in_iterations);
+    many = batch(in_iterations);
+    if ((single < 0) || (many < 0)) return 1;
+    printf("%-12s %d buffers: one by one %10.1f ns | batch %10.1f ns | x%.2f\n",
+           in_name, BATCH_SIZE, single, many, single / many);
+    return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    char directory[] = "/tmp/bench_rm_batch-XXXXXX";
+    char report[PATH_CAPACITY];
+    int status = 1;
+
+    if (iterations <= 0) return 1;
+    if (NULL == mkdtemp(directory)) return 1;
+    snprintf(report, PATH_CAPACITY, "%s/report.txt", directory);
+    if (RM_failure == RM_mem_handler_init(OBJECT_SIZE, CAPACITY)) goto end;
+
+    if (0 != run("no report", NULL, iterations)) goto end;
+    if (0 != run("report", report, iterations / 10 > 0 ? iterations / 10 : 1)) goto end;
+    status = 0;
+
+end:
+    RM_init(-1, 0, NULL);
+    RM_mem_handler_terminate();
+    unlink(report);
+    rmdir(directory);
+    return status;
+}
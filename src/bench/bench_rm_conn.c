@@ -0,0 +1,111 @@
+/**
+ * Measure the latency of getting a connection to a server, with and without the connection pool.
+ *
+ * Usage: bench_rm_conn [<number of requests>]
+ *
+ * The server is the local echo server (see "rm_echo.h"). Each request gets a connection, sends a byte, waits for
+ * the echo, and releases the connection.
+ *
+ * - "connect": the connection is opened, and closed after the request.
+ * - "pool": the connection is borrowed from the pool, and given back after the request.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_conn.h"
+#include "../resource_manager/rm_echo.h"
+
+#define DEFAULT_REQUESTS 100000
+#define POOL_MIN_SIZE 4
+#define POOL_CAPACITY 16
+#define PATH_CAPACITY 256
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int
+compare_latencies(const void *in_a, const void *in_b) {
+    const int64_t a = *(const int64_t *) in_a;
+    const int64_t b = *(const int64_t *) in_b;
+    return (a > b) - (a < b);
+}
+
+static void
+report(
+        const char *in_name,
+        int64_t *in_latencies,
+        const size_t in_count,
+        const double in_total_s) {
+    qsort(in_latencies, in_count, sizeof(int64_t), compare_latencies);
+    printf("%-8s get connection: p50 %7lld ns, p99 %7lld ns, p99.9 %8lld ns, max %9lld ns | %8.1f requests/s\n",
+           in_name,
+           (long long) in_latencies[in_count / 2],
+           (long long) in_latencies[in_count * 99 / 100],
+           (long long) in_latencies[in_count * 999 / 1000],
+           (long long) in_latencies[in_count - 1],
+           (double) in_count / in_total_s);
+}
+
+int
+main(int argc, char *argv[]) {
+    long requests = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_REQUESTS;
+    char directory[] = "/tmp/bench_rm_conn-XXXXXX";
+    char path[PATH_CAPACITY];
+    RM_ConnectionFactory factory;
+    int64_t *latencies;
+    int64_t start;
+    int status = 1;
+
+    if (requests <= 0) return 1;
+    latencies = (int64_t *) malloc((size_t)requests * sizeof(int64_t));
+    if (NULL == latencies) return 1;
+    if (NULL == mkdtemp(directory)) return 1;
+    snprintf(path, PATH_CAPACITY, "%s/echo.sock", directory);
+    if (RM_failure == RM_echo_server_start(path)) goto end;
+    factory = RM_echo_factory(path);
+
+    // Without pool.
+    start = now_ns();
+    for (long i = 0; i < requests; i++) {
+        int64_t begin = now_ns();
+        void *connection = factory.connect(factory.context);
+        latencies[i] = now_ns() - begin;
+        if ((NULL == connection) || (RM_failure == RM_echo_ping((RM_EchoConnection *) connection))) goto end;
+        factory.disconnect(connection);
+    }
+    report("connect", latencies, (size_t)requests, (double)(now_ns() - start) / 1e9);
+
+    // With pool.
+    RM_init(-1, 0, NULL);
+    RM_conn_handler_configure(&factory, POOL_MIN_SIZE, 60000);
+    if (RM_failure == RM_conn_handler_init(0, POOL_CAPACITY)) goto end;
+    start = now_ns();
+    for (long i = 0; i < requests; i++) {
+        int64_t begin = now_ns();
+        void *connection;
+        if (RM_failure == RM_conn_handler_borrow(&connection, 1, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+            goto end;
+        }
+        latencies[i] = now_ns() - begin;
+        if (RM_failure == RM_echo_ping((RM_EchoConnection *) connection)) goto end;
+        RM_conn_handler_give_back(&connection, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    report("pool", latencies, (size_t)requests, (double)(now_ns() - start) / 1e9);
+    status = 0;
+
+end:
+    RM_conn_handler_terminate();
+    RM_echo_server_stop();
+    unlink(path);
+    rmdir(directory);
+    free(latencies);
+    return status;
+}
@@ -0,0 +1,99 @@
+/**
+ * Compare `RM_file_handler_borrow()` / `RM_file_handler_give_back()` with `open()` / `close()`.
+ *
+ * Usage: bench_rm_file [<number of iterations>]
+ *
+ * The files are created in a tmpfs directory ("/dev/shm" if it exists, "/tmp" otherwise), so that the measure
+ * is not dominated by the disk. Each iteration opens one of FILES_COUNT files (round robin) and reads its first byte.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_file.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define FILES_COUNT 16
+#define PATH_CAPACITY 256
+
+static double
+now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    char directory[PATH_CAPACITY];
+    char paths[FILES_COUNT][PATH_CAPACITY + 16];
+    double start, open_time, borrow_time;
+    size_t checksum_open = 0;
+    size_t checksum_borrow = 0;
+    int status = 1;
+    char c;
+
+    if (iterations <= 0) return 1;
+    memset(paths, 0, sizeof(paths));
+    snprintf(directory, PATH_CAPACITY, "%s/bench_rm_file-XXXXXX", 0 == access("/dev/shm", W_OK) ? "/dev/shm" : "/tmp");
+    if (NULL == mkdtemp(directory)) return 1;
+    for (int i = 0; i < FILES_COUNT; i++) {
+        int fd;
+        snprintf(paths[i], sizeof(paths[i]), "%s/file%02d", directory, i);
+        fd = open(paths[i], O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0) goto end;
+        c = (char)('a' + i);
+        if (1 != write(fd, &c, 1)) {
+            close(fd);
+            goto end;
+        }
+        close(fd);
+    }
+
+    start = now();
+    for (long i = 0; i < iterations; i++) {
+        int fd = open(paths[i % FILES_COUNT], O_RDONLY);
+        if ((fd < 0) || (1 != pread(fd, &c, 1, 0))) goto end;
+        checksum_open += (size_t)c;
+        close(fd);
+    }
+    open_time = now() - start;
+
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_file_handler_init(0, FILES_COUNT)) goto end;
+    start = now();
+    for (long i = 0; i < iterations; i++) {
+        int *fd;
+        if (RM_failure == RM_file_handler_borrow((void **) &fd, 1, __FILE__, __LINE__, (char *) __func__, RM_false,
+                                                 paths[i % FILES_COUNT], O_RDONLY)) goto end;
+        if (1 != pread(*fd, &c, 1, 0)) goto end;
+        checksum_borrow += (size_t)c;
+        RM_file_handler_give_back((void **) &fd, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    borrow_time = now() - start;
+    RM_file_handler_terminate();
+
+    if (checksum_open != checksum_borrow) {
+        printf("the checksums are different: %zu / %zu\n", checksum_open, checksum_borrow);
+        goto end;
+    }
+    printf("iterations: %ld on %d files in %s (checksum %zu)\n", iterations, FILES_COUNT, directory, checksum_open);
+    printf("open/close:        %8.1f ns/iteration\n", open_time * 1e9 / (double)iterations);
+    printf("borrow/give_back:  %8.1f ns/iteration (x%.1f)\n",
+           borrow_time * 1e9 / (double)iterations,
+           open_time / borrow_time);
+    status = 0;
+
+end:
+    RM_file_handler_terminate();
+    for (int i = 0; i < FILES_COUNT; i++) {
+        unlink(paths[i]);
+    }
+    rmdir(directory);
+    return status;
+}
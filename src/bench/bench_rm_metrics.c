@@ -0,0 +1,76 @@
+/**
+ * Measure the cost of the metrics (see "rm_metrics.h") on borrow / give back.
+ *
+ * Usage: bench_rm_metrics [<number of iterations>]
+ *
+ * Each iteration borrows a buffer and gives it back, with the metrics off, with the counters only (the default),
+ * and with the holding times. The report gives the time of an iteration, and the time taken by a snapshot.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_mem.h"
+#include "../resource_manager/rm_metrics.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define OBJECT_SIZE 64
+#define CAPACITY 16
+#define SNAPSHOTS_COUNT 1000
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+run(
+        const long in_iterations,
+        const RM_MetricsLevel in_level) {
+    void *buffer;
+    int64_t start;
+
+    RM_metrics_set_level(in_level);
+    start = now_ns();
+    for (long i = 0; i < in_iterations; i++) {
+        if (RM_failure == RM_mem_handler_borrow(&buffer, 1, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+            return -1;
+        }
+        RM_mem_handler_give_back(&buffer, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    const char *names[] = { "off", "counts", "timing" };
+    const RM_MetricsLevel levels[] = { RM_METRICS_OFF, RM_METRICS_COUNTS, RM_METRICS_TIMING };
+    RM_Metrics metrics;
+    int64_t start;
+    int status = 1;
+
+    if (iterations <= 0) return 1;
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_mem_handler_init(OBJECT_SIZE, CAPACITY)) return 1;
+    for (int i = 0; i < 3; i++) {
+        double ns = run(iterations, levels[i]);
+        if (ns < 0) goto end;
+        printf("%-6s %7.1f ns per borrow / give back\n", names[i], ns);
+    }
+
+    start = now_ns();
+    for (int i = 0; i < SNAPSHOTS_COUNT; i++) {
+        RM_metrics_snapshot(&metrics);
+    }
+    printf("snapshot %.1f us\n", (double)(now_ns() - start) / SNAPSHOTS_COUNT / 1e3);
+    RM_metrics_print(&metrics, stdout, RM_METRICS_TEXT);
+    status = 0;
+
+end:
+    RM_mem_handler_terminate();
+    return status;
+}
@@ -0,0 +1,145 @@
+/**
+ * Compare the lock-free pool (see "rm_pool.h") with a pool protected by a mutex, when several threads borrow and
+ * give back objects at the same time.
+ *
+ * Usage: bench_rm_pool [<number of borrow/give back per thread>]
+ *
+ * Each thread repeatedly takes an object from the pool, writes into it, and puts it back. The test is run with
+ * 1, 2, 4... threads, up to the number of online CPUs (at least 4). The throughput is the total number of
+ * borrow/give back pairs per second, for all the threads.
+ *
+ * Please note: with more threads than CPUs, the threads are interrupted while holding the mutex, which penalizes
+ * the mutex pool. The comparison is meaningful up to the number of CPUs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../resource_manager/rm_pool.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define MIN_THREADS_COUNT 4
+#define MAX_THREADS_COUNT 64
+#define OBJECT_SIZE 64
+#define CAPACITY 256
+
+// The pool protected by a mutex (this is how "rm_mem.c" used to manage its free buffers).
+static unsigned char   *MUTEX_POOL      = NULL;
+static uint32_t        *MUTEX_FREE_LIST = NULL;
+static size_t          MUTEX_FREE_COUNT = 0;
+static pthread_mutex_t MUTEX            = PTHREAD_MUTEX_INITIALIZER;
+
+static RM_Pool LOCK_FREE_POOL;
+
+struct Worker {
+    long iterations;
+    int  lock_free;
+    int  status;
+};
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void *
+mutex_pop() {
+    void *object = NULL;
+    pthread_mutex_lock(&MUTEX);
+    if (MUTEX_FREE_COUNT > 0) object = MUTEX_POOL + (size_t)MUTEX_FREE_LIST[--MUTEX_FREE_COUNT] * OBJECT_SIZE;
+    pthread_mutex_unlock(&MUTEX);
+    return object;
+}
+
+static void
+mutex_push(void *in_object) {
+    pthread_mutex_lock(&MUTEX);
+    MUTEX_FREE_LIST[MUTEX_FREE_COUNT++] = (uint32_t)((size_t)((unsigned char *) in_object - MUTEX_POOL) / OBJECT_SIZE);
+    pthread_mutex_unlock(&MUTEX);
+}
+
+static void *
+work(void *in_worker) {
+    struct Worker *worker = (struct Worker *) in_worker;
+
+    for (long i = 0; i < worker->iterations; i++) {
+        unsigned char *object = worker->lock_free
+                ? (unsigned char *) RM_pool_pop(&LOCK_FREE_POOL)
+                : (unsigned char *) mutex_pop();
+        if (NULL == object) {
+            worker->status = 1;
+            return NULL;
+        }
+        object[0] = (unsigned char) i;
+        if (worker->lock_free) {
+            if (RM_failure == RM_pool_push(&LOCK_FREE_POOL, object)) {
+                worker->status = 1;
+                return NULL;
+            }
+        } else {
+            mutex_push(object);
+        }
+    }
+    return NULL;
+}
+
+static double
+run(
+        const int in_threads_count,
+        const long in_iterations,
+        const int in_lock_free) {
+    struct Worker workers[MAX_THREADS_COUNT];
+    pthread_t threads[MAX_THREADS_COUNT];
+    int64_t start = now_ns();
+
+    for (int i = 0; i < in_threads_count; i++) {
+        workers[i].iterations = in_iterations;
+        workers[i].lock_free = in_lock_free;
+        workers[i].status = 0;
+        if (0 != pthread_create(&threads[i], NULL, work, &workers[i])) return -1;
+    }
+    for (int i = 0; i < in_threads_count; i++) {
+        pthread_join(threads[i], NULL);
+        if (0 != workers[i].status) return -1;
+    }
+    return (double) in_threads_count * (double) in_iterations / ((double)(now_ns() - start) / 1e9);
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = cpus > MIN_THREADS_COUNT ? (int) cpus : MIN_THREADS_COUNT;
+    int status = 1;
+
+    if (iterations <= 0) return 1;
+    if (max_threads > MAX_THREADS_COUNT) max_threads = MAX_THREADS_COUNT;
+    MUTEX_POOL = (unsigned char *) malloc(CAPACITY * OBJECT_SIZE);
+    MUTEX_FREE_LIST = (uint32_t *) malloc(CAPACITY * sizeof(uint32_t));
+    if ((NULL == MUTEX_POOL) || (NULL == MUTEX_FREE_LIST)) goto end;
+    for (uint32_t i = 0; i < CAPACITY; i++) {
+        MUTEX_FREE_LIST[MUTEX_FREE_COUNT++] = i;
+    }
+    if (RM_failure == RM_pool_init(&LOCK_FREE_POOL, OBJECT_SIZE, CAPACITY)) goto end;
+
+    printf("%ld online CPU(s)\n", cpus);
+    for (int threads_count = 1; threads_count <= max_threads; threads_count *= 2) {
+        double mutex = run(threads_count, iterations, 0);
+        double lock_free = run(threads_count, iterations, 1);
+        if ((mutex < 0) || (lock_free < 0)) goto end;
+        printf("%2d thread(s): mutex %12.0f ops/s | lock-free %12.0f ops/s | x%.2f\n",
+               threads_count, mutex, lock_free, lock_free / mutex);
+    }
+    status = 0;
+
+end:
+    RM_pool_terminate(&LOCK_FREE_POOL);
+    free(MUTEX_POOL);
+    free(MUTEX_FREE_LIST);
+    return status;
+}
@@ -0,0 +1,113 @@
+/**
+ * Measure the cost of the report file (see `RM_init()`) on the throughput of borrow / give back.
+ *
+ * Usage: bench_rm_report [<number of borrows per thread>]
+ *
+ * 4 threads borrow a buffer and give it back in a loop:
+ * - "none":     no report file.
+ * - "buffered": the report file is written by the buffered writer (see `RM_report_write()`).
+ * - "fopen":    no report file, but each operation opens the file, writes its record, and closes the file (this is
+ *               how the records were written before the buffered writer).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_mem.h"
+
+#define DEFAULT_ITERATIONS 20000
+#define THREADS_COUNT 4
+#define OBJECT_SIZE 64
+
+struct Worker {
+    long       iterations;
+    const char *fopen_path; // NULL: no per-record fopen()
+};
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+fopen_record(
+        const char *in_path,
+        const char *in_action,
+        void **in_ptr) {
+    FILE *fd = fopen(in_path, "a");
+    if (NULL == fd) return;
+    fprintf(fd, "%s mem +[%s] [%s]:%lud %p %p (%ld)\n", in_action, __func__, __FILE__, (unsigned long) __LINE__,
+            (void *) in_ptr, *in_ptr, 1L);
+    fclose(fd);
+}
+
+static void *
+work(void *in_worker) {
+    struct Worker *worker = (struct Worker *) in_worker;
+    void *buffer;
+
+    for (long i = 0; i < worker->iterations; i++) {
+        if (RM_failure == RM_mem_handler_borrow(&buffer, 1, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+            continue;
+        }
+        if (NULL != worker->fopen_path) fopen_record(worker->fopen_path, "B", &buffer);
+        if (NULL != worker->fopen_path) fopen_record(worker->fopen_path, "G", &buffer);
+        RM_mem_handler_give_back(&buffer, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    return NULL;
+}
+
+static int
+run(
+        const char *in_name,
+        const long in_iterations,
+        char *in_report_path,
+        const char *in_fopen_path) {
+    struct Worker workers[THREADS_COUNT];
+    pthread_t threads[THREADS_COUNT];
+    int64_t start;
+    double elapsed;
+
+    RM_init(-1, 0, in_report_path);
+    start = now_ns();
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        workers[i].iterations = in_iterations;
+        workers[i].fopen_path = in_fopen_path;
+        if (0 != pthread_create(&threads[i], NULL, work, &workers[i])) return 1;
+    }
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    RM_init(-1, 0, NULL); // the records are written before the timer stops
+    elapsed = (double)(now_ns() - start) / 1e9;
+    printf("%-8s %10.0f borrows/s\n", in_name, (double)(THREADS_COUNT * in_iterations) / elapsed);
+    return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    char directory[] = "/tmp/bench_rm_report-XXXXXX";
+    char path[64];
+    int status = 1;
+
+    if ((iterations <= 0) || (NULL == mkdtemp(directory))) return 1;
+    snprintf(path, sizeof(path), "%s/report.txt", directory);
+    if (RM_failure == RM_mem_handler_init(OBJECT_SIZE, THREADS_COUNT)) goto end;
+    if (0 != run("none", iterations, NULL, NULL)) goto end;
+    if (0 != run("buffered", iterations, path, NULL)) goto end;
+    unlink(path);
+    if (0 != run("fopen", iterations, NULL, path)) goto end;
+    status = 0;
+
+end:
+    RM_mem_handler_terminate();
+    unlink(path);
+    rmdir(directory);
+    return status;
+}
@@ -0,0 +1,124 @@
+/**
+ * Compare the ways of giving back the resources borrowed in a scope (see "rm_scope.h").
+ *
+ * Usage: bench_rm_scope [<number of iterations>]
+ *
+ * Each iteration borrows BORROWED_COUNT buffers, and gives them back:
+ * - explicitly, one by one;
+ * - through scoped variables (one call to `give_back()` per variable, when the block ends), if the compiler
+ *   supports them (see `RM_HAS_CLEANUP`);
+ * - through a frame (a single call to `give_back_many()` when the block ends).
+ * The metrics are off, and there is no report.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_mem.h"
+#include "../resource_manager/rm_metrics.h"
+#include "../resource_manager/rm_scope.h"
+
+#define DEFAULT_ITERATIONS 1000000
+#define OBJECT_SIZE 64
+#define CAPACITY 16
+#define BORROWED_COUNT 8
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+run_explicit(const long in_iterations) {
+    void *buffers[BORROWED_COUNT];
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        for (int j = 0; j < BORROWED_COUNT; j++) {
+            if (RM_failure == RM_mem_borrow(&buffers[j], 1, RM_false)) return -1;
+        }
+        for (int j = 0; j < BORROWED_COUNT; j++) {
+            RM_mem_give_back(&buffers[j], 2);
+        }
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+#if RM_HAS_CLEANUP
+
+static double
+run_scoped(const long in_iterations) {
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        void *b0 RM_SCOPED_MEM = NULL;
+        void *b1 RM_SCOPED_MEM = NULL;
+        void *b2 RM_SCOPED_MEM = NULL;
+        void *b3 RM_SCOPED_MEM = NULL;
+        void *b4 RM_SCOPED_MEM = NULL;
+        void *b5 RM_SCOPED_MEM = NULL;
+        void *b6 RM_SCOPED_MEM = NULL;
+        void *b7 RM_SCOPED_MEM = NULL;
+        if ((RM_failure == RM_mem_borrow(&b0, 1, RM_false)) || (RM_failure == RM_mem_borrow(&b1, 1, RM_false))
+            || (RM_failure == RM_mem_borrow(&b2, 1, RM_false)) || (RM_failure == RM_mem_borrow(&b3, 1, RM_false))
+            || (RM_failure == RM_mem_borrow(&b4, 1, RM_false)) || (RM_failure == RM_mem_borrow(&b5, 1, RM_false))
+            || (RM_failure == RM_mem_borrow(&b6, 1, RM_false)) || (RM_failure == RM_mem_borrow(&b7, 1, RM_false))) {
+            return -1;
+        }
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+#endif // RM_HAS_CLEANUP
+
+static double
+run_frame(const long in_iterations) {
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        int borrowed = 0;
+        RM_FRAME(frame) {
+            void *buffer;
+            for (; borrowed < BORROWED_COUNT; borrowed++) {
+                if (RM_failure == RM_frame_mem_borrow(&frame, &buffer, 1, RM_false)) break;
+            }
+        }
+        if (BORROWED_COUNT != borrowed) return -1;
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    double explicit;
+    double scoped = 0;
+    double frame;
+    int status = 1;
+
+    if (iterations <= 0) return 1;
+    RM_init(-1, 0, NULL);
+    RM_metrics_set_level(RM_METRICS_OFF);
+    if (RM_failure == RM_mem_handler_init(OBJECT_SIZE, CAPACITY)) return 1;
+
+    explicit = run_explicit(iterations);
+#if RM_HAS_CLEANUP
+    scoped = run_scoped(iterations);
+#endif
+    frame = run_frame(iterations);
+    if ((explicit < 0) || (scoped < 0) || (frame < 0)) goto end;
+    printf("%d buffers per scope\n", BORROWED_COUNT);
+    printf("explicit %7.1f ns per scope\n", explicit);
+#if RM_HAS_CLEANUP
+    printf("scoped   %7.1f ns per scope\n", scoped);
+#endif
+    printf("frame    %7.1f ns per scope\n", frame);
+    status = 0;
+
+end:
+    RM_mem_handler_terminate();
+    return status;
+}
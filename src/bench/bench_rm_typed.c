@@ -0,0 +1,105 @@
+/**
+ * Compare the cost of a borrow / give back through the variadic handler functions, through the table of
+ * handlers (as "pattern4.h" does), and through the typed macros (see `RM_mem_borrow()`).
+ *
+ * Usage: bench_rm_typed [<number of iterations>]
+ *
+ * Each iteration borrows a buffer and gives it back. The metrics are off, and there is no report: the figures
+ * show the cost of the calls and of the pool. The program "bench_rm_typed_notrace" is the same program, compiled
+ * with `RM_TRACE=0` (the typed macros do not pass the location of the calls).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_mem.h"
+#include "../resource_manager/rm_metrics.h"
+
+#define DEFAULT_ITERATIONS 5000000
+#define OBJECT_SIZE 64
+#define CAPACITY 16
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+run_varargs(const long in_iterations) {
+    void *buffer;
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        if (RM_failure == RM_mem_handler_borrow(&buffer, 1, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+            return -1;
+        }
+        RM_mem_handler_give_back(&buffer, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+static double
+run_table(
+        const long in_iterations,
+        const RM_ResourceHandler *in_handler) {
+    void *buffer;
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        if (RM_failure == in_handler->borrow(&buffer, 1, __FILE__, __LINE__, (char *) __func__, RM_false)) return -1;
+        in_handler->give_back(&buffer, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+static double
+run_typed(const long in_iterations) {
+    void *buffer;
+    int64_t start = now_ns();
+
+    for (long i = 0; i < in_iterations; i++) {
+        if (RM_failure == RM_mem_borrow(&buffer, 1, RM_false)) return -1;
+        RM_mem_give_back(&buffer, 2);
+    }
+    return (double)(now_ns() - start) / (double) in_iterations;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    // Volatile: the compiler must not turn the indirect calls into direct calls.
+    volatile RM_ResourceHandler handler = {
+            RM_mem_handler_init, RM_mem_handler_borrow, RM_mem_handler_give_back, RM_mem_handler_borrow_many,
+            RM_mem_handler_give_back_many, RM_mem_handler_terminate
+    };
+    RM_ResourceHandler table;
+    double varargs;
+    double indirect;
+    double typed;
+    int status = 1;
+
+    if (iterations <= 0) return 1;
+    RM_init(-1, 0, NULL);
+    RM_metrics_set_level(RM_METRICS_OFF);
+    if (RM_failure == RM_mem_handler_init(OBJECT_SIZE, CAPACITY)) return 1;
+    table = handler;
+
+    // Warm-up.
+    if (run_typed(iterations / 10 + 1) < 0) goto end;
+    varargs = run_varargs(iterations);
+    indirect = run_table(iterations, &table);
+    typed = run_typed(iterations);
+    if ((varargs < 0) || (indirect < 0) || (typed < 0)) goto end;
+    printf("tracing %s\n", RM_TRACE ? "on" : "off");
+    printf("varargs %6.1f ns per borrow / give back\n", varargs);
+    printf("table   %6.1f ns per borrow / give back\n", indirect);
+    printf("typed   %6.1f ns per borrow / give back (x%.2f)\n", typed, varargs / typed);
+    status = 0;
+
+end:
+    RM_mem_handler_terminate();
+    return status;
+}
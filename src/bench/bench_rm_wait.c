@@ -0,0 +1,113 @@
+/**
+ * Compare two ways of borrowing from an exhausted pool: retrying until a buffer is free ("spin"), and waiting
+ * in the queue of the handler (see `RM_mem_handler_borrow_timed()`).
+ *
+ * Usage: bench_rm_wait [<number of borrows per thread>]
+ *
+ * 8 threads share 2 buffers. Each thread borrows a buffer, keeps it for 50 us, and gives it back. The report
+ * gives the throughput and the CPU time consumed by the process, and the statistics of the wait queue.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "../resource_manager/resource_manager.h"
+#include "../resource_manager/rm_mem.h"
+
+#define DEFAULT_ITERATIONS 2000
+#define THREADS_COUNT 8
+#define CAPACITY 2
+#define OBJECT_SIZE 64
+#define HOLD_NS 50000
+
+struct Worker {
+    long iterations;
+    int  spin;
+};
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static double
+cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (double) usage.ru_utime.tv_sec + (double) usage.ru_utime.tv_usec / 1e6
+           + (double) usage.ru_stime.tv_sec + (double) usage.ru_stime.tv_usec / 1e6;
+}
+
+static void *
+work(void *in_worker) {
+    struct Worker *worker = (struct Worker *) in_worker;
+    struct timespec hold = { 0, HOLD_NS };
+    void *buffer;
+
+    for (long i = 0; i < worker->iterations; i++) {
+        if (worker->spin) {
+            while (RM_failure == RM_mem_handler_borrow(&buffer, 1, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+                sched_yield();
+            }
+        } else {
+            RM_mem_handler_borrow_timed(&buffer, RM_WAIT_FOREVER, 1, __FILE__, __LINE__, (char *) __func__, RM_false);
+        }
+        nanosleep(&hold, NULL);
+        RM_mem_handler_give_back(&buffer, 2, __FILE__, __LINE__, (char *) __func__);
+    }
+    return NULL;
+}
+
+static int
+run(
+        const char *in_name,
+        const long in_iterations,
+        const int in_spin) {
+    struct Worker workers[THREADS_COUNT];
+    pthread_t threads[THREADS_COUNT];
+    double cpu = cpu_seconds();
+    int64_t start = now_ns();
+    double elapsed;
+
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        workers[i].iterations = in_iterations;
+        workers[i].spin = in_spin;
+        if (0 != pthread_create(&threads[i], NULL, work, &workers[i])) return 1;
+    }
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    elapsed = (double)(now_ns() - start) / 1e9;
+    printf("%-5s %9.0f borrows/s, CPU time %6.3f s for %6.3f s elapsed\n",
+           in_name, (double)(THREADS_COUNT * in_iterations) / elapsed, cpu_seconds() - cpu, elapsed);
+    return 0;
+}
+
+int
+main(int argc, char *argv[]) {
+    long iterations = argc > 1 ? strtol(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+    RM_WaitStats stats;
+    int status = 1;
+
+    if (iterations <= 0) return 1;
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_mem_handler_init(OBJECT_SIZE, CAPACITY)) return 1;
+    if (0 != run("spin", iterations, 1)) goto end;
+    if (0 != run("wait", iterations, 0)) goto end;
+    RM_mem_handler_wait_stats(&stats);
+    printf("queue: %llu waits, mean wait %.1f us, max wait %.1f us, max depth %zu\n",
+           (unsigned long long) stats.waits,
+           0 == stats.waits ? 0.0 : (double) stats.total_wait_ns / (double) stats.waits / 1e3,
+           (double) stats.max_wait_ns / 1e3,
+           stats.max_depth);
+    status = 0;
+
+end:
+    RM_mem_handler_terminate();
+    return status;
+}
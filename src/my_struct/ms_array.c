@@ -0,0 +1,60 @@
+/**
+ * Allocate and free arrays of structures (see "pattern1.c").
+ *
+ * Synopsis:
+ *
+ *      struct my_struct **array = NULL;
+ *      if (MS_failure == malloc_array_of_struct(&array, capacity)) { ... }
+ *      // ...
+ *      free_array_of_struct(&array, capacity);
+ */
+
+#include <stdlib.h>
+#include "ms_array.h"
+
+/**
+ * @brief Free the resources allocated for a given array.
+ * @note You can call this function multiple times on the same pointer.
+ *       Elements set to NULL are skipped.
+ * @param in_out_prt Pointer to the array.
+ * @param in_capacity The array capacity.
+ */
+
+void
+free_array_of_struct(
+        struct my_struct ***in_out_prt,
+        const size_t in_capacity) {
+    if (NULL == *in_out_prt) return;
+    for (size_t i=0; i<in_capacity; i++) {
+        if (NULL == (*in_out_prt)[i]) continue;
+        free((*in_out_prt)[i]);
+        (*in_out_prt)[i] = NULL;
+    }
+    free(*in_out_prt);
+    *in_out_prt = NULL;
+}
+
+/**
+ * @brief Allocate resources for an array.
+ * @param in_out_ptr Address of a pointer used to store that address of the memory location allocated for the array.
+ * @param in_capacity The required capacity.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ */
+
+MS_Status
+malloc_array_of_struct(
+        struct my_struct ***in_out_ptr,
+        const size_t in_capacity) {
+    *in_out_ptr = (struct my_struct**) malloc(sizeof(struct my_struct*) * in_capacity);
+    if (NULL == *in_out_ptr) return MS_failure;
+    for (size_t i=0; i<in_capacity; i++) {
+        (*in_out_ptr)[i] = (struct my_struct*) malloc(sizeof(struct my_struct));
+        if (NULL == (*in_out_ptr)[i]) {
+            // Free all previously allocated memory.
+            free_array_of_struct(in_out_ptr,
+                                 i);
+            return MS_failure;
+        }
+    }
+    return MS_success;
+}
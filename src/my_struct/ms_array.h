@@ -0,0 +1,24 @@
+#ifndef C_PATTERNS_MS_ARRAY_H
+#define C_PATTERNS_MS_ARRAY_H
+
+#include <stddef.h>
+#include "my_struct.h"
+
+// Allocation of arrays of structures, as described by the pattern 1 (see "pattern1.c").
+//
+//      struct my_struct **array = NULL;
+//      if (MS_failure == malloc_array_of_struct(&array, capacity)) { ... }
+//      // ...
+//      free_array_of_struct(&array, capacity);
+
+void
+free_array_of_struct(
+        struct my_struct ***in_out_prt,
+        size_t in_capacity);
+
+MS_Status
+malloc_array_of_struct(
+        struct my_struct ***in_out_ptr,
+        size_t in_capacity);
+
+#endif //C_PATTERNS_MS_ARRAY_H
@@ -0,0 +1,382 @@
+/**
+ * Export an array of structures (as allocated by the patterns 1 and 2) in bulk.
+ *
+ * Printing each element with `printf()` is slow: every call parses the format string and goes
+ * through the stdio machinery. Here, the rows are formatted into large buffers (using a dedicated
+ * integer-to-ascii routine), and the buffers are written using a few big calls to `writev()`.
+ *
+ * The CSV rows are formatted into two buffers, one after the other: when both are full, they are
+ * written by a single call to `writev()`. An integer is converted without a loop: its 8 last digits
+ * are computed at once (within a 64 bits word), and the right number of bytes is selected by shifting.
+ *
+ * Synopsis:
+ *
+ *      struct my_struct **array = NULL;
+ *      malloc_array_of_struct(&array, capacity);
+ *      // ...
+ *      if (MS_failure == MS_export_csv(STDOUT_FILENO, array, capacity)) { ... }
+ *      if (MS_failure == MS_export_binary(fd, array, capacity)) { ... }
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "ms_export.h"
+
+// Maximum number of bytes for one CSV row: "-2147483648,-2147483648\n". Formatting a number may write past its
+// end (see `MS_format_int()`), but not past the end of this space.
+#define CSV_ROW_MAX_LENGTH 24
+
+// Size of each of the two buffers used by the CSV export.
+#define CSV_BUFFER_CAPACITY (MS_EXPORT_BUFFER_CAPACITY / 2)
+
+// The integers are converted 8 digits at once by storing them as a single 64 bits word (see `MS_format_int()`).
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define FORMAT_WORDS 1
+#else
+#define FORMAT_WORDS 0
+#endif
+
+// Number of bytes for one binary row: the two integers, as they are stored in memory.
+#define BINARY_ROW_LENGTH (2 * sizeof(int32_t))
+
+// All the numbers from 0 to 99, written with 2 digits.
+// This table allows us to convert 2 digits at once.
+static const char DIGIT_PAIRS[201] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+#if FORMAT_WORDS
+
+/**
+ * @brief Return 2 digits, as stored in memory.
+ * @param in_value The value of the digits (less than 100).
+ */
+
+static inline uint16_t
+digit_pair(
+        const uint32_t in_value) {
+    uint16_t pair;
+    memcpy(&pair, DIGIT_PAIRS + 2 * in_value, sizeof(pair));
+    return pair;
+}
+
+/**
+ * @brief Return the values of the 8 digits of an integer, one per byte (the first digit in the lowest byte).
+ * @param in_value The integer (less than 100000000). The leading zeros are included.
+ * @note The digits are computed in parallel, within a 64 bits word: the value is split into 2 lanes of 4 digits,
+ * then 4 lanes of 2 digits, then 8 lanes of 1 digit. A division of a lane is a multiplication and a shift
+ * (`x / 100 == (x * 10486) >> 20` for `x < 10000`, and `x / 10 == (x * 103) >> 10` for `x < 100`).
+ */
+
+static inline uint64_t
+eight_digits(
+        const uint32_t in_value) {
+    // `q | (x - q * d) << w` is computed as `(x << w) + q * (1 - (d << w))`: a single multiplication (modulo 2^64,
+    // the lanes do not overlap).
+    const uint64_t thousands = in_value / 10000u;
+    const uint64_t halves = ((uint64_t) in_value << 32) + thousands * (1u - (10000ULL << 32));
+    const uint64_t hundreds = ((halves * 10486u) >> 20) & 0x0000007F0000007FULL;
+    const uint64_t pairs = (halves << 16) + hundreds * (1u - (100ULL << 16));
+    const uint64_t tens = ((pairs * 103u) >> 10) & 0x000F000F000F000FULL;
+    return (pairs << 8) + tens * (1u - (10ULL << 8));
+}
+
+/**
+ * @brief Write the decimal representation of an integer (see `MS_format_int()`).
+ * @note Below 100000000, the leading zeros are counted from the digits themselves (the lowest bytes equal to
+ * zero), and dropped by shifting the digits. The values that have 9 or 10 digits (rare in practice, thus the
+ * branch is well predicted) have a head of 1 or 2 digits, followed by 8 digits.
+ */
+
+static inline char *
+format_int(
+        char *in_out,
+        const int in_value) {
+    const uint32_t negative = (uint32_t)(in_value < 0);
+    const uint32_t value = negative ? 0u - (uint32_t)in_value : (uint32_t)in_value; // works for INT_MIN
+    uint64_t digits;
+
+    // Always write the sign. It is overwritten if the value is positive.
+    *in_out = '-';
+    in_out += negative;
+    if (value < 100000000u) {
+        // The last digit is always written (even if the value is 0).
+        const unsigned int zeros = (unsigned int) __builtin_ctzll(eight_digits(value) | (1ULL << 56)) / 8;
+        digits = (eight_digits(value) | 0x3030303030303030ULL) >> (8 * zeros);
+        memcpy(in_out, &digits, sizeof(digits));
+        return in_out + 8 - zeros;
+    } else {
+        const uint32_t head = value / 100000000u;
+        const size_t head_length = head >= 10u ? 2 : 1;
+        const uint16_t head_digits = (uint16_t)((uint32_t)digit_pair(head) >> (8 * (2 - head_length)));
+        memcpy(in_out, &head_digits, sizeof(head_digits));
+        digits = eight_digits(value - head * 100000000u) | 0x3030303030303030ULL;
+        memcpy(in_out + head_length, &digits, sizeof(digits));
+        return in_out + head_length + 8;
+    }
+}
+
+/**
+ * @brief Write the decimal representation of an integer.
+ * @param in_out Pointer to the location where the representation is written.
+ * There must be at least 11 bytes available (the bytes that follow the representation may be overwritten).
+ * @param in_value The integer to write.
+ * @return A pointer to the byte that follows the last written character.
+ * @note The representation is not zero terminated.
+ */
+
+char *
+MS_format_int(
+        char *in_out,
+        const int in_value) {
+    return format_int(in_out, in_value);
+}
+
+#else
+
+/**
+ * @brief Return the number of digits of a given unsigned integer.
+ * @param in_value The integer.
+ * @return The number of digits.
+ * @note There is no branch: each comparison evaluates to 0 or 1.
+ */
+
+static size_t
+u32_length(
+        const uint32_t in_value) {
+    return (size_t)(1
+           + (in_value >= 10u)
+           + (in_value >= 100u)
+           + (in_value >= 1000u)
+           + (in_value >= 10000u)
+           + (in_value >= 100000u)
+           + (in_value >= 1000000u)
+           + (in_value >= 10000000u)
+           + (in_value >= 100000000u)
+           + (in_value >= 1000000000u));
+}
+
+/**
+ * @brief Write the decimal representation of an integer.
+ * @param in_out Pointer to the location where the representation is written.
+ * There must be at least 11 bytes available (the bytes that follow the representation may be overwritten).
+ * @param in_value The integer to write.
+ * @return A pointer to the byte that follows the last written character.
+ * @note The representation is not zero terminated.
+ */
+
+char *
+MS_format_int(
+        char *in_out,
+        const int in_value) {
+    uint32_t value = (uint32_t)in_value;
+    size_t length;
+    char *p;
+
+    // Always write the sign. It will be overwritten if the value is positive.
+    *in_out = '-';
+    if (in_value < 0) {
+        in_out += 1;
+        value = 0u - value; // works for INT_MIN.
+    }
+
+    length = u32_length(value);
+    p = in_out + length;
+
+    // Write the digits from the last one to the first one, 2 digits at a time.
+    while (value >= 100u) {
+        const uint32_t quotient = value / 100u;
+        const uint32_t index = (value - quotient * 100u) * 2u;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[index];
+        p[1] = DIGIT_PAIRS[index + 1];
+        value = quotient;
+    }
+    if (value >= 10u) {
+        p -= 2;
+        p[0] = DIGIT_PAIRS[value * 2u];
+        p[1] = DIGIT_PAIRS[value * 2u + 1];
+    } else {
+        p[-1] = (char)('0' + value);
+    }
+    return in_out + length;
+}
+
+#define format_int MS_format_int
+
+#endif // FORMAT_WORDS
+
+/**
+ * @brief Write all the bytes of a buffer into a file.
+ * @param in_fd The file descriptor.
+ * @param in_buffer The buffer.
+ * @param in_length The number of bytes to write.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ * @note `write()` may write less bytes than requested, or be interrupted by a signal.
+ */
+
+static MS_Status
+write_all(
+        const int in_fd,
+        const char *in_buffer,
+        size_t in_length) {
+    while (in_length > 0) {
+        ssize_t bytes_written = write(in_fd, in_buffer, in_length);
+        if (bytes_written < 0) {
+            if (EINTR == errno) continue;
+            return MS_failure;
+        }
+        in_buffer += bytes_written;
+        in_length -= (size_t)bytes_written;
+    }
+    return MS_success;
+}
+
+/**
+ * @brief Write all the bytes of a set of buffers into a file.
+ * @param in_fd The file descriptor.
+ * @param in_vectors The buffers. They are modified (see the note).
+ * @param in_count The number of buffers.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ * @note `writev()` may write less bytes than requested: the vectors are advanced past the bytes written.
+ */
+
+static MS_Status
+writev_all(
+        const int in_fd,
+        struct iovec *in_vectors,
+        int in_count) {
+    while (in_count > 0) {
+        ssize_t bytes_written = writev(in_fd, in_vectors, in_count);
+        size_t remaining;
+        if (bytes_written < 0) {
+            if (EINTR == errno) continue;
+            return MS_failure;
+        }
+        remaining = (size_t)bytes_written;
+        while ((in_count > 0) && (remaining >= in_vectors->iov_len)) {
+            remaining -= in_vectors->iov_len;
+            in_vectors++;
+            in_count--;
+        }
+        if (in_count > 0) {
+            in_vectors->iov_base = (char *) in_vectors->iov_base + remaining;
+            in_vectors->iov_len -= remaining;
+        }
+    }
+    return MS_success;
+}
+
+/**
+ * @brief Export an array of structures using the CSV format.
+ * @param in_fd Descriptor of the file to write into.
+ * @param in_array The array to export. The array may contain NULL elements: they are skipped.
+ * @param in_capacity The array capacity.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ */
+
+MS_Status
+MS_export_csv(
+        const int in_fd,
+        struct my_struct **in_array,
+        const size_t in_capacity) {
+    char *buffers[2];
+    struct iovec vectors[2];
+    int current = 0;
+    char *p;
+    char *limit;
+    MS_Status status = MS_success;
+
+    if (NULL == in_array) return MS_failure;
+    buffers[0] = (char *) malloc(2 * CSV_BUFFER_CAPACITY);
+    if (NULL == buffers[0]) return MS_failure;
+    buffers[1] = buffers[0] + CSV_BUFFER_CAPACITY;
+
+    memcpy(buffers[0], MS_EXPORT_CSV_HEADER, sizeof(MS_EXPORT_CSV_HEADER) - 1);
+    p = buffers[0] + sizeof(MS_EXPORT_CSV_HEADER) - 1;
+    limit = buffers[0] + CSV_BUFFER_CAPACITY - CSV_ROW_MAX_LENGTH;
+
+    for (size_t i = 0; i < in_capacity; i++) {
+        if (NULL == in_array[i]) continue;
+        p = format_int(p, in_array[i]->a);
+        *p++ = ',';
+        p = format_int(p, in_array[i]->b);
+        *p++ = '\n';
+        if (p <= limit) continue;
+
+        // The buffer is full: fill the other one, or write both.
+        vectors[current].iov_base = buffers[current];
+        vectors[current].iov_len = (size_t)(p - buffers[current]);
+        if (1 == current) {
+            if (MS_failure == (status = writev_all(in_fd, vectors, 2))) break;
+        }
+        current = 1 - current;
+        p = buffers[current];
+        limit = buffers[current] + CSV_BUFFER_CAPACITY - CSV_ROW_MAX_LENGTH;
+    }
+
+    if (MS_success == status) {
+        vectors[current].iov_base = buffers[current];
+        vectors[current].iov_len = (size_t)(p - buffers[current]);
+        status = writev_all(in_fd, vectors, current + 1);
+    }
+    free(buffers[0]);
+    return status;
+}
+
+/**
+ * @brief Export an array of structures using a binary format.
+ *
+ * Each element is written as two 32 bits integers (`a` then `b`), using the byte order of the host.
+ *
+ * @param in_fd Descriptor of the file to write into.
+ * @param in_array The array to export. The array may contain NULL elements: they are skipped.
+ * @param in_capacity The array capacity.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ */
+
+MS_Status
+MS_export_binary(
+        const int in_fd,
+        struct my_struct **in_array,
+        const size_t in_capacity) {
+    char *buffer;
+    char *p;
+    char *limit;
+
+    if (NULL == in_array) return MS_failure;
+    buffer = (char *) malloc(MS_EXPORT_BUFFER_CAPACITY);
+    if (NULL == buffer) return MS_failure;
+
+    p = buffer;
+    limit = buffer + MS_EXPORT_BUFFER_CAPACITY - BINARY_ROW_LENGTH;
+
+    for (size_t i = 0; i < in_capacity; i++) {
+        int32_t row[2];
+
+        if (NULL == in_array[i]) continue;
+        if (p > limit) {
+            if (MS_failure == write_all(in_fd, buffer, (size_t)(p - buffer))) {
+                free(buffer);
+                return MS_failure;
+            }
+            p = buffer;
+        }
+        row[0] = (int32_t)in_array[i]->a;
+        row[1] = (int32_t)in_array[i]->b;
+        memcpy(p, row, BINARY_ROW_LENGTH);
+        p += BINARY_ROW_LENGTH;
+    }
+
+    if (MS_failure == write_all(in_fd, buffer, (size_t)(p - buffer))) {
+        free(buffer);
+        return MS_failure;
+    }
+    free(buffer);
+    return MS_success;
+}
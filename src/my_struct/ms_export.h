@@ -0,0 +1,31 @@
+#ifndef C_PATTERNS_MS_EXPORT_H
+#define C_PATTERNS_MS_EXPORT_H
+
+#include <stddef.h>
+#include "my_struct.h"
+
+// Size of the memory used to format the rows before they are written (the CSV export splits it into two buffers).
+// The bigger the buffer, the fewer calls to `write()` and `writev()`.
+#define MS_EXPORT_BUFFER_CAPACITY (1024 * 1024)
+
+// Header of the CSV export.
+#define MS_EXPORT_CSV_HEADER "a,b\n"
+
+MS_Status
+MS_export_csv(
+        int in_fd,
+        struct my_struct **in_array,
+        size_t in_capacity);
+
+MS_Status
+MS_export_binary(
+        int in_fd,
+        struct my_struct **in_array,
+        size_t in_capacity);
+
+char *
+MS_format_int(
+        char *in_out,
+        int in_value);
+
+#endif //C_PATTERNS_MS_EXPORT_H
@@ -0,0 +1,214 @@
+/**
+ * Persist an array of structures between runs, using a memory-mapped file.
+ *
+ * The file contains a header (magic, version, element size and capacity) followed by the elements.
+ * The magic is written by the first checkpoint, after the elements: a file that was not completely
+ * filled (the program stopped during the cold start) is rejected.
+ * Opening an existing array does not read (or initialize) anything: the file is mapped into memory
+ * and the pages are loaded lazily by the kernel, when they are accessed for the first time.
+ *
+ * Synopsis:
+ *
+ *      MS_MappedArray array;
+ *
+ *      MS_mapped_array_init(&array);
+ *      if (MS_failure == MS_mapped_array_open(&array, path)) {
+ *          // Cold start: create the array and fill it.
+ *          if (MS_failure == MS_mapped_array_create(&array, path, capacity)) { ... }
+ *          for (size_t i = 0; i < array.capacity; i++) { array.elements[i].a = ...; }
+ *          if (MS_failure == MS_mapped_array_checkpoint(&array, MS_true)) { ... }
+ *      }
+ *      // Warm start: the elements are ready to use.
+ *      ...
+ *      MS_mapped_array_close(&array);
+ *      MS_mapped_array_close(&array); // it does not harm
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ms_persist.h"
+
+/**
+ * @brief Map an opened file into memory.
+ * @param in_array The array.
+ * @param in_size The size of the file.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ */
+
+static MS_Status
+map_file(
+        MS_MappedArray *in_array,
+        const size_t in_size) {
+    void *address = mmap(NULL,
+                         in_size,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED,
+                         in_array->fd,
+                         0);
+    if (MAP_FAILED == address) return MS_failure;
+    in_array->mapping_size = in_size;
+    in_array->header       = (struct MS_StructPersistHeader *) address;
+    in_array->elements     = (struct my_struct *) ((char *) address + MS_PERSIST_HEADER_SIZE);
+    return MS_success;
+}
+
+/**
+ * @brief Initialize a mapped array.
+ * @param in_array The array.
+ * @note You can call `MS_mapped_array_close()` on an array that has just been initialized.
+ */
+
+void
+MS_mapped_array_init(
+        MS_MappedArray *in_array) {
+    in_array->fd           = -1;
+    in_array->mapping_size = 0;
+    in_array->header       = NULL;
+    in_array->elements     = NULL;
+    in_array->capacity     = 0;
+}
+
+/**
+ * @brief Create a new array (if the file already exists, then it is overwritten).
+ * @param in_array The array.
+ * @param in_path Path to the file.
+ * @param in_capacity The number of elements.
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ * @note The file is created sparse: the elements are all zeros, and no disk space is used until
+ * they are modified.
+ * @note The array is incomplete until the first call to `MS_mapped_array_checkpoint()`: if the program
+ * stops before, then the file is rejected by `MS_mapped_array_open()`.
+ */
+
+MS_Status
+MS_mapped_array_create(
+        MS_MappedArray *in_array,
+        const char *in_path,
+        const size_t in_capacity) {
+    size_t size;
+
+    MS_mapped_array_init(in_array);
+    if (in_capacity > (SIZE_MAX - MS_PERSIST_HEADER_SIZE) / sizeof(struct my_struct)) return MS_failure;
+    size = MS_PERSIST_HEADER_SIZE + in_capacity * sizeof(struct my_struct);
+
+    in_array->fd = open(in_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (in_array->fd < 0) return MS_failure;
+    if ((0 != ftruncate(in_array->fd, (off_t)size)) || (MS_failure == map_file(in_array, size))) {
+        MS_mapped_array_close(in_array);
+        return MS_failure;
+    }
+
+    // The magic is not written here: it is written by `MS_mapped_array_checkpoint()`, once the elements
+    // are on disk. Until then, the file is rejected by `MS_mapped_array_open()`.
+    in_array->header->version      = MS_PERSIST_VERSION;
+    in_array->header->element_size = (uint32_t)sizeof(struct my_struct);
+    in_array->header->capacity     = (uint64_t)in_capacity;
+    in_array->capacity = in_capacity;
+    return MS_success;
+}
+
+/**
+ * @brief Open an existing array.
+ * @param in_array The array.
+ * @param in_path Path to the file.
+ * @return On success `MS_success`. Otherwise `MS_failure`: the file does not exist, or it has not been
+ * created by `MS_mapped_array_create()` (with the same version of the structure).
+ * @note The cost does not depend on the capacity of the array.
+ */
+
+MS_Status
+MS_mapped_array_open(
+        MS_MappedArray *in_array,
+        const char *in_path) {
+    struct stat info;
+    struct MS_StructPersistHeader *header;
+
+    MS_mapped_array_init(in_array);
+    in_array->fd = open(in_path, O_RDWR);
+    if (in_array->fd < 0) return MS_failure;
+    if ((0 != fstat(in_array->fd, &info)) || (info.st_size < MS_PERSIST_HEADER_SIZE)) {
+        MS_mapped_array_close(in_array);
+        return MS_failure;
+    }
+    if (MS_failure == map_file(in_array, (size_t)info.st_size)) {
+        MS_mapped_array_close(in_array);
+        return MS_failure;
+    }
+
+    header = in_array->header;
+    if ((0 != memcmp(header->magic, MS_PERSIST_MAGIC, sizeof(MS_PERSIST_MAGIC)))
+        || (MS_PERSIST_VERSION != header->version)
+        || (sizeof(struct my_struct) != header->element_size)
+        || (header->capacity > ((uint64_t)info.st_size - MS_PERSIST_HEADER_SIZE) / sizeof(struct my_struct))) {
+        MS_mapped_array_close(in_array);
+        return MS_failure;
+    }
+    in_array->capacity = (size_t)header->capacity;
+    return MS_success;
+}
+
+/**
+ * @brief Write the modified pages of the array back to the file.
+ * @param in_array The array.
+ * @param in_wait Flag that tells whether the function must wait for the data to be written.
+ * - MS_true: the function returns when the data is written (`MS_SYNC`).
+ * - MS_false: the writing is only scheduled (`MS_ASYNC`).
+ * @return On success `MS_success`. Otherwise `MS_failure`.
+ * @note The first checkpoint of a new array marks it as complete. The elements are written first (always
+ * with `MS_SYNC`), then the magic, and then the header page. Thus, the magic never reaches the disk
+ * before the elements.
+ */
+
+MS_Status
+MS_mapped_array_checkpoint(
+        MS_MappedArray *in_array,
+        const MS_Bool in_wait) {
+    if (NULL == in_array->header) return MS_failure;
+    if (0 == memcmp(in_array->header->magic, MS_PERSIST_MAGIC, sizeof(MS_PERSIST_MAGIC))) {
+        if (0 != msync((void *) in_array->header,
+                       in_array->mapping_size,
+                       in_wait ? MS_SYNC : MS_ASYNC)) {
+            return MS_failure;
+        }
+        return MS_success;
+    }
+
+    // The array is not complete yet.
+    if ((in_array->mapping_size > MS_PERSIST_HEADER_SIZE)
+        && (0 != msync((void *) in_array->elements,
+                       in_array->mapping_size - MS_PERSIST_HEADER_SIZE,
+                       MS_SYNC))) {
+        return MS_failure;
+    }
+    memcpy(in_array->header->magic, MS_PERSIST_MAGIC, sizeof(MS_PERSIST_MAGIC));
+    if (0 != msync((void *) in_array->header,
+                   MS_PERSIST_HEADER_SIZE,
+                   in_wait ? MS_SYNC : MS_ASYNC)) {
+        return MS_failure;
+    }
+    return MS_success;
+}
+
+/**
+ * @brief Close an array.
+ * @param in_array The array.
+ * @note The modifications are not lost: the kernel writes them back to the file eventually.
+ * Call `MS_mapped_array_checkpoint()` first if you need them to be on disk.
+ * @note Please note that you can call this function multiple times on the same array.
+ */
+
+void
+MS_mapped_array_close(
+        MS_MappedArray *in_array) {
+    if (NULL != in_array->header) {
+        munmap((void *) in_array->header, in_array->mapping_size);
+    }
+    if (in_array->fd >= 0) {
+        close(in_array->fd);
+    }
+    MS_mapped_array_init(in_array);
+}
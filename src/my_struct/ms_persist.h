@@ -0,0 +1,62 @@
+#ifndef C_PATTERNS_MS_PERSIST_H
+#define C_PATTERNS_MS_PERSIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "my_struct.h"
+
+#define MS_PERSIST_MAGIC "MSARRAY"
+#define MS_PERSIST_VERSION 1
+// The elements start on a page boundary.
+#define MS_PERSIST_HEADER_SIZE 4096
+
+/**
+ * Header stored at the beginning of the file.
+ */
+
+struct MS_StructPersistHeader {
+    char     magic[8];      // MS_PERSIST_MAGIC (zero terminated)
+    uint32_t version;       // MS_PERSIST_VERSION
+    uint32_t element_size;  // sizeof(struct my_struct)
+    uint64_t capacity;      // number of elements
+};
+
+/**
+ * Array of structures backed by a memory-mapped file.
+ */
+
+struct MS_StructMappedArray {
+    int                           fd;
+    size_t                        mapping_size;
+    struct MS_StructPersistHeader *header;
+    struct my_struct              *elements; // `capacity` contiguous elements
+    size_t                        capacity;
+};
+
+typedef struct MS_StructMappedArray MS_MappedArray;
+
+void
+MS_mapped_array_init(
+        MS_MappedArray *in_array);
+
+MS_Status
+MS_mapped_array_create(
+        MS_MappedArray *in_array,
+        const char *in_path,
+        size_t in_capacity);
+
+MS_Status
+MS_mapped_array_open(
+        MS_MappedArray *in_array,
+        const char *in_path);
+
+MS_Status
+MS_mapped_array_checkpoint(
+        MS_MappedArray *in_array,
+        MS_Bool in_wait);
+
+void
+MS_mapped_array_close(
+        MS_MappedArray *in_array);
+
+#endif //C_PATTERNS_MS_PERSIST_H
@@ -0,0 +1,17 @@
+#ifndef C_PATTERNS_MY_STRUCT_H
+#define C_PATTERNS_MY_STRUCT_H
+
+// This is the structure used by the patterns 1 and 2 (see "pattern1.c" and "pattern2.c").
+// The layout must stay the same: two `int`, no padding.
+
+enum MS_EnumStatus { MS_failure, MS_success };
+enum MS_EnumBool { MS_true=1, MS_false=0 };
+typedef enum MS_EnumStatus MS_Status;
+typedef enum MS_EnumBool MS_Bool;
+
+struct my_struct {
+    int a;
+    int b;
+};
+
+#endif //C_PATTERNS_MY_STRUCT_H
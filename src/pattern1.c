@@ -13,6 +13,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include "my_struct/my_struct.h"
+#include "my_struct/ms_export.h"
 
 #define EXIT_SUCCESS 0
 #define EXIT_ERROR 1
@@ -20,11 +23,6 @@
 enum EnumStatus { failure, success };
 typedef enum EnumStatus Status;
 
-struct my_struct {
-    int a;
-    int b;
-};
-
 /**
  * @brief Free the resources allocated for a given array.
  * @note Please note that you can call this function multiple times on the same pointer.
@@ -103,11 +101,14 @@ test() {
         array_of_struct[i]->b = i * 10;
     }
 
-    // Print the array.
-    for (int i = 0; i < CAPACITY; i++) {
-        printf("(%d, %d)\n",
-               array_of_struct[i]->a,
-               array_of_struct[i]->b);
+    // Print the array, in bulk (see "my_struct/ms_export.c"). The output of `printf()` is flushed first.
+    fflush(stdout);
+    if (MS_failure == MS_export_csv(STDOUT_FILENO,
+                                    array_of_struct,
+                                    CAPACITY)) {
+        free_array_of_struct(&array_of_struct,
+                             CAPACITY);
+        return failure;
     }
 
     // Free all allocated resources.
@@ -3,179 +3,376 @@
  *
  * - the error is identified by an (hopefully unique) integer.
  * - the error message includes the precise location (in the source code) where the error was thrown.
+ *
+ * The implementation is in "pattern3/last_error.c". The last error is stored per thread.
+ * The errors are declared in a catalogue (see "pattern3/errors.h").
  */
 
 #include <stdio.h>
-#include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pattern3/last_error.h"
+#include "pattern3/error_history.h"
+#include "pattern3/error_stats.h"
+#include "pattern3/error_sink.h"
 
-#define EXIT_SUCCESS 0
-#define EXIT_ERROR 1
-#define LAST_ERROR_MESSAGE_BUFFER_CAPACITY 128 // should be bigger in real life
-#define LAST_ERROR_FILE_BUFFER_CAPACITY 2048
+// Declare the errors used by this file. See "pattern3/errors.h".
+#define ERRORS_TYPES \
+DECLARE(EFunction1, ErrorSeverityError,   "This is the error #%d in %s") \
+DECLARE(EFunction2, ErrorSeverityWarning, "This is the error #%d in %s") \
+DECLARE(ETooLong,   ErrorSeverityError,   "This is too long #%d in %s (data: %s)") \
+DECLARE(ENotFound,  ErrorSeverityInfo,    "The resource was not found") \
+DECLARE(EFlood,     ErrorSeverityWarning, "Flood #%d")
 
-enum EnumStatus { failure, success };
-typedef enum EnumStatus Status;
+#include "pattern3/errors.h"
 
-static int  LAST_ERROR_ID;
-static char LAST_ERROR_FILE[LAST_ERROR_FILE_BUFFER_CAPACITY];
-static int  LAST_ERROR_LINE;
-static char LAST_ERROR_MESSAGE[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+#define THREADS_COUNT 16
+#define THREAD_ITERATIONS 20000
 
-/**
- * @brief Initialize the last error.
- */
+Status
+function1() {
+    return ERROR_SET(EFunction1,
+                     1,
+                     __func__);
+}
 
-void
-last_error_init() {
-    LAST_ERROR_ID = -1;
-    LAST_ERROR_MESSAGE[0] = 0;
+Status
+function2() {
+    return ERROR_SET(EFunction2,
+                     2,
+                     __func__);
 }
 
-/**
- * @brief Return the ID of the last error.
- * @return The ID of the last error.
- */
+Status
+function_fail() {
+    // Create a string that will be too big...
+    char data[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+    memset((void *) data,
+           '.',
+           LAST_ERROR_MESSAGE_BUFFER_CAPACITY);
+    data[LAST_ERROR_MESSAGE_BUFFER_CAPACITY - 1] = 0;
 
-int
-last_error_get_id() {
-    return LAST_ERROR_ID;
+    return ERROR_SET(ETooLong,
+                     3,
+                     __func__,
+                     data);
+}
+
+Status
+function_not_found() {
+    // The format does not need any argument: nothing is formatted.
+    return ERROR_SET0(ENotFound);
+}
+
+Status
+test_formats() {
+    char expected[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+    char text[] = "text";
+    int line;
+
+    // The message is formatted when it is read: the arguments must be copied.
+    line = __LINE__; last_error_set(1000, __FILE__, line, __func__,
+                                    "%5.2f|%-6s|%x|%lld|%c|%*d|%.*s|%hhd|%zu|%%",
+                                    3.14159, text, 255u, -5LL, 'z', 4, 7, 2, text, 300, (size_t)12);
+    strcpy(text, "XXXX");
+    snprintf(expected,
+             LAST_ERROR_MESSAGE_BUFFER_CAPACITY,
+             "#%010d [%s:%d %s()] %5.2f|%-6s|%x|%lld|%c|%*d|%.*s|%hhd|%zu|%%",
+             1000, __FILE__, line, __func__,
+             3.14159, "text", 255u, -5LL, 'z', 4, 7, 2, "text", 300, (size_t)12);
+    printf("message: [%s]\n", last_error_get_message());
+    if (0 != strcmp(expected, last_error_get_message())) return failure;
+    return success;
+}
+
+Status
+test_too_long() {
+    char data[LAST_ERROR_MESSAGE_BUFFER_CAPACITY / 2];
+    char long_data[LAST_ERROR_MESSAGE_BUFFER_CAPACITY - 40];
+    memset((void *) data,
+           '.',
+           sizeof(data));
+    data[sizeof(data) - 1] = 0;
+
+    // The string fits in the record, but not the message: `last_error_set()` fails, not `last_error_get_message()`.
+    if (success == last_error_set(1001, __FILE__, __LINE__, __func__, "%s %s", data, data)) return failure;
+    if ((1001 != last_error_get_id()) || ('\0' != last_error_get_message()[0])) return failure;
+
+    // The same string, once.
+    if (failure == last_error_set(1002, __FILE__, __LINE__, __func__, "%s", data)) return failure;
+    if (NULL == strstr(last_error_get_message(), data)) return failure;
+
+    // The message fits, but not along with the whole path of the file: only the end of the path is kept.
+    memset((void *) long_data,
+           '.',
+           sizeof(long_data));
+    long_data[sizeof(long_data) - 1] = 0;
+    if (failure == last_error_set(1003, __FILE__, __LINE__, __func__, "%s", long_data)) return failure;
+    printf("short:   [%s]\n", last_error_get_message());
+    if ((NULL == strstr(last_error_get_message(), "3.c:"))
+        || (NULL == strstr(last_error_get_message(), " test_too_long()] "))
+        || (NULL == strstr(last_error_get_message(), long_data))) {
+        return failure;
+    }
+    return success;
+}
+
+Status
+test_catalogue() {
+    // The lookup from an ID to its data is an array index.
+    for (int id = 0; id < EOE; id++) {
+        if ((int) error_info[id].id != id) return failure;
+    }
+
+    if (failure == function_not_found()) return failure;
+    printf("message: [%s] (%s, %s)\n",
+           last_error_get_message(),
+           error_info[last_error_get_id()].name,
+           error_severity_name[error_info[last_error_get_id()].severity]);
+    if ((ENotFound != last_error_get_id())
+        || (ErrorSeverityInfo != error_info[last_error_get_id()].severity)
+        || (NULL == strstr(last_error_get_message(), "function_not_found()] The resource was not found"))) {
+        return failure;
+    }
+    return success;
 }
 
 /**
- * @brief Return the message associated with the last error.
- * @return The message associated with the last error.
+ * @brief Load the content of a temporary file, and close it.
+ * @param in_fd The file.
+ * @param out_lines_count The number of lines.
+ * @return On success, a non-NULL value that must be freed. Otherwise NULL.
  */
 
 char *
-last_error_get_message() {
-    return LAST_ERROR_MESSAGE;
+load_file(
+        FILE *in_fd,
+        int *out_lines_count) {
+    char *content = NULL;
+    long size;
+
+    if ((0 == fseek(in_fd, 0, SEEK_END)) && ((size = ftell(in_fd)) >= 0)) {
+        rewind(in_fd);
+        content = (char *) malloc((size_t)size + 1);
+    }
+    if (NULL != content) {
+        content[fread(content, 1, (size_t)size, in_fd)] = 0;
+        *out_lines_count = 0;
+        for (char *p = content; '\0' != *p; p++) *out_lines_count += '\n' == *p;
+    }
+    fclose(in_fd);
+    return content;
 }
 
 /**
- * @brief Return the path to the file where the error occurred.
- * @return The path to the file where the error occurred.
+ * @brief Dump the history of errors into a temporary file, and load the file.
+ * @param out_lines_count The number of lines.
+ * @return On success, a non-NULL value that must be freed. Otherwise NULL.
  */
 
 char *
-last_error_file() {
-    return LAST_ERROR_FILE;
-}
+dump_history(int *out_lines_count) {
+    FILE *fd = tmpfile();
 
-int
-last_error_line() {
-    return LAST_ERROR_LINE;
+    if (NULL == fd) return NULL;
+    if (failure == error_history_dump(fileno(fd))) {
+        fclose(fd);
+        return NULL;
+    }
+    return load_file(fd, out_lines_count);
 }
 
-/**
- * @brief Set the last error.
- * @param in_error_id An integer that (hopefully) uniquely identifies the error.
- * @param in_file The *ABSOLUTE* path to the (C) file that contains the code that raised the error.
- * @param in_line The number of the line, within `in_file`, where the error was raised.
- * @param in_function The name of the function that raised the error.
- * @param in_fmt The format descriptor.
- * @param ... The list of arguments.
- * @return Upon successful completion, the function returns the value `success`.
- * Otherwise, it returns the value `failure`. This means that the buffer used to store the error
- * message is not big enough. However, the content of the buffer used to store the error message is always
- * guaranteed to be zero terminated.
- * @note The return value is likely to be ignored by the calling code. Indeed, this function is intended
- * to be used to store information about an error. We assume that it will do its job just fine.
- */
+Status
+test_history() {
+    int lines_count;
+    char *content = dump_history(&lines_count);
+    char *p1, *p2, *p3, *p4;
+    Status status;
+
+    if (NULL == content) return failure;
+    printf("history:\n%s", content);
+
+    // The errors are dumped from the oldest to the most recent. The message of `function_fail()` is too long.
+    p1 = strstr(content, "This is the error #1 in function1");
+    p2 = strstr(content, "This is the error #2 in function2");
+    p3 = strstr(content, "function_fail()] (no message)");
+    p4 = strstr(content, "test_formats()]  3.14|text");
+    status = (4 == lines_count) && (NULL != p1) && (p1 < p2) && (p2 < p3) && (p3 < p4) ? success : failure;
+    free(content);
+    return status;
+}
 
 Status
-last_error_set(
-        const int in_error_id,
-        const char *in_file,
-        int in_line,
-        const char *in_function,
-        const char *in_fmt,
-        ...) {
-    int    bytes_written      = 0;
-    size_t remaining_capacity = LAST_ERROR_MESSAGE_BUFFER_CAPACITY;
-
-    // Copy the error ID, the line number and the name of the source file.
-    LAST_ERROR_ID = in_error_id;
-    LAST_ERROR_LINE = in_line;
-    strncpy(LAST_ERROR_FILE, in_file, LAST_ERROR_FILE_BUFFER_CAPACITY);
-    LAST_ERROR_FILE[LAST_ERROR_FILE_BUFFER_CAPACITY-1] = 0;
-
-    // See the comment for the function `vsnprintf()`. `snprintf` behaves the same way.
-    // If the buffer is big enough, then `bytes_written` is the number of bytes actually written,
-    // **excluding the final zero character**.
-    bytes_written = snprintf(LAST_ERROR_MESSAGE,
-                             remaining_capacity,
-                             "#%010d [%s:%d %s()] ", in_error_id, in_file, in_line, in_function);
-    if ((bytes_written < 0) || (bytes_written >= remaining_capacity)) {
-        LAST_ERROR_MESSAGE[0] = 0;
-        return failure;
+test_stats() {
+    FILE *fd = tmpfile();
+    struct ErrorStats stats[ERROR_STATS_CAPACITY + 1];
+    size_t count;
+    int lines_count;
+    char *content;
+    char summary[128];
+    Status status = failure;
+
+    if (NULL == fd) return failure;
+
+    // At most 3 messages per minute: the first 3 occurrences are written, the others are only counted.
+    error_stats_init(fileno(fd), 3, 60000);
+    for (int i = 0; i < 100; i++) {
+        ERROR_SET(EFlood, i);
     }
-    remaining_capacity -= (size_t)bytes_written;
-
-    // NOTE:
-    //
-    // The function `vsnprintf(char *str, size_t size, const char *format, va_list ap)`
-    // writes at most `size` bytes (including the terminating null byte.
-    //
-    // The function `vsnprintf()` does not write more than `size` bytes
-    // (including the terminating null byte ('\0')). If the output was truncated
-    // due to this limit then the return value is the number of characters (excluding
-    // the terminating null byte) which would have been written to the final string if
-    // enough space had been available. Thus, a return value of `size` or more means that
-    // the output was truncated.
-
-    va_list arg_ptr;
-    va_start(arg_ptr, in_fmt);
-    bytes_written = vsnprintf(LAST_ERROR_MESSAGE + bytes_written, // start writing at the end of the string
-                              remaining_capacity,
-                              in_fmt,
-                              arg_ptr);
-    if ((bytes_written < 0) || (bytes_written >= remaining_capacity)) {
-        LAST_ERROR_MESSAGE[0] = 0;
-        return failure;
+    error_stats_summarise();
+    error_stats_init(-1, 0, 0);
+
+    content = load_file(fd, &lines_count);
+    if (NULL == content) return failure;
+    printf("log:\n%s", content);
+    snprintf(summary, sizeof(summary), "#%010d 97 similar errors suppressed (100 in total)\n", EFlood);
+    if ((4 == lines_count)
+        && (NULL != strstr(content, "Flood #0\n"))
+        && (NULL != strstr(content, "Flood #2\n"))
+        && (NULL == strstr(content, "Flood #3\n"))
+        && (NULL != strstr(content, summary))) {
+        status = success;
     }
-    return success;
+    free(content);
+    if (failure == status) return failure;
+
+    // Once the statistics are disabled, the errors are not counted anymore.
+    error_stats_enable(0);
+    ERROR_SET(EFlood, 100);
+
+    // Each error ID has its own counters.
+    count = error_stats_snapshot(stats, ERROR_STATS_CAPACITY + 1);
+    for (size_t i = 0; i < count; i++) {
+        if (EFlood != stats[i].id) continue;
+        printf("stats:   [%s: %llu occurrences]\n",
+               error_info[EFlood].name,
+               (unsigned long long) stats[i].count);
+        return (100 == stats[i].count) && (0 == stats[i].suppressed) && (stats[i].first_ns <= stats[i].last_ns)
+            ? success : failure;
+    }
+    return failure;
 }
 
 Status
-function1() {
-    return last_error_set(1,
-                          __FILE__,
-                          __LINE__,
-                          __func__,
-                          "This is the error #%d in %s",
-                          1,
-                          __func__);
+test_stats_periodic() {
+    FILE *fd = tmpfile();
+    int lines_count;
+    char *content;
+    char summary[128];
+    Status status;
+
+    if (NULL == fd) return failure;
+
+    // At most 1 message per 50 ms: once the interval is over, the next error writes the summary.
+    error_stats_init(fileno(fd), 1, 50);
+    for (int i = 0; i < 10; i++) {
+        ERROR_SET(EFlood, i);
+    }
+    usleep(120000);
+    ERROR_SET0(ENotFound);
+    error_stats_init(-1, 0, 0);
+
+    content = load_file(fd, &lines_count);
+    if (NULL == content) return failure;
+    printf("log:\n%s", content);
+    snprintf(summary, sizeof(summary), "#%010d 9 similar errors suppressed", EFlood);
+    status = (3 == lines_count)
+             && (NULL != strstr(content, "Flood #0\n"))
+             && (NULL != strstr(content, summary))
+             && (NULL != strstr(content, "The resource was not found\n")) ? success : failure;
+    free(content);
+    return status;
 }
 
 Status
-function2() {
-    return last_error_set(2,
-                          __FILE__,
-                          __LINE__,
-                          __func__,
-                          "This is the error #%d in %s",
-                          2,
-                          __func__);
+test_sink() {
+    char directory[] = "/tmp/pattern3-XXXXXX";
+    char path[sizeof(directory) + 16];
+    FILE *fd;
+    char *content;
+    int lines_count = 0;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    snprintf(path, sizeof(path), "%s/errors.log", directory);
+
+    // The errors are written by a background thread. Closing the sink writes the pending errors.
+    if (failure == error_sink_open(path)) return failure;
+    for (int i = 0; i < 10; i++) {
+        ERROR_SET(EFlood, i);
+    }
+    error_sink_close();
+    error_sink_close(); // it does not harm
+
+    fd = fopen(path, "r");
+    content = NULL == fd ? NULL : load_file(fd, &lines_count);
+    unlink(path);
+    rmdir(directory);
+    if (NULL == content) return failure;
+    printf("sink:    [%d errors written, %llu dropped]\n",
+           lines_count,
+           (unsigned long long) error_sink_dropped());
+    if ((10 != lines_count) || (NULL == strstr(content, "test_sink()] Flood #9\n"))) {
+        free(content);
+        return failure;
+    }
+    free(content);
+    return success;
+}
+
+/**
+ * @brief Set errors over and over, and check that the last error of the thread is never modified by
+ * another thread.
+ * @param in_thread_index Pointer to the index of the thread.
+ * @return NULL if the last error was never modified by another thread.
+ */
+
+void *
+thread_set_errors(void *in_thread_index) {
+    const int id = *(int *) in_thread_index;
+    char expected[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+
+    last_error_init();
+    for (int i = 0; i < THREAD_ITERATIONS; i++) {
+        last_error_set(id,
+                       __FILE__,
+                       i,
+                       __func__,
+                       "thread %d iteration %d",
+                       id,
+                       i);
+        if (0 == i % 100) sched_yield();
+        snprintf(expected,
+                 LAST_ERROR_MESSAGE_BUFFER_CAPACITY,
+                 "#%010d [%s:%d %s()] thread %d iteration %d",
+                 id, __FILE__, i, __func__, id, i);
+        if ((last_error_get_id() != id)
+            || (last_error_line() != i)
+            || (0 != strcmp(last_error_get_message(), expected))) {
+            return in_thread_index;
+        }
+    }
+    return NULL;
 }
 
 Status
-function_fail() {
-    // Create a string that will be too big...
-    char data[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
-    memset((void *) data,
-           '.',
-           LAST_ERROR_MESSAGE_BUFFER_CAPACITY);
-    data[LAST_ERROR_MESSAGE_BUFFER_CAPACITY - 1] = 0;
+test_threads() {
+    pthread_t threads[THREADS_COUNT];
+    int indexes[THREADS_COUNT];
+    Status status = success;
 
-    return last_error_set(3,
-                          __FILE__,
-                          __LINE__,
-                          __func__,
-                          "This is too long #%d in %s (data: %s)",
-                          3,
-                          __func__,
-                          data);
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        indexes[i] = i + 100;
+        if (0 != pthread_create(&threads[i], NULL, thread_set_errors, &indexes[i])) return failure;
+    }
+    for (int i = 0; i < THREADS_COUNT; i++) {
+        void *result;
+        pthread_join(threads[i], &result);
+        if (NULL != result) status = failure;
+    }
+    return status;
 }
 
 int
@@ -214,5 +411,34 @@ main() {
     printf("line:    [%d]\n",
            last_error_line());
 
+    if (failure == test_formats()) { return EXIT_ERROR; }
+    if (failure == test_history()) { return EXIT_ERROR; }
+    if (failure == test_too_long()) { return EXIT_ERROR; }
+    if (failure == test_catalogue()) { return EXIT_ERROR; }
+    if (failure == test_stats()) { return EXIT_ERROR; }
+    if (failure == test_stats_periodic()) { return EXIT_ERROR; }
+    if (failure == test_sink()) { return EXIT_ERROR; }
+    if (success == function_fail()) { return EXIT_ERROR; }
+
+    // The threads do not modify the last error of the main thread.
+    if (ETooLong != last_error_get_id()) { return EXIT_ERROR; }
+    if (failure == test_threads()) { return EXIT_ERROR; }
+    if (ETooLong != last_error_get_id()) { return EXIT_ERROR; }
+    printf("threads: [%d threads x %d errors]\n",
+           THREADS_COUNT,
+           THREAD_ITERATIONS);
+
+    // The history is full. Some errors may have been dropped, because of concurrent writers.
+    {
+        int lines_count;
+        char *content = dump_history(&lines_count);
+        if (NULL == content) { return EXIT_ERROR; }
+        free(content);
+        printf("history: [%d errors, %llu dropped]\n",
+               lines_count,
+               (unsigned long long) error_history_dropped());
+        if ((lines_count <= 0) || (lines_count > ERROR_HISTORY_CAPACITY)) { return EXIT_ERROR; }
+    }
+
     return EXIT_SUCCESS;
 }
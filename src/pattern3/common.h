@@ -0,0 +1,9 @@
+#ifndef C_PATTERNS_PATTERN3_COMMON_H
+#define C_PATTERNS_PATTERN3_COMMON_H
+
+#define EXIT_SUCCESS 0
+#define EXIT_ERROR 1
+enum EnumStatus { failure, success };
+typedef enum EnumStatus Status;
+
+#endif //C_PATTERNS_PATTERN3_COMMON_H
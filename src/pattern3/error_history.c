@@ -0,0 +1,181 @@
+/**
+ * Keep the last errors (and not only the very last one), so that the root cause of a cascade of
+ * errors is not lost.
+ *
+ * The errors are stored in a ring buffer shared by all the threads. Writing into the ring does not
+ * require any lock:
+ *
+ * - A writer takes a ticket (an atomic counter). The ticket gives the slot to write into.
+ * - Each slot has a sequence number: `2 * ticket + 1` while the slot is being written, and `2 * ticket + 2`
+ *   once it is written. A writer that finds the slot busy (or already written by a more recent ticket) drops
+ *   its error instead of waiting.
+ * - A reader copies the slot, and then checks that the sequence number has not changed. Otherwise, the copy
+ *   may be torn and it is ignored.
+ *
+ * The messages are not formatted when the errors are pushed: they are formatted by `error_history_dump()`.
+ * The history is enabled by default: it is cheap enough to be left enabled in production (a ticket, a coarse clock
+ * read, and a copy of the record, without formatting). `error_history_enable(0)` disables it: then pushing an error
+ * costs a single atomic load.
+ *
+ * Synopsis:
+ *
+ *      // `last_error_set()` pushes the errors into the history.
+ *      ...
+ *      error_history_dump(STDERR_FILENO);
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "error_history.h"
+
+// The coarse clock is several times cheaper. Its resolution (a few milliseconds) is good enough here: the
+// errors are ordered using their tickets, not their timestamps.
+#ifdef CLOCK_REALTIME_COARSE
+#define HISTORY_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define HISTORY_CLOCK CLOCK_REALTIME
+#endif
+
+struct ErrorHistorySlot {
+    uint64_t               sequence; // 0: the slot has never been written
+    struct timespec        timestamp;
+    struct LastErrorRecord record;
+};
+
+static struct ErrorHistorySlot HISTORY[ERROR_HISTORY_CAPACITY];
+static uint64_t                HISTORY_TICKET  = 0;
+static uint64_t                HISTORY_DROPPED = 0;
+static int                     HISTORY_ENABLED = 1; // the errors are pushed only if the history is enabled
+
+/**
+ * @brief Enable (or disable) the history.
+ * @param in_enabled 1 (the default): the errors are pushed into the history. 0: they are not.
+ * @note The errors already in the history are kept: they are still written by `error_history_dump()`.
+ */
+
+void
+error_history_enable(
+        const int in_enabled) {
+    __atomic_store_n(&HISTORY_ENABLED, in_enabled, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Push an error into the history.
+ * @param in_record The error.
+ * @note This function is called by `last_error_set()`. It never blocks.
+ */
+
+void
+error_history_push(
+        const struct LastErrorRecord *in_record) {
+    uint64_t ticket;
+    struct ErrorHistorySlot *slot;
+    uint64_t observed;
+
+    if (! __atomic_load_n(&HISTORY_ENABLED, __ATOMIC_ACQUIRE)) return;
+
+    ticket = __atomic_fetch_add(&HISTORY_TICKET, 1, __ATOMIC_RELAXED);
+    slot = &HISTORY[ticket & (ERROR_HISTORY_CAPACITY - 1)];
+    observed = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+
+    // The slot is being written by another thread, or it already contains a more recent error.
+    if ((observed & 1) || (observed >= 2 * ticket + 2)
+        || ! __atomic_compare_exchange_n(&slot->sequence,
+                                         &observed,
+                                         2 * ticket + 1,
+                                         0,
+                                         __ATOMIC_ACQUIRE,
+                                         __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&HISTORY_DROPPED, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    clock_gettime(HISTORY_CLOCK, &slot->timestamp);
+    last_error_record_copy(&slot->record, in_record);
+    __atomic_store_n(&slot->sequence, 2 * ticket + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Return the number of errors that were not pushed into the history, because of a concurrent writer.
+ * @return The number of errors.
+ */
+
+uint64_t
+error_history_dropped() {
+    return __atomic_load_n(&HISTORY_DROPPED, __ATOMIC_RELAXED);
+}
+
+static int
+compare_slots(
+        const void *in_a,
+        const void *in_b) {
+    const uint64_t a = ((const struct ErrorHistorySlot *) in_a)->sequence;
+    const uint64_t b = ((const struct ErrorHistorySlot *) in_b)->sequence;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Write the history into a file, from the oldest error to the most recent one.
+ *
+ * Each line contains the (UTC) date of the error, followed by its message (see
+ * `last_error_record_format_line()`).
+ *
+ * @param in_fd Descriptor of the file to write into.
+ * @return On success `success`. Otherwise `failure`.
+ * @note All the lines are written using a single call to `write()` (unless it is interrupted).
+ * @note The errors pushed while the history is being dumped may not be included.
+ */
+
+Status
+error_history_dump(
+        const int in_fd) {
+    struct ErrorHistorySlot *slots;
+    char   *buffer;
+    size_t count  = 0;
+    size_t length = 0;
+    Status status = success;
+
+    slots = (struct ErrorHistorySlot *) malloc(sizeof(struct ErrorHistorySlot) * ERROR_HISTORY_CAPACITY);
+    buffer = (char *) malloc(LAST_ERROR_LINE_CAPACITY * ERROR_HISTORY_CAPACITY);
+    if ((NULL == slots) || (NULL == buffer)) {
+        free(slots);
+        free(buffer);
+        return failure;
+    }
+
+    // Copy the slots. A copy is valid only if the sequence number did not change during the copy.
+    for (size_t i = 0; i < ERROR_HISTORY_CAPACITY; i++) {
+        const uint64_t sequence = __atomic_load_n(&HISTORY[i].sequence, __ATOMIC_ACQUIRE);
+        if ((0 == sequence) || (sequence & 1)) continue;
+        memcpy(&slots[count], &HISTORY[i], sizeof(struct ErrorHistorySlot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&HISTORY[i].sequence, __ATOMIC_RELAXED) != sequence) continue;
+        slots[count].sequence = sequence;
+        count++;
+    }
+    qsort(slots, count, sizeof(struct ErrorHistorySlot), compare_slots);
+
+    // Format all the lines into a single buffer.
+    for (size_t i = 0; i < count; i++) {
+        length += last_error_record_format_line(&slots[i].record, &slots[i].timestamp, buffer + length);
+    }
+
+    // Write the buffer.
+    for (size_t written = 0; written < length;) {
+        ssize_t bytes_written = write(in_fd, buffer + written, length - written);
+        if (bytes_written < 0) {
+            if (EINTR == errno) continue;
+            status = failure;
+            break;
+        }
+        written += (size_t)bytes_written;
+    }
+
+    free(slots);
+    free(buffer);
+    return status;
+}
@@ -0,0 +1,25 @@
+#ifndef C_PATTERNS_ERROR_HISTORY_H
+#define C_PATTERNS_ERROR_HISTORY_H
+
+#include <stdint.h>
+#include "last_error.h"
+
+// Number of errors kept in the history. Must be a power of 2.
+#define ERROR_HISTORY_CAPACITY 64
+
+void
+error_history_enable(
+        int in_enabled);
+
+void
+error_history_push(
+        const struct LastErrorRecord *in_record);
+
+Status
+error_history_dump(
+        int in_fd);
+
+uint64_t
+error_history_dropped();
+
+#endif //C_PATTERNS_ERROR_HISTORY_H
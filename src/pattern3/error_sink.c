@@ -0,0 +1,214 @@
+/**
+ * Write the errors into a file, without making the threads that report the errors wait for the I/O.
+ *
+ * - `last_error_set()` pushes the error (not formatted) into a bounded queue. Pushing never blocks: if the
+ *   queue is full, then the error is dropped (and counted).
+ * - A background thread pops the errors, formats them and writes them into the file, by batches.
+ *
+ * The queue is a bounded array of cells (see Dmitry Vyukov's bounded MPMC queue). Each cell has a sequence
+ * number that tells whether the cell is free (for a given position of the producers) or ready to be read
+ * (for a given position of the consumer). There is only one consumer: the background thread.
+ *
+ * Synopsis:
+ *
+ *      if (failure == error_sink_open("/var/log/errors.log")) { ... }
+ *      ...
+ *      // `last_error_set()` pushes the errors into the sink.
+ *      ...
+ *      error_sink_close(); // optional: called automatically when the process exits.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "error_sink.h"
+
+#ifdef CLOCK_REALTIME_COARSE
+#define SINK_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define SINK_CLOCK CLOCK_REALTIME
+#endif
+
+struct ErrorSinkCell {
+    uint64_t               sequence;
+    struct timespec        timestamp;
+    struct LastErrorRecord record;
+};
+
+static struct ErrorSinkCell QUEUE[ERROR_SINK_QUEUE_CAPACITY];
+static uint64_t             ENQUEUE_POSITION = 0;
+static uint64_t             DEQUEUE_POSITION = 0; // only used by the writer thread
+static uint64_t             DROPPED          = 0;
+static int                  SINK_OPENED      = 0; // the errors are pushed only if the sink is opened
+static int                  SINK_STOP        = 0;
+static int                  SINK_FD          = -1;
+static pthread_t            SINK_THREAD;
+static int                  AT_EXIT_REGISTERED = 0;
+
+/**
+ * @brief Push an error into the queue.
+ * @param in_record The error.
+ * @note This function is called by `last_error_set()`. It never blocks.
+ */
+
+void
+error_sink_push(
+        const struct LastErrorRecord *in_record) {
+    struct ErrorSinkCell *cell;
+    uint64_t position;
+
+    if (! __atomic_load_n(&SINK_OPENED, __ATOMIC_ACQUIRE)) return;
+
+    position = __atomic_load_n(&ENQUEUE_POSITION, __ATOMIC_RELAXED);
+    for (;;) {
+        uint64_t sequence;
+        int64_t  difference;
+
+        cell = &QUEUE[position & (ERROR_SINK_QUEUE_CAPACITY - 1)];
+        sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        difference = (int64_t)sequence - (int64_t)position;
+        if (0 == difference) {
+            // The cell is free: try to reserve it.
+            if (__atomic_compare_exchange_n(&ENQUEUE_POSITION,
+                                            &position,
+                                            position + 1,
+                                            1,
+                                            __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            // The queue is full.
+            __atomic_fetch_add(&DROPPED, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            // Another producer reserved the cell.
+            position = __atomic_load_n(&ENQUEUE_POSITION, __ATOMIC_RELAXED);
+        }
+    }
+
+    clock_gettime(SINK_CLOCK, &cell->timestamp);
+    last_error_record_copy(&cell->record, in_record);
+    __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Return the number of errors that were dropped because the queue was full.
+ * @return The number of errors.
+ */
+
+uint64_t
+error_sink_dropped() {
+    return __atomic_load_n(&DROPPED, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Pop a batch of errors from the queue, and write them into the file.
+ * @param in_buffer Buffer used to format the errors.
+ * @return The number of errors written.
+ */
+
+static size_t
+write_batch(char *in_buffer) {
+    size_t count  = 0;
+    size_t length = 0;
+
+    while (count < ERROR_SINK_BATCH_CAPACITY) {
+        struct ErrorSinkCell *cell = &QUEUE[DEQUEUE_POSITION & (ERROR_SINK_QUEUE_CAPACITY - 1)];
+        if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != DEQUEUE_POSITION + 1) break; // empty
+        length += last_error_record_format_line(&cell->record, &cell->timestamp, in_buffer + length);
+        // Give the cell back to the producers.
+        __atomic_store_n(&cell->sequence, DEQUEUE_POSITION + ERROR_SINK_QUEUE_CAPACITY, __ATOMIC_RELEASE);
+        DEQUEUE_POSITION++;
+        count++;
+    }
+
+    for (size_t written = 0; written < length;) {
+        ssize_t bytes_written = write(SINK_FD, in_buffer + written, length - written);
+        if (bytes_written < 0) {
+            if (EINTR == errno) continue;
+            break; // we cannot report this error: the errors are lost.
+        }
+        written += (size_t)bytes_written;
+    }
+    return count;
+}
+
+static void *
+writer_thread(void *in_buffer) {
+    for (;;) {
+        const int stop = __atomic_load_n(&SINK_STOP, __ATOMIC_ACQUIRE);
+        if (write_batch((char *) in_buffer) > 0) continue;
+        // The queue is empty. Once asked to stop, the thread returns only when the queue is empty.
+        if (stop) break;
+        {
+            struct timespec pause = { 0, ERROR_SINK_IDLE_US * 1000 };
+            nanosleep(&pause, NULL);
+        }
+    }
+    free(in_buffer);
+    return NULL;
+}
+
+/**
+ * @brief Start writing the errors into a file.
+ * @param in_path Path to the file. The errors are appended to the file.
+ * @return On success `success`. Otherwise `failure`.
+ * @note If the sink is already opened, then it is closed first. Do not (re)open the sink while other threads
+ * are reporting errors.
+ */
+
+Status
+error_sink_open(const char *in_path) {
+    char *buffer;
+
+    error_sink_close();
+
+    buffer = (char *) malloc(LAST_ERROR_LINE_CAPACITY * ERROR_SINK_BATCH_CAPACITY);
+    if (NULL == buffer) return failure;
+    SINK_FD = open(in_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (SINK_FD < 0) {
+        free(buffer);
+        return failure;
+    }
+
+    for (uint64_t i = 0; i < ERROR_SINK_QUEUE_CAPACITY; i++) {
+        __atomic_store_n(&QUEUE[i].sequence, i, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&ENQUEUE_POSITION, 0, __ATOMIC_RELAXED);
+    DEQUEUE_POSITION = 0;
+    __atomic_store_n(&SINK_STOP, 0, __ATOMIC_RELAXED);
+
+    if (0 != pthread_create(&SINK_THREAD, NULL, writer_thread, buffer)) {
+        free(buffer);
+        close(SINK_FD);
+        SINK_FD = -1;
+        return failure;
+    }
+    if (! AT_EXIT_REGISTERED) {
+        atexit(error_sink_close);
+        AT_EXIT_REGISTERED = 1;
+    }
+    __atomic_store_n(&SINK_OPENED, 1, __ATOMIC_RELEASE);
+    return success;
+}
+
+/**
+ * @brief Write all the errors that are waiting in the queue, and stop writing the errors into the file.
+ * @note Please note that you can call this function multiple times. It is called when the process exits.
+ * @note The errors pushed while the sink is being closed may be lost.
+ */
+
+void
+error_sink_close() {
+    if (! __atomic_load_n(&SINK_OPENED, __ATOMIC_ACQUIRE)) return;
+    __atomic_store_n(&SINK_OPENED, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&SINK_STOP, 1, __ATOMIC_RELEASE);
+    pthread_join(SINK_THREAD, NULL);
+    close(SINK_FD);
+    SINK_FD = -1;
+}
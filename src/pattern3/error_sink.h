@@ -0,0 +1,28 @@
+#ifndef C_PATTERNS_ERROR_SINK_H
+#define C_PATTERNS_ERROR_SINK_H
+
+#include <stdint.h>
+#include "last_error.h"
+
+// Number of errors that can wait to be written. Must be a power of 2.
+#define ERROR_SINK_QUEUE_CAPACITY 1024
+// Maximum number of errors written by a single call to `write()`.
+#define ERROR_SINK_BATCH_CAPACITY 256
+// Duration of the pause of the writer thread, when there is nothing to write (in microseconds).
+#define ERROR_SINK_IDLE_US 1000
+
+Status
+error_sink_open(
+        const char *in_path);
+
+void
+error_sink_close();
+
+void
+error_sink_push(
+        const struct LastErrorRecord *in_record);
+
+uint64_t
+error_sink_dropped();
+
+#endif //C_PATTERNS_ERROR_SINK_H
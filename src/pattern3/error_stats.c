@@ -0,0 +1,323 @@
+/**
+ * Count the occurrences of each error, and emit the errors without flooding the log.
+ *
+ * - Each error ID has its own counters (number of occurrences, dates of the first and the last occurrences).
+ * - Each error ID has its own token bucket: at most `burst` occurrences per `interval` are formatted and
+ *   written into the log. The other occurrences are only counted. The number of suppressed occurrences is
+ *   written along with the next emitted occurrence, or by `error_stats_summarise()`.
+ * - The suppressed occurrences are summarised once per interval: the first error recorded after the end of
+ *   an interval writes the summary (so the errors that do not occur anymore are reported too).
+ *
+ * All the counters are updated using atomic operations: there is no lock.
+ *
+ * The statistics are disabled until `error_stats_init()` is called: until then, recording an error costs a
+ * single atomic load (no clock, no counter).
+ *
+ * Synopsis:
+ *
+ *      error_stats_init(STDERR_FILENO, 10, 1000); // at most 10 messages per second, for each error ID
+ *      ...
+ *      // `last_error_set()` calls `error_stats_record()`.
+ *      ...
+ *      struct ErrorStats stats[ERROR_STATS_CAPACITY + 1];
+ *      size_t count = error_stats_snapshot(stats, ERROR_STATS_CAPACITY + 1);
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "error_stats.h"
+
+#ifdef CLOCK_REALTIME_COARSE
+#define STATS_CLOCK CLOCK_REALTIME_COARSE
+#else
+#define STATS_CLOCK CLOCK_REALTIME
+#endif
+
+// The state of a token bucket is stored in a single 64 bits word, so that it can be updated atomically:
+// the 48 most significant bits contain the date of the last refill (in milliseconds), and the 16 least
+// significant bits contain the number of tokens.
+#define BUCKET_TOKENS_BITS 16
+#define BUCKET_TOKENS_MASK ((uint64_t)0xFFFF)
+#define BUCKET_MAX_BURST 0xFFFF
+// Maximum length of the suffix added to an emitted message.
+#define SUFFIX_CAPACITY 64
+// Maximum length of a line written by `error_stats_summarise()`.
+#define SUMMARY_LINE_CAPACITY 96
+
+struct ErrorStatsSlot {
+    uint64_t count;
+    uint64_t suppressed;
+    int64_t  first_ns;
+    int64_t  last_ns;
+    uint64_t bucket; // 0: the bucket is full
+};
+
+// The last slot is used by the errors which IDs are out of range.
+static struct ErrorStatsSlot STATS[ERROR_STATS_CAPACITY + 1];
+static int                   STATS_FD          = -1;
+static unsigned int          STATS_BURST       = 0;
+static unsigned int          STATS_INTERVAL_MS = 0;
+static int                   STATS_ENABLED     = 0; // the errors are counted only if the statistics are enabled
+static uint64_t              LAST_SUMMARY_MS   = 0; // date of the last periodic summary (in milliseconds)
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(STATS_CLOCK, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct ErrorStatsSlot *
+get_slot(const int in_id) {
+    if ((in_id < 0) || (in_id >= ERROR_STATS_CAPACITY)) return &STATS[ERROR_STATS_CAPACITY];
+    return &STATS[in_id];
+}
+
+static Status
+write_all(
+        const int in_fd,
+        const char *in_buffer,
+        size_t in_length) {
+    while (in_length > 0) {
+        ssize_t bytes_written = write(in_fd, in_buffer, in_length);
+        if (bytes_written < 0) {
+            if (EINTR == errno) continue;
+            return failure;
+        }
+        in_buffer += bytes_written;
+        in_length -= (size_t)bytes_written;
+    }
+    return success;
+}
+
+/**
+ * @brief Try to take a token from the bucket of an error ID.
+ * @param in_slot The slot associated with the error ID.
+ * @param in_now_ms The current date, in milliseconds.
+ * @return If a token was taken: `success`. Otherwise: `failure`.
+ */
+
+static Status
+take_token(
+        struct ErrorStatsSlot *in_slot,
+        const uint64_t in_now_ms) {
+    const uint64_t burst    = __atomic_load_n(&STATS_BURST, __ATOMIC_RELAXED);
+    const uint64_t interval = __atomic_load_n(&STATS_INTERVAL_MS, __ATOMIC_RELAXED);
+    uint64_t observed = __atomic_load_n(&in_slot->bucket, __ATOMIC_RELAXED);
+
+    for (;;) {
+        uint64_t tokens = observed & BUCKET_TOKENS_MASK;
+        uint64_t date   = observed >> BUCKET_TOKENS_BITS;
+        uint64_t refill;
+
+        if (0 == observed) {
+            // First use (or the configuration changed): the bucket is full.
+            tokens = burst;
+            date   = in_now_ms;
+        }
+        refill = in_now_ms > date ? (in_now_ms - date) * burst / (interval > 0 ? interval : 1) : 0;
+        if (tokens + refill >= burst) {
+            tokens = burst;
+            date   = in_now_ms;
+        } else if (refill > 0) {
+            // Only the time consumed by the refilled tokens is accounted for: the remainder is kept for the
+            // next refill (otherwise, frequent errors would never get any token back).
+            tokens += refill;
+            date   += refill * interval / burst;
+        }
+        if (0 == tokens) return failure;
+        if (__atomic_compare_exchange_n(&in_slot->bucket,
+                                        &observed,
+                                        (date << BUCKET_TOKENS_BITS) | (tokens - 1),
+                                        0,
+                                        __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+            return success;
+        }
+    }
+}
+
+/**
+ * @brief Configure the emission of the errors.
+ * @param in_fd Descriptor of the file the errors are written into. If the given value is negative, then
+ * the errors are only counted.
+ * @param in_burst The maximum number of occurrences of an error ID that are written per interval.
+ * @param in_interval_ms The duration of an interval, in milliseconds.
+ * @note This function enables the statistics (see `error_stats_enable()`).
+ * @note The counters are not reset. Please note that this function may be called multiple times.
+ */
+
+void
+error_stats_init(
+        const int in_fd,
+        const unsigned int in_burst,
+        const unsigned int in_interval_ms) {
+    __atomic_store_n(&STATS_BURST, in_burst > BUCKET_MAX_BURST ? BUCKET_MAX_BURST : in_burst, __ATOMIC_RELAXED);
+    __atomic_store_n(&STATS_INTERVAL_MS, in_interval_ms, __ATOMIC_RELAXED);
+    __atomic_store_n(&LAST_SUMMARY_MS, (uint64_t)now_ns() / 1000000, __ATOMIC_RELAXED);
+    for (size_t i = 0; i <= ERROR_STATS_CAPACITY; i++) {
+        __atomic_store_n(&STATS[i].bucket, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&STATS_FD, in_fd, __ATOMIC_RELEASE);
+    __atomic_store_n(&STATS_ENABLED, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Enable (or disable) the statistics.
+ * @param in_enabled 1: the errors are counted (and written, if a file was given to `error_stats_init()`).
+ * 0: they are not.
+ * @note The counters are kept: they are still returned by `error_stats_snapshot()`.
+ */
+
+void
+error_stats_enable(
+        const int in_enabled) {
+    __atomic_store_n(&STATS_ENABLED, in_enabled, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Summarise the suppressed occurrences if the current interval is over.
+ * @param in_now_ms The current date, in milliseconds.
+ * @note If several threads see the end of the interval, then only one of them writes the summary.
+ */
+
+static void
+summarise_periodically(
+        const uint64_t in_now_ms) {
+    const uint64_t interval = __atomic_load_n(&STATS_INTERVAL_MS, __ATOMIC_RELAXED);
+    uint64_t last = __atomic_load_n(&LAST_SUMMARY_MS, __ATOMIC_RELAXED);
+
+    if ((0 == interval) || (in_now_ms < last + interval)) return;
+    if (__atomic_compare_exchange_n(&LAST_SUMMARY_MS, &last, in_now_ms, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        error_stats_summarise();
+    }
+}
+
+/**
+ * @brief Count an occurrence of an error, and write it into the log if the rate allows it.
+ * @param in_record The error.
+ * @note This function is called by `last_error_set()`. The message is formatted only if it is written.
+ * @note Once per interval, this function also writes the summary of the suppressed occurrences (see
+ * `error_stats_summarise()`).
+ */
+
+void
+error_stats_record(
+        const struct LastErrorRecord *in_record) {
+    struct ErrorStatsSlot *slot;
+    int fd;
+    int64_t now;
+    int64_t no_date = 0;
+    char line[LAST_ERROR_MESSAGE_BUFFER_CAPACITY + SUFFIX_CAPACITY];
+    uint64_t suppressed;
+    size_t length;
+
+    if (! __atomic_load_n(&STATS_ENABLED, __ATOMIC_ACQUIRE)) return;
+
+    slot = get_slot(in_record->id);
+    fd = __atomic_load_n(&STATS_FD, __ATOMIC_ACQUIRE);
+    now = now_ns();
+    __atomic_fetch_add(&slot->count, 1, __ATOMIC_RELAXED);
+    __atomic_compare_exchange_n(&slot->first_ns, &no_date, now, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->last_ns, now, __ATOMIC_RELAXED);
+
+    if (fd < 0) return;
+    summarise_periodically((uint64_t)now / 1000000);
+    if (failure == take_token(slot, (uint64_t)now / 1000000)) {
+        __atomic_fetch_add(&slot->suppressed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // Emit the error, along with the number of occurrences suppressed since the last emission.
+    if (failure == last_error_record_format(in_record, line, LAST_ERROR_MESSAGE_BUFFER_CAPACITY)) {
+        snprintf(line,
+                 LAST_ERROR_MESSAGE_BUFFER_CAPACITY,
+                 "#%010d [%s:%d %s()] (no message)",
+                 in_record->id,
+                 in_record->file,
+                 in_record->line,
+                 in_record->function);
+    }
+    length = strlen(line);
+    suppressed = __atomic_exchange_n(&slot->suppressed, 0, __ATOMIC_RELAXED);
+    if (suppressed > 0) {
+        length += (size_t)snprintf(line + length,
+                                   SUFFIX_CAPACITY,
+                                   " (%llu similar errors suppressed)",
+                                   (unsigned long long) suppressed);
+    }
+    line[length++] = '\n';
+    write_all(fd, line, length);
+}
+
+/**
+ * @brief Return the counters of all the error IDs that occurred at least once.
+ * @param out_stats The array used to store the counters.
+ * @param in_capacity The capacity of the array. To get all the counters, the capacity must be
+ * `ERROR_STATS_CAPACITY + 1`.
+ * @return The number of entries written into the array.
+ * @note The counters are read while they may be updated: each value is exact, but the values of one entry
+ * may not be consistent with each other.
+ */
+
+size_t
+error_stats_snapshot(
+        struct ErrorStats *out_stats,
+        const size_t in_capacity) {
+    size_t count = 0;
+
+    for (size_t i = 0; (i <= ERROR_STATS_CAPACITY) && (count < in_capacity); i++) {
+        const uint64_t occurrences = __atomic_load_n(&STATS[i].count, __ATOMIC_RELAXED);
+        if (0 == occurrences) continue;
+        out_stats[count].id         = i == ERROR_STATS_CAPACITY ? ERROR_STATS_OTHER_ID : (int) i;
+        out_stats[count].count      = occurrences;
+        out_stats[count].suppressed = __atomic_load_n(&STATS[i].suppressed, __ATOMIC_RELAXED);
+        out_stats[count].first_ns   = __atomic_load_n(&STATS[i].first_ns, __ATOMIC_RELAXED);
+        out_stats[count].last_ns    = __atomic_load_n(&STATS[i].last_ns, __ATOMIC_RELAXED);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Write a summary line for each error ID that has suppressed occurrences.
+ *
+ *      #0000000010 12 similar errors suppressed (1000 in total)
+ *
+ * @return On success `success`. Otherwise `failure`.
+ * @note This function is called by `error_stats_record()` once per interval. Call it before the process
+ * exits, so that the occurrences suppressed during the last interval are reported.
+ */
+
+Status
+error_stats_summarise() {
+    const int fd = __atomic_load_n(&STATS_FD, __ATOMIC_ACQUIRE);
+    char   *buffer;
+    size_t length = 0;
+    Status status;
+
+    if (fd < 0) return success;
+    buffer = (char *) malloc(SUMMARY_LINE_CAPACITY * (ERROR_STATS_CAPACITY + 1));
+    if (NULL == buffer) return failure;
+
+    for (size_t i = 0; i <= ERROR_STATS_CAPACITY; i++) {
+        uint64_t suppressed;
+
+        if (0 == __atomic_load_n(&STATS[i].suppressed, __ATOMIC_RELAXED)) continue;
+        suppressed = __atomic_exchange_n(&STATS[i].suppressed, 0, __ATOMIC_RELAXED);
+        length += (size_t)snprintf(buffer + length,
+                                   SUMMARY_LINE_CAPACITY,
+                                   "#%010d %llu similar errors suppressed (%llu in total)\n",
+                                   i == ERROR_STATS_CAPACITY ? ERROR_STATS_OTHER_ID : (int) i,
+                                   (unsigned long long) suppressed,
+                                   (unsigned long long) __atomic_load_n(&STATS[i].count, __ATOMIC_RELAXED));
+    }
+
+    status = write_all(fd, buffer, length);
+    free(buffer);
+    return status;
+}
@@ -0,0 +1,47 @@
+#ifndef C_PATTERNS_ERROR_STATS_H
+#define C_PATTERNS_ERROR_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "last_error.h"
+
+// Number of error IDs that have their own counters. The errors which IDs are negative, or greater than or
+// equal to this value, share a single set of counters (reported with the ID `ERROR_STATS_OTHER_ID`).
+#define ERROR_STATS_CAPACITY 1024
+#define ERROR_STATS_OTHER_ID -1
+
+/**
+ * The counters associated with an error ID, as returned by `error_stats_snapshot()`.
+ */
+
+struct ErrorStats {
+    int      id;
+    uint64_t count;       // number of occurrences
+    uint64_t suppressed;  // number of occurrences not emitted (and not summarised yet)
+    int64_t  first_ns;    // date of the first occurrence (nanoseconds since the Epoch)
+    int64_t  last_ns;     // date of the last occurrence (nanoseconds since the Epoch)
+};
+
+void
+error_stats_init(
+        int in_fd,
+        unsigned int in_burst,
+        unsigned int in_interval_ms);
+
+void
+error_stats_enable(
+        int in_enabled);
+
+void
+error_stats_record(
+        const struct LastErrorRecord *in_record);
+
+size_t
+error_stats_snapshot(
+        struct ErrorStats *out_stats,
+        size_t in_capacity);
+
+Status
+error_stats_summarise();
+
+#endif //C_PATTERNS_ERROR_STATS_H
@@ -0,0 +1,83 @@
+#ifndef C_PATTERNS_ERRORS_H
+#define C_PATTERNS_ERRORS_H
+
+/**
+ * This header file uses the technique presented by "pattern4.h" (how to extend a list of enums) to
+ * build a catalogue of errors: each error is declared once, with its severity and its format.
+ *
+ * Synopsis:
+ *
+ *      #define ERRORS_TYPES \
+ *      DECLARE(ENotFound,  ErrorSeverityWarning, "resource not found") \
+ *      DECLARE(EBadValue,  ErrorSeverityError,   "bad value %d for %s")
+ *
+ *      #include "errors.h"
+ *
+ *      ERROR_SET0(ENotFound);                    // no argument: nothing is formatted, nothing is copied
+ *      ERROR_SET(EBadValue, 10, "parameter");
+ *      ...
+ *      if (ErrorSeverityFatal == error_info[last_error_get_id()].severity) { ... }
+ *
+ * Like "pattern4.h", this header file defines variables: include it in only one C file.
+ */
+
+#include "last_error.h"
+
+#ifndef ERRORS_TYPES
+#error "You must declare a set of errors by defining the macro ERRORS_TYPES."
+#endif
+
+enum ErrorSeverity { ErrorSeverityInfo, ErrorSeverityWarning, ErrorSeverityError, ErrorSeverityFatal };
+
+const char *error_severity_name[] = { "info", "warning", "error", "fatal" };
+
+#define BASE_ERRORS_TYPES \
+DECLARE(EUnknown,     ErrorSeverityError, "unknown error") \
+DECLARE(EOutOfMemory, ErrorSeverityFatal, "out of memory")
+
+// Please note:
+// The line `#define DECLARE(a, b, c) a` defines a simple macro (called "DECLARE") that replaces "(V1, V2, V3)"
+// into "V1,". See "pattern4.h" for a detailed explanation.
+#define DECLARE(a, b, c) a,
+enum ErrorId {
+    BASE_ERRORS_TYPES
+    ERRORS_TYPES
+    EOE /* End Of Errors */
+};
+#undef DECLARE
+
+/**
+ * Data associated with an error ID.
+ */
+
+struct ErrorInfo {
+    enum ErrorId       id;
+    const char         *name;
+    enum ErrorSeverity severity;
+    const char         *fmt;
+};
+
+// Please note:
+// The line `#define DECLARE(a, b, c) { a, #a, b, c },` replaces "(V1, V2, V3)" into "{ V1, "V1", V2, V3 },".
+// Since the errors are declared in the same order as the enums, `error_info[id].id` is always `id`: the lookup
+// from an ID to its data is a plain array index.
+#define DECLARE(a, b, c) { a, #a, b, c },
+const struct ErrorInfo error_info[] = {
+        BASE_ERRORS_TYPES
+        ERRORS_TYPES
+        { EOE, NULL, ErrorSeverityInfo, NULL }
+};
+#undef DECLARE
+
+// Set the last error. The format is the one declared for the error.
+// ERROR_SET(EBadValue, 10, "parameter") => last_error_set(EBadValue, __FILE__, __LINE__, __func__, "bad value %d for %s", 10, "parameter")
+#define ERROR_SET(in_id, ...) \
+        last_error_set((in_id), __FILE__, __LINE__, __func__, error_info[(in_id)].fmt, __VA_ARGS__)
+
+// Set the last error, for an error which format does not require any argument.
+// This is the cheapest way to set an error: only the ID and the location of the error are stored.
+// Using it for an error which format requires arguments fails an assertion (unless `NDEBUG` is defined).
+#define ERROR_SET0(in_id) \
+        last_error_set_id((in_id), __FILE__, __LINE__, __func__, error_info[(in_id)].fmt)
+
+#endif //C_PATTERNS_ERRORS_H
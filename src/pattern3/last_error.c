@@ -0,0 +1,768 @@
+/**
+ * Report an error with all required data for fast identification:
+ *
+ * - the error is identified by an (hopefully unique) integer.
+ * - the error message includes the precise location (in the source code) where the error was thrown.
+ *
+ * The last error is stored per thread: concurrent threads do not overwrite each other's errors, and
+ * no lock is required.
+ *
+ * Most errors are handled using their IDs only: the message is never read. Thus, the message is not
+ * formatted when the error is set. `last_error_set()` only records the values of the arguments (see
+ * `struct LastErrorRecord`), and the message is formatted by the first call to `last_error_get_message()`.
+ *
+ * Please note that a `va_list` cannot be kept once the function that received the arguments has returned.
+ * This is why the values of the arguments are extracted from the list (according to the format) and copied.
+ *
+ * The errors are also kept in a history shared by all the threads (see "error_history.c") and, optionally, counted
+ * (see "error_stats.c") and written into a file by a background thread (see "error_sink.c").
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include "last_error.h"
+#include "error_history.h"
+#include "error_stats.h"
+#include "error_sink.h"
+
+// The maximum length of a conversion specification, once rewritten (ex: "%-+010.5jd").
+#define SPECIFICATION_CAPACITY 32
+// The maximum length of the prefix of a message, without the file, the line and the function: "#%010d [:%d ()] ".
+#define PREFIX_LENGTH_MAX 20
+// The maximum length of an integer (`intmax_t` or `uintmax_t`) or of a pointer, converted to text.
+#define INTEGER_LENGTH_MAX 23
+// The maximum length of a floating point number written with `%e`, `%g` or `%a`, without the precision.
+#define DOUBLE_LENGTH_MAX 64
+
+// Types of the values stored in `struct LastErrorRecord`.
+enum EnumArgumentType {
+    TYPE_INT,
+    TYPE_UINT,
+    TYPE_CHAR,
+    TYPE_DOUBLE,
+    TYPE_LONG_DOUBLE,
+    TYPE_STRING,
+    TYPE_POINTER,
+    TYPE_STAR
+};
+
+/**
+ * A conversion specification, as found in a format: %[flags][width][.precision][length]conversion
+ */
+
+struct Specification {
+    const char *flags;          // the flags, the width and the precision (the characters that follow "%")
+    size_t     flags_length;
+    int        stars;           // number of `*` (width and precision)
+    int        width;           // 0 if not specified (or given by an argument)
+    int        precision_star;  // the precision is given by an argument
+    int        precision;       // -1 if not specified (or given by an argument)
+    char       modifier[3];     // the length modifier ("hh", "h", "l", "ll", "L", "j", "z", "t" or "")
+    char       conversion;
+};
+
+static LAST_ERROR_THREAD_LOCAL struct LastErrorRecord LAST_ERROR = { .id = -1 };
+static LAST_ERROR_THREAD_LOCAL int                    LAST_ERROR_FORMATTED = 1;
+static LAST_ERROR_THREAD_LOCAL char                   LAST_ERROR_MESSAGE[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+
+/**
+ * @brief Parse a conversion specification.
+ * @param in_fmt Pointer to the first character that follows the character "%".
+ * @param out_specification The specification.
+ * @return A pointer to the first character that follows the specification, or NULL if the specification is
+ * not valid.
+ */
+
+static const char *
+parse_specification(
+        const char *in_fmt,
+        struct Specification *out_specification) {
+    const char *p = in_fmt;
+    size_t modifier_length = 0;
+
+    out_specification->flags          = p;
+    out_specification->stars          = 0;
+    out_specification->width          = 0;
+    out_specification->precision_star = 0;
+    out_specification->precision      = -1;
+
+    while (('\0' != *p) && (NULL != strchr("-+ #0'", *p))) p++;
+    if ('*' == *p) {
+        out_specification->stars += 1;
+        p++;
+    } else {
+        while ((*p >= '0') && (*p <= '9') && (out_specification->width < INT_MAX / 10)) {
+            out_specification->width = out_specification->width * 10 + (*p - '0');
+            p++;
+        }
+    }
+    if ('.' == *p) {
+        p++;
+        if ('*' == *p) {
+            out_specification->stars += 1;
+            out_specification->precision_star = 1;
+            p++;
+        } else {
+            out_specification->precision = 0;
+            while ((*p >= '0') && (*p <= '9') && (out_specification->precision < INT_MAX / 10)) {
+                out_specification->precision = out_specification->precision * 10 + (*p - '0');
+                p++;
+            }
+        }
+    }
+    out_specification->flags_length = (size_t)(p - in_fmt);
+
+    while (('\0' != *p) && (NULL != strchr("hlLjzt", *p)) && (modifier_length < 2)) {
+        out_specification->modifier[modifier_length++] = *p++;
+    }
+    out_specification->modifier[modifier_length] = 0;
+    out_specification->conversion = *p;
+    if ('\0' == *p) return NULL;
+    return p + 1;
+}
+
+#ifndef NDEBUG
+/**
+ * @brief Test whether a format contains a conversion specification (other than "%%").
+ * @param in_fmt The format.
+ * @return 1 if the format requires at least one argument. 0 otherwise.
+ */
+
+static int
+has_conversion(const char *in_fmt) {
+    for (const char *p = in_fmt; '\0' != *p; p++) {
+        if ('%' != *p) continue;
+        if ('%' != *++p) return 1;
+    }
+    return 0;
+}
+#endif
+
+/**
+ * @brief Return the number of characters of an integer written with `%d`.
+ * @param in_value The integer.
+ * @return The number of characters, including the sign.
+ */
+
+static size_t
+int_length(const int in_value) {
+    size_t length = in_value < 0 ? 2 : 1;
+    for (int value = in_value / 10; 0 != value; value /= 10) length++;
+    return length;
+}
+
+/**
+ * @brief Return an upper bound of the length of a converted value.
+ * @param in_specification The conversion specification.
+ * @param in_width The width (0 if not specified).
+ * @param in_precision The precision (-1 if not specified).
+ * @param in_string_length For `%s`, the length of the (copied) string.
+ * @return The upper bound, or `SIZE_MAX` if the length cannot be bounded cheaply (`%f`, or grouping of
+ * the thousands, which depends on the locale).
+ */
+
+static size_t
+conversion_length_max(
+        const struct Specification *in_specification,
+        const size_t in_width,
+        const int in_precision,
+        const size_t in_string_length) {
+    size_t length;
+    size_t precision = in_precision < 0 ? 0 : (size_t)in_precision;
+
+    if (NULL != memchr(in_specification->flags, '\'', in_specification->flags_length)) return SIZE_MAX;
+    switch (in_specification->conversion) {
+        case 'c':
+            length = 1;
+            break;
+        case 's':
+            length = in_string_length;
+            break;
+        case 'p':
+            length = INTEGER_LENGTH_MAX;
+            break;
+        case 'f':
+        case 'F':
+            return SIZE_MAX;
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            length = DOUBLE_LENGTH_MAX + precision;
+            break;
+        default:
+            length = INTEGER_LENGTH_MAX + precision;
+    }
+    return length > in_width ? length : in_width;
+}
+
+/**
+ * @brief Record an error, without formatting its message.
+ * @param in_record The record.
+ * @param in_error_id An integer that (hopefully) uniquely identifies the error.
+ * @param in_file The path to the (C) file that contains the code that raised the error (`__FILE__`).
+ * @param in_line The number of the line, within `in_file`, where the error was raised.
+ * @param in_function The name of the function that raised the error (`__func__`).
+ * @param in_fmt The format descriptor (a string literal).
+ * @param in_arguments The list of arguments.
+ * @return Upon successful completion, the function returns the value `success`.
+ * Otherwise, it returns the value `failure`: the format is not supported (too many arguments, or unknown
+ * conversion), or the message does not fit in `LAST_ERROR_MESSAGE_BUFFER_CAPACITY` bytes. In this case,
+ * the ID, the file, the line and the function are recorded, but the message will be empty.
+ * @note While the arguments are recorded, the function computes an upper bound of the length of the message.
+ * The message is formatted (into a temporary buffer) only if this bound exceeds the capacity of the buffer.
+ * The file and the function are not accounted for: if needed, `last_error_record_format()` truncates them.
+ */
+
+Status
+last_error_record_capture(
+        struct LastErrorRecord *in_record,
+        const int in_error_id,
+        const char *in_file,
+        const int in_line,
+        const char *in_function,
+        const char *in_fmt,
+        va_list in_arguments) {
+    const char *p = in_fmt;
+    unsigned int count = 0;
+    int last_star = -1;
+    size_t length_max = PREFIX_LENGTH_MAX + int_length(in_line);
+
+    in_record->id              = in_error_id;
+    in_record->line            = in_line;
+    in_record->file            = in_file;
+    in_record->function        = in_function;
+    in_record->fmt             = NULL; // set only if the arguments are recorded successfully
+    in_record->arguments_count = 0;
+    in_record->strings_length  = 0;
+
+    while ('\0' != *p) {
+        struct Specification specification;
+        unsigned char type;
+        size_t width;
+        size_t string_length = 0;
+
+        if ('%' != *p++) {
+            length_max++;
+            continue;
+        }
+        if ('%' == *p) {
+            length_max++;
+            p++;
+            continue;
+        }
+        p = parse_specification(p, &specification);
+        if (NULL == p) return failure;
+        if (count + (unsigned int)specification.stars + 1 > LAST_ERROR_ARGUMENTS_CAPACITY) return failure;
+
+        width = (size_t)specification.width;
+        for (int i = 0; i < specification.stars; i++) {
+            last_star = va_arg(in_arguments, int);
+            if ((0 == i) && ((2 == specification.stars) || !specification.precision_star)) {
+                // A negative width is a "-" flag followed by a positive width.
+                width = last_star < 0 ? (size_t)-(intmax_t)last_star : (size_t)last_star;
+            }
+            in_record->types[count] = TYPE_STAR;
+            in_record->values[count++].i = last_star;
+        }
+
+        switch (specification.conversion) {
+            case 'd':
+            case 'i':
+                type = TYPE_INT;
+                if (0 == strcmp(specification.modifier, "hh")) {
+                    in_record->values[count].i = (signed char) va_arg(in_arguments, int);
+                } else if (0 == strcmp(specification.modifier, "h")) {
+                    in_record->values[count].i = (short) va_arg(in_arguments, int);
+                } else if (0 == strcmp(specification.modifier, "l")) {
+                    in_record->values[count].i = va_arg(in_arguments, long);
+                } else if (0 == strcmp(specification.modifier, "ll")) {
+                    in_record->values[count].i = va_arg(in_arguments, long long);
+                } else if (0 == strcmp(specification.modifier, "j")) {
+                    in_record->values[count].i = va_arg(in_arguments, intmax_t);
+                } else if ((0 == strcmp(specification.modifier, "z")) || (0 == strcmp(specification.modifier, "t"))) {
+                    in_record->values[count].i = va_arg(in_arguments, ptrdiff_t);
+                } else {
+                    in_record->values[count].i = va_arg(in_arguments, int);
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                type = TYPE_UINT;
+                if (0 == strcmp(specification.modifier, "hh")) {
+                    in_record->values[count].u = (unsigned char) va_arg(in_arguments, unsigned int);
+                } else if (0 == strcmp(specification.modifier, "h")) {
+                    in_record->values[count].u = (unsigned short) va_arg(in_arguments, unsigned int);
+                } else if (0 == strcmp(specification.modifier, "l")) {
+                    in_record->values[count].u = va_arg(in_arguments, unsigned long);
+                } else if (0 == strcmp(specification.modifier, "ll")) {
+                    in_record->values[count].u = va_arg(in_arguments, unsigned long long);
+                } else if (0 == strcmp(specification.modifier, "j")) {
+                    in_record->values[count].u = va_arg(in_arguments, uintmax_t);
+                } else if ((0 == strcmp(specification.modifier, "z")) || (0 == strcmp(specification.modifier, "t"))) {
+                    in_record->values[count].u = va_arg(in_arguments, size_t);
+                } else {
+                    in_record->values[count].u = va_arg(in_arguments, unsigned int);
+                }
+                break;
+            case 'c':
+                if ('\0' != specification.modifier[0]) return failure; // wide characters are not supported
+                type = TYPE_CHAR;
+                in_record->values[count].i = va_arg(in_arguments, int);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (0 == strcmp(specification.modifier, "L")) {
+                    type = TYPE_LONG_DOUBLE;
+                    in_record->values[count].ld = va_arg(in_arguments, long double);
+                } else {
+                    type = TYPE_DOUBLE;
+                    in_record->values[count].d = va_arg(in_arguments, double);
+                }
+                break;
+            case 's': {
+                const char *string = va_arg(in_arguments, const char *);
+                int precision = specification.precision_star ? last_star : specification.precision;
+                size_t length;
+
+                if ('\0' != specification.modifier[0]) return failure; // wide strings are not supported
+                if (NULL == string) string = "(null)";
+                length = precision < 0 ? strlen(string) : strnlen(string, (size_t)precision);
+                if (in_record->strings_length + length + 1 > LAST_ERROR_STRINGS_CAPACITY) return failure;
+                type = TYPE_STRING;
+                memcpy(in_record->strings + in_record->strings_length, string, length);
+                in_record->strings[in_record->strings_length + length] = 0;
+                in_record->values[count].offset = in_record->strings_length;
+                in_record->strings_length += length + 1;
+                string_length = length;
+                break;
+            }
+            case 'p':
+                type = TYPE_POINTER;
+                in_record->values[count].p = va_arg(in_arguments, const void *);
+                break;
+            default:
+                // `%n`, `%C`, `%S`... are not supported.
+                return failure;
+        }
+        in_record->types[count++] = type;
+        {
+            size_t conversion_length = conversion_length_max(&specification,
+                                                             width,
+                                                             specification.precision_star
+                                                                 ? last_star
+                                                                 : specification.precision,
+                                                             string_length);
+            length_max = conversion_length > SIZE_MAX - length_max ? SIZE_MAX : length_max + conversion_length;
+        }
+    }
+
+    in_record->arguments_count = count;
+    in_record->fmt = in_fmt;
+    if (length_max >= LAST_ERROR_MESSAGE_BUFFER_CAPACITY) {
+        // The message may not fit in the buffer: format it to know for sure.
+        char message[LAST_ERROR_MESSAGE_BUFFER_CAPACITY];
+        if (failure == last_error_record_format(in_record, message, LAST_ERROR_MESSAGE_BUFFER_CAPACITY)) {
+            in_record->fmt = NULL;
+            in_record->arguments_count = 0;
+            return failure;
+        }
+    }
+    return success;
+}
+
+/**
+ * @brief Insert the prefix "#<ID> [<file>:<line> <function>()] " in front of a formatted message.
+ * @param in_record The record.
+ * @param in_buffer The buffer that contains the message.
+ * @param in_capacity The capacity of the buffer.
+ * @param in_length The length of the message.
+ * @return If the prefix, without the file and the function, does not fit in the buffer: `failure` (the buffer
+ * contains an empty string). Otherwise: `success`.
+ */
+
+static Status
+insert_prefix(
+        const struct LastErrorRecord *in_record,
+        char *in_buffer,
+        const size_t in_capacity,
+        const size_t in_length) {
+    const char *file     = NULL == in_record->file ? "(null)" : in_record->file;
+    const char *function = NULL == in_record->function ? "(null)" : in_record->function;
+    const size_t id_length = int_length(in_record->id);
+    // "#" + ID + " [" + ":" + line + " " + "()] "
+    const size_t fixed_length = 9 + (id_length > 10 ? id_length : 10) + int_length(in_record->line);
+    size_t file_length     = strlen(file);
+    size_t function_length = strlen(function);
+    size_t available;
+    size_t prefix_length;
+    char first;
+
+    if (fixed_length + in_length >= in_capacity) {
+        in_buffer[0] = 0;
+        return failure;
+    }
+    available = in_capacity - 1 - fixed_length - in_length;
+    if (function_length > available) function_length = available;
+    available -= function_length;
+    if (file_length > available) {
+        file += file_length - available;
+        file_length = available;
+    }
+    prefix_length = fixed_length + file_length + function_length;
+
+    // `snprintf()` terminates the prefix with a zero: it overwrites the first character of the message.
+    memmove(in_buffer + prefix_length, in_buffer, in_length + 1);
+    first = in_buffer[prefix_length];
+    snprintf(in_buffer,
+             prefix_length + 1,
+             "#%010d [%.*s:%d %.*s()] ",
+             in_record->id,
+             (int) file_length,
+             file,
+             in_record->line,
+             (int) function_length,
+             function);
+    in_buffer[prefix_length] = first;
+    return success;
+}
+
+/**
+ * @brief Format the message of a recorded error.
+ * @param in_record The record.
+ * @param in_buffer The buffer used to store the message.
+ * @param in_capacity The capacity of the buffer.
+ * @return Upon successful completion, the function returns the value `success`.
+ * Otherwise, it returns the value `failure`. This means that the buffer is not big enough, or that the
+ * arguments could not be recorded. In this case, the buffer contains an empty string.
+ * @note The message is formatted first. If the prefix does not fit in the remaining capacity, then the function
+ * name is shortened, and only the end of the file path is kept.
+ */
+
+Status
+last_error_record_format(
+        const struct LastErrorRecord *in_record,
+        char *in_buffer,
+        const size_t in_capacity) {
+    int    bytes_written;
+    size_t length = 0;
+    unsigned int index = 0;
+    const char *p = in_record->fmt;
+
+    if ((NULL == p) || (0 == in_capacity)) {
+        if (in_capacity > 0) in_buffer[0] = 0;
+        return failure;
+    }
+
+    // NOTE:
+    //
+    // The function `vsnprintf(char *str, size_t size, const char *format, va_list ap)`
+    // writes at most `size` bytes (including the terminating null byte.
+    //
+    // The function `vsnprintf()` does not write more than `size` bytes
+    // (including the terminating null byte ('\0')). If the output was truncated
+    // due to this limit then the return value is the number of characters (excluding
+    // the terminating null byte) which would have been written to the final string if
+    // enough space had been available. Thus, a return value of `size` or more means that
+    // the output was truncated.
+    //
+    // `snprintf()` behaves the same way.
+    while ('\0' != *p) {
+        struct Specification specification;
+        char spec[SPECIFICATION_CAPACITY];
+        int  stars[2] = { 0, 0 };
+        char *out = in_buffer + length;
+        size_t remaining_capacity = in_capacity - length;
+        const union LastErrorValue *value;
+
+        // Copy the text, up to the next conversion specification.
+        if ('%' != *p) {
+            if (remaining_capacity <= 1) {
+                in_buffer[0] = 0;
+                return failure;
+            }
+            in_buffer[length++] = *p++;
+            continue;
+        }
+        p++;
+        if ('%' == *p) {
+            if (remaining_capacity <= 1) {
+                in_buffer[0] = 0;
+                return failure;
+            }
+            in_buffer[length++] = *p++;
+            continue;
+        }
+        p = parse_specification(p, &specification);
+        if ((specification.flags_length + 4 > SPECIFICATION_CAPACITY)
+            || (index + (unsigned int)specification.stars >= in_record->arguments_count)) {
+            in_buffer[0] = 0;
+            return failure;
+        }
+
+        // Rewrite the specification. All the integers are stored as `intmax_t` or `uintmax_t`.
+        spec[0] = '%';
+        memcpy(spec + 1, specification.flags, specification.flags_length);
+        {
+            char *s = spec + 1 + specification.flags_length;
+            if ((TYPE_INT == in_record->types[index + (unsigned int)specification.stars])
+                || (TYPE_UINT == in_record->types[index + (unsigned int)specification.stars])) {
+                *s++ = 'j';
+            } else if (TYPE_LONG_DOUBLE == in_record->types[index + (unsigned int)specification.stars]) {
+                *s++ = 'L';
+            }
+            *s++ = specification.conversion;
+            *s = 0;
+        }
+
+        for (int i = 0; i < specification.stars; i++) {
+            stars[i] = (int) in_record->values[index++].i;
+        }
+        value = &in_record->values[index];
+
+#define FORMAT_VALUE(v) \
+        ((0 == specification.stars) ? snprintf(out, remaining_capacity, spec, v) : \
+         (1 == specification.stars) ? snprintf(out, remaining_capacity, spec, stars[0], v) : \
+                                      snprintf(out, remaining_capacity, spec, stars[0], stars[1], v))
+
+        switch (in_record->types[index]) {
+            case TYPE_INT:         bytes_written = FORMAT_VALUE(value->i); break;
+            case TYPE_UINT:        bytes_written = FORMAT_VALUE(value->u); break;
+            case TYPE_CHAR:        bytes_written = FORMAT_VALUE((int) value->i); break;
+            case TYPE_DOUBLE:      bytes_written = FORMAT_VALUE(value->d); break;
+            case TYPE_LONG_DOUBLE: bytes_written = FORMAT_VALUE(value->ld); break;
+            case TYPE_STRING:      bytes_written = FORMAT_VALUE(in_record->strings + value->offset); break;
+            default:               bytes_written = FORMAT_VALUE(value->p); break;
+        }
+#undef FORMAT_VALUE
+        index++;
+
+        if ((bytes_written < 0) || ((size_t)bytes_written >= remaining_capacity)) {
+            in_buffer[0] = 0;
+            return failure;
+        }
+        length += (size_t)bytes_written;
+    }
+    in_buffer[length] = 0;
+    return insert_prefix(in_record, in_buffer, in_capacity, length);
+}
+
+/**
+ * @brief Copy a record.
+ * @param out_record The copy.
+ * @param in_record The record to copy.
+ * @note Only the arguments and the part of the strings buffer that are used are copied.
+ */
+
+void
+last_error_record_copy(
+        struct LastErrorRecord *out_record,
+        const struct LastErrorRecord *in_record) {
+    memcpy(out_record, in_record, offsetof(struct LastErrorRecord, values));
+    memcpy(out_record->values, in_record->values, sizeof(union LastErrorValue) * in_record->arguments_count);
+    out_record->strings_length = in_record->strings_length;
+    memcpy(out_record->strings, in_record->strings, in_record->strings_length);
+}
+
+/**
+ * @brief Format a line of log: the (UTC) date of the error, followed by its message.
+ *
+ *      2023-03-12 10:00:00.123456 #0000000001 [/path/to/file.c:10 function()] message
+ *
+ * @param in_record The error.
+ * @param in_date The date of the error.
+ * @param in_buffer The buffer used to store the line. Its capacity must be (at least)
+ * `LAST_ERROR_LINE_CAPACITY` bytes.
+ * @return The length of the line (which ends with a new line character). The line is not zero terminated.
+ * @note If the message is too long, then the line contains "(no message)" instead.
+ */
+
+size_t
+last_error_record_format_line(
+        const struct LastErrorRecord *in_record,
+        const struct timespec *in_date,
+        char *in_buffer) {
+    size_t length;
+    struct tm date;
+
+    gmtime_r(&in_date->tv_sec, &date);
+    length = strftime(in_buffer, LAST_ERROR_LINE_CAPACITY, "%Y-%m-%d %H:%M:%S", &date);
+    length += (size_t)snprintf(in_buffer + length,
+                               LAST_ERROR_LINE_CAPACITY - length,
+                               ".%06ld ",
+                               in_date->tv_nsec / 1000);
+    if (failure == last_error_record_format(in_record,
+                                            in_buffer + length,
+                                            LAST_ERROR_MESSAGE_BUFFER_CAPACITY)) {
+        // The message is too long: keep the identification of the error.
+        snprintf(in_buffer + length,
+                 LAST_ERROR_MESSAGE_BUFFER_CAPACITY,
+                 "#%010d [%s:%d %s()] (no message)",
+                 in_record->id,
+                 in_record->file,
+                 in_record->line,
+                 in_record->function);
+    }
+    length += strlen(in_buffer + length);
+    in_buffer[length++] = '\n';
+    return length;
+}
+
+/**
+ * @brief Initialize the last error of the calling thread.
+ */
+
+void
+last_error_init() {
+    LAST_ERROR.id        = -1;
+    LAST_ERROR.line      = 0;
+    LAST_ERROR.file      = NULL;
+    LAST_ERROR.function  = NULL;
+    LAST_ERROR.fmt       = NULL;
+    LAST_ERROR_FORMATTED  = 1;
+    LAST_ERROR_MESSAGE[0] = 0;
+}
+
+/**
+ * @brief Return the ID of the last error.
+ * @return The ID of the last error.
+ */
+
+int
+last_error_get_id() {
+    return LAST_ERROR.id;
+}
+
+/**
+ * @brief Return the message associated with the last error.
+ * @return The message associated with the last error. If the message does not fit in the buffer, then
+ * the returned string is empty.
+ * @note The message is formatted by the first call to this function (after the error has been set).
+ */
+
+char *
+last_error_get_message() {
+    if (! LAST_ERROR_FORMATTED) {
+        last_error_record_format(&LAST_ERROR,
+                                 LAST_ERROR_MESSAGE,
+                                 LAST_ERROR_MESSAGE_BUFFER_CAPACITY);
+        LAST_ERROR_FORMATTED = 1;
+    }
+    return LAST_ERROR_MESSAGE;
+}
+
+/**
+ * @brief Return the path to the file where the error occurred.
+ * @return The path to the file where the error occurred.
+ */
+
+const char *
+last_error_file() {
+    return NULL == LAST_ERROR.file ? "" : LAST_ERROR.file;
+}
+
+int
+last_error_line() {
+    return LAST_ERROR.line;
+}
+
+/**
+ * @brief Set the last error.
+ * @param in_error_id An integer that (hopefully) uniquely identifies the error.
+ * @param in_file The *ABSOLUTE* path to the (C) file that contains the code that raised the error.
+ * This must be a string literal (typically `__FILE__`): it is not copied.
+ * @param in_line The number of the line, within `in_file`, where the error was raised.
+ * @param in_function The name of the function that raised the error.
+ * This must be a string literal (typically `__func__`): it is not copied.
+ * @param in_fmt The format descriptor. This must be a string literal: it is not copied.
+ * @param ... The list of arguments.
+ * @return Upon successful completion, the function returns the value `success`.
+ * Otherwise, it returns the value `failure`. This means that the message does not fit in the buffer used
+ * to store it (or that the format is not supported). In this case, the message is an empty string.
+ * @note The message is not formatted by this function, unless it may be too long (see
+ * `last_error_record_capture()`): the length is checked here, not by `last_error_get_message()`.
+ * @note The return value is likely to be ignored by the calling code. Indeed, this function is intended
+ * to be used to store information about an error. We assume that it will do its job just fine.
+ */
+
+Status
+last_error_set(
+        const int in_error_id,
+        const char *in_file,
+        int in_line,
+        const char *in_function,
+        const char *in_fmt,
+        ...) {
+    Status status;
+
+    // The message is formatted later, by `last_error_get_message()`. Here, we only record the arguments.
+
+    va_list arg_ptr;
+    va_start(arg_ptr, in_fmt);
+    status = last_error_record_capture(&LAST_ERROR,
+                                       in_error_id,
+                                       in_file,
+                                       in_line,
+                                       in_function,
+                                       in_fmt,
+                                       arg_ptr);
+    va_end(arg_ptr);
+    LAST_ERROR_FORMATTED = 0;
+    error_history_push(&LAST_ERROR);
+    error_stats_record(&LAST_ERROR);
+    error_sink_push(&LAST_ERROR);
+    return status;
+}
+
+/**
+ * @brief Set the last error, for an error which format does not require any argument.
+ * @param in_error_id An integer that (hopefully) uniquely identifies the error.
+ * @param in_file The *ABSOLUTE* path to the (C) file that contains the code that raised the error.
+ * This must be a string literal (typically `__FILE__`): it is not copied.
+ * @param in_line The number of the line, within `in_file`, where the error was raised.
+ * @param in_function The name of the function that raised the error.
+ * This must be a string literal (typically `__func__`): it is not copied.
+ * @param in_fmt The format descriptor. This must be a string literal which does not contain any conversion
+ * specification (if it does, then the message will be empty). This is checked by an assertion, unless
+ * `NDEBUG` is defined.
+ * @return The function always returns the value `success`.
+ * @note Nothing is parsed, formatted or copied: use this function (or the macro `ERROR_SET0()` defined in
+ * "errors.h") for the errors that are expected to be frequent.
+ */
+
+Status
+last_error_set_id(
+        const int in_error_id,
+        const char *in_file,
+        const int in_line,
+        const char *in_function,
+        const char *in_fmt) {
+#ifndef NDEBUG
+    assert(! has_conversion(in_fmt) && "the format of the error requires arguments: use ERROR_SET()");
+#endif
+    LAST_ERROR.id              = in_error_id;
+    LAST_ERROR.line            = in_line;
+    LAST_ERROR.file            = in_file;
+    LAST_ERROR.function        = in_function;
+    LAST_ERROR.fmt             = in_fmt;
+    LAST_ERROR.arguments_count = 0;
+    LAST_ERROR.strings_length  = 0;
+    LAST_ERROR_FORMATTED = 0;
+    error_history_push(&LAST_ERROR);
+    error_stats_record(&LAST_ERROR);
+    error_sink_push(&LAST_ERROR);
+    return success;
+}
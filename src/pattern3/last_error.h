@@ -0,0 +1,126 @@
+#ifndef C_PATTERNS_LAST_ERROR_H
+#define C_PATTERNS_LAST_ERROR_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "common.h"
+
+#define LAST_ERROR_MESSAGE_BUFFER_CAPACITY 128 // should be bigger in real life
+// Maximum number of arguments (including the `*` widths and precisions) for one error.
+#define LAST_ERROR_ARGUMENTS_CAPACITY 16
+// Maximum number of bytes used to store the strings given as arguments.
+// Since the strings are included in the message, a bigger capacity would not be useful.
+#define LAST_ERROR_STRINGS_CAPACITY LAST_ERROR_MESSAGE_BUFFER_CAPACITY
+// Maximum length of a line written into a log: the date, followed by the message.
+#define LAST_ERROR_LINE_CAPACITY (LAST_ERROR_MESSAGE_BUFFER_CAPACITY + 64)
+
+// Each thread has its own last error.
+// `_Thread_local` is standard since C11. Before that, use the compilers extensions.
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define LAST_ERROR_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define LAST_ERROR_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define LAST_ERROR_THREAD_LOCAL __declspec(thread)
+#else
+#error "Thread local storage is not supported by this compiler."
+#endif
+
+/**
+ * The value of an argument, as found in the list of arguments given to `last_error_set()`.
+ */
+
+union LastErrorValue {
+    intmax_t    i;      // `%d`, `%i`, `%c` and `*`
+    uintmax_t   u;      // `%u`, `%o`, `%x` and `%X`
+    double      d;      // `%f`, `%e`, `%g` and `%a`
+    long double ld;     // same, with the `L` modifier
+    const void  *p;     // `%p`
+    size_t      offset; // `%s`: offset of the (copied) string within `LastErrorRecord.strings`
+};
+
+/**
+ * Everything required to build the message of an error. Nothing is formatted.
+ *
+ * The file, the function and the format are not copied: they are expected to be string literals
+ * (`__FILE__`, `__func__`...). The strings given as arguments, on the other hand, are copied.
+ */
+
+struct LastErrorRecord {
+    int                  id;
+    int                  line;
+    const char           *file;
+    const char           *function;
+    const char           *fmt;
+    unsigned int         arguments_count;
+    unsigned char        types[LAST_ERROR_ARGUMENTS_CAPACITY];
+    union LastErrorValue values[LAST_ERROR_ARGUMENTS_CAPACITY];
+    size_t               strings_length;
+    char                 strings[LAST_ERROR_STRINGS_CAPACITY];
+};
+
+void
+last_error_init();
+
+int
+last_error_get_id();
+
+char *
+last_error_get_message();
+
+const char *
+last_error_file();
+
+int
+last_error_line();
+
+// Set the last error of the calling thread. The message is not formatted (see `last_error_get_message()`),
+// but its length is checked: if the message does not fit in `LAST_ERROR_MESSAGE_BUFFER_CAPACITY` bytes, then
+// the function returns `failure`, and the message of the error is empty.
+Status
+last_error_set(
+        int in_error_id,
+        const char *in_file,
+        int in_line,
+        const char *in_function,
+        const char *in_fmt,
+        ...);
+
+Status
+last_error_set_id(
+        int in_error_id,
+        const char *in_file,
+        int in_line,
+        const char *in_function,
+        const char *in_fmt);
+
+Status
+last_error_record_capture(
+        struct LastErrorRecord *in_record,
+        int in_error_id,
+        const char *in_file,
+        int in_line,
+        const char *in_function,
+        const char *in_fmt,
+        va_list in_arguments);
+
+Status
+last_error_record_format(
+        const struct LastErrorRecord *in_record,
+        char *in_buffer,
+        size_t in_capacity);
+
+void
+last_error_record_copy(
+        struct LastErrorRecord *out_record,
+        const struct LastErrorRecord *in_record);
+
+size_t
+last_error_record_format_line(
+        const struct LastErrorRecord *in_record,
+        const struct timespec *in_date,
+        char *in_buffer);
+
+#endif //C_PATTERNS_LAST_ERROR_H
@@ -9,12 +9,13 @@
  * To see the source after the macro expansions: gcc -E pattern4.c
  */
 #include <stdio.h>
+#include <fcntl.h>
 
 // Please note:
 // The macro "RESOURCES_TYPES" used the macro "DECLARE" that is not declared yet.
 // The macro "DECLARE" is declared in the file "pattern4.h".
 #define RESOURCES_TYPES  \
-DECLARE(DMysql, "mysql")
+DECLARE(DMysql, "mysql", RM_conn_handler, 0, 8)
 
 // This header file "pattern4.h" must be included *AFTER* the definition of the macro "RESOURCES_TYPES".
 #include "pattern4.h"
@@ -22,6 +23,12 @@ DECLARE(DMysql, "mysql")
 // At this point, the header file "pattern4.h" defines the following entities:
 // enum Resource { DMem, DFile, DMysql, EOR }; // EOR: End Of Resources (so you can iterate on the enums)
 // char *resource_name[] = { "mem", "file", DMysql", NULL }
+// const size_t resource_name_length[] = { 3, 4, 5, 0 }
+// const RM_ResourceHandler handlers[EOR] = { { RM_mem_handler_init, ... }, ... } // handlers[DMem].borrow(...)
+// const size_t resource_object_size[EOR] = { 4096, 0, 0 }
+// const size_t resource_capacity[EOR] = { 64, 64, 8 }
+// enum Resource resource_lookup(const char *in_name) // "mysql" => DMysql
+// struct ResourceSet { uint64_t words[1]; } // a set of resource types
 
 int main() {
     int e = 0;
@@ -29,6 +36,73 @@ int main() {
         printf("%s\n", resource_name[e]);
         e += 1;
     }
+
+    // Find the resources from their names (the first lookup builds the table).
+    if (DFile != resource_lookup("file")) return 1;
+    if (0 != resource_index_init()) return 1;
+    for (e = 0; e != EOR; e++) {
+        if (e != (int) resource_lookup(resource_name[e])) return 1;
+    }
+    if ((EOR != resource_lookup("my")) || (EOR != resource_lookup("mysql2")) || (EOR != resource_lookup(""))) return 1;
+    printf("lookup: \"mysql\" => %d\n", resource_lookup("mysql"));
+
+    // Borrow resources through the table of handlers.
+    {
+        unsigned char *buffer;
+        void *connection;
+        int *fd;
+
+        if (RM_failure == resources_init()) return 1;
+        if (RM_failure == RESOURCE_BORROW(DMem, &buffer, 1, RM_true)) return 1;
+        for (size_t i = 0; i < resource_object_size[DMem]; i++) {
+            if (0 != buffer[i]) return 1;
+        }
+        printf("borrow: %s (%zu bytes)\n", resource_name[DMem], resource_object_size[DMem]);
+        if (RM_failure == RESOURCE_GIVE_BACK(DMem, &buffer, 2)) return 1;
+        if (RM_failure == RESOURCE_GIVE_BACK(DMem, &buffer, 2)) return 1; // it does not harm
+        {
+            void *buffers[4];
+            if (RM_failure == RESOURCE_BORROW_MANY(DMem, buffers, 4, 6, RM_false)) return 1;
+            printf("borrow many: %s (4 buffers)\n", resource_name[DMem]);
+            if (RM_failure == RESOURCE_GIVE_BACK_MANY(DMem, buffers, 4, 7)) return 1;
+        }
+        if (RM_failure == RESOURCE_BORROW(DFile, &fd, 4, RM_true, "/dev/null", O_RDONLY)) return 1;
+        printf("borrow: %s (descriptor %d)\n", resource_name[DFile], *fd);
+        if (RM_failure == RESOURCE_GIVE_BACK(DFile, &fd, 5)) return 1;
+        // No connection factory is configured for the type "mysql" (see "pattern8.c"): borrowing fails.
+        if (RM_success == RESOURCE_BORROW(DMysql, &connection, 3, RM_false)) return 1;
+        resources_terminate();
+    }
+
+    // Sets of resource types.
+    {
+        struct ResourceSet held   = RESOURCE_SET_EMPTY;
+        struct ResourceSet needed = RESOURCE_SET_EMPTY;
+        struct ResourceSet both;
+        struct ResourceSet all;
+        char text[RESOURCE_SET_STRING_CAPACITY + 1];
+        char needed_text[RESOURCE_SET_STRING_CAPACITY + 1];
+        char both_text[RESOURCE_SET_STRING_CAPACITY + 1];
+
+        resource_set_add(&held, DMem);
+        resource_set_add(&held, DFile);
+        resource_set_add(&needed, DMysql);
+        resource_set_add(&needed, DMem);
+        both = resource_set_intersection(&held, &needed);
+        all  = resource_set_union(&held, &needed);
+        printf("held: %s, needed: %s, both: %s\n",
+               resource_set_to_string(&held, text),
+               resource_set_to_string(&needed, needed_text),
+               resource_set_to_string(&both, both_text));
+        if ((1 != resource_set_count(&both)) || (! resource_set_contains(&both, DMem))) return 1;
+        if ((EOR != resource_set_count(&all)) || (! resource_set_contains_all(&all, &held))) return 1;
+        if (resource_set_contains_all(&held, &needed)) return 1;
+        if (0 != strcmp("{mem,file,mysql}", resource_set_to_string(&all, text))) return 1;
+        resource_set_remove(&all, DFile);
+        if ((DMysql != resource_set_next(&all, resource_set_first(&all))) || resource_set_contains(&all, DFile)) return 1;
+        resource_set_remove(&both, DMem);
+        if ((! resource_set_is_empty(&both)) || (EOR != resource_set_first(&both))) return 1;
+    }
     return 0;
 }
 
@@ -1,21 +1,37 @@
 #ifndef C_PATTERNS_PATTERN4_H
 #define C_PATTERNS_PATTERN4_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "resource_manager/resource_manager.h"
+#include "resource_manager/rm_mem.h"
+#include "resource_manager/rm_file.h"
+#include "resource_manager/rm_conn.h"
+
 #ifndef RESOURCES_TYPES
 #error "You must declare a set of ressources by defined the macro RESOURCES_TYPES."
 #endif
 
+// DECLARE(<enum>, <name>, <handler>, <object size>, <capacity>)
+// - <handler>: prefix of the functions that manage the resources (see `RM_ResourceHandler`).
+//   For example, `RM_mem_handler` => `RM_mem_handler_init()`, `RM_mem_handler_borrow()`...
+//   The handler `RM_none_handler` is used by the resource types that have no implementation yet.
+// - <object size>: the size of a resource, given to the handler (the meaning depends on the handler).
+// - <capacity>: the maximum number of resources borrowed at the same time, given to the handler.
 #define BASE_RESOURCES_TYPES \
-DECLARE(DMem, "mem")  \
-DECLARE(DFile, "file")
+DECLARE(DMem, "mem", RM_mem_handler, 4096, 64)  \
+DECLARE(DFile, "file", RM_file_handler, 0, 64)
 
 // Please note:
-// The line `#define DECLARE(a, b) a` defines a simple macro (called "DECLARE") that replaces "(V1, V2)" into "V1,".
-#define DECLARE(a, b) a,
+// The line `#define DECLARE(a, b, h, s, c) a` defines a simple macro (called "DECLARE") that replaces
+// "(V1, V2, V3, V4, V5)" into "V1,".
+#define DECLARE(a, b, h, s, c) a,
 enum Resource {
     // The macro "BASE_RESOURCES_TYPES" uses the macro "DECLARE". Thus, the macro "DECLARE" is evaluated:
-    //    `DECLARE(DMem,   "mem")`   => DMem,
-    //    `DECLARE(DFile,  "file")`  => DFile,
+    //    `DECLARE(DMem,   "mem", ...)`   => DMem,
+    //    `DECLARE(DFile,  "file", ...)`  => DFile,
     // The same goes for the macro "RESOURCES_TYPES".
     // And thus: `enum Resource { BASE_RESOURCES_TYPES RESOURCES_TYPES }` => "enum Resource { DMem, DFile, DMysql, EOR }"
     BASE_RESOURCES_TYPES
@@ -30,12 +46,13 @@ enum Resource resources[] = {
 #undef DECLARE
 
 // Please note:
-// The line `#define DECLARE(a, b) b` defines a simple macro (called "DECLARE") that replaces "(V1, V2)" into "V2,".
-#define DECLARE(a, b) b,
+// The line `#define DECLARE(a, b, h, s, c) b` defines a simple macro (called "DECLARE") that replaces
+// "(V1, V2, V3, V4, V5)" into "V2,".
+#define DECLARE(a, b, h, s, c) b,
 char *resource_name[] = {
         // The macro "BASE_RESOURCES_TYPES" uses the macro "DECLARE". Thus, the macro "DECLARE" is evaluated:
-        //    `DECLARE(DMem,   "mem")`   => "mem",
-        //    `DECLARE(DFile,  "file")`  => "file",
+        //    `DECLARE(DMem,   "mem", ...)`   => "mem",
+        //    `DECLARE(DFile,  "file", ...)`  => "file",
         // The same goes for the macro "RESOURCES_TYPES".
         // And thus: `char *resource_name[] = { BASE_RESOURCES_TYPES RESOURCES_TYPES }` => "char *resource_name[] = { "mem", "file", DMysql", }"
         BASE_RESOURCES_TYPES
@@ -44,10 +61,462 @@ char *resource_name[] = {
 };
 #undef DECLARE
 
+// Please note:
+// The line `#define DECLARE(a, b, h, s, c) (sizeof(b) - 1)` replaces "(V1, V2, V3, V4, V5)" into the length of
+// the string V2. The lengths are computed by the compiler.
+#define DECLARE(a, b, h, s, c) (sizeof(b) - 1),
+const size_t resource_name_length[] = {
+        BASE_RESOURCES_TYPES
+        RESOURCES_TYPES
+        0
+};
+#undef DECLARE
+
+// Please note:
+// The operator "##" pastes two tokens: `DECLARE(DMem, "mem", RM_mem_handler, 4096, 64)` =>
+// `{ RM_mem_handler_init, RM_mem_handler_borrow, RM_mem_handler_give_back, RM_mem_handler_borrow_many, ... },`
+// The handler of a resource is found by indexing the table: `handlers[DMem].borrow(...)` (there is no `switch`).
+#define DECLARE(a, b, h, s, c) \
+    { h##_init, h##_borrow, h##_give_back, h##_borrow_many, h##_give_back_many, h##_terminate },
+const RM_ResourceHandler handlers[EOR] = {
+        BASE_RESOURCES_TYPES
+        RESOURCES_TYPES
+};
+#undef DECLARE
+
+#define DECLARE(a, b, h, s, c) (s),
+const size_t resource_object_size[EOR] = {
+        BASE_RESOURCES_TYPES
+        RESOURCES_TYPES
+};
+#undef DECLARE
+
+#define DECLARE(a, b, h, s, c) (c),
+const size_t resource_capacity[EOR] = {
+        BASE_RESOURCES_TYPES
+        RESOURCES_TYPES
+};
+#undef DECLARE
+
 
 
 // =>
 // enum Resource { DMem, DFile, DMysql, EOR };
 // char *resource_name[] = { "mem", "file", DMysql", NULL }
+// const size_t resource_name_length[] = { 3, 4, 5, 0 }
+// const RM_ResourceHandler handlers[EOR] = { { RM_mem_handler_init, ... }, { RM_file_handler_init, ... }, ... }
+// const size_t resource_object_size[EOR] = { 4096, 0, ... }
+// const size_t resource_capacity[EOR] = { 64, 64, ... }
+
+// Borrow and give back resources through the table of handlers.
+// The arguments that follow the UID are `in_init`, and then the arguments specific to the handler (if any).
+//
+//      void *buffer;
+//      int *fd;
+//      if (RM_failure == RESOURCE_BORROW(DMem, &buffer, 1, RM_false)) { ... }
+//      if (RM_failure == RESOURCE_BORROW(DFile, &fd, 2, RM_true, "/etc/hosts", O_RDONLY)) { ... }
+//      ...
+//      RESOURCE_GIVE_BACK(DFile, &fd, 3);
+//      RESOURCE_GIVE_BACK(DMem, &buffer, 4);
+#define RESOURCE_BORROW(type, ptr, uid, ...) \
+    handlers[(type)].borrow((void **) (ptr), (uid), __FILE__, __LINE__, (char *) __func__, __VA_ARGS__)
+#define RESOURCE_GIVE_BACK(type, ptr, uid) \
+    handlers[(type)].give_back((void **) (ptr), (uid), __FILE__, __LINE__, (char *) __func__)
+
+// Borrow (or give back) several resources of the same type at once: all or nothing.
+//
+//      void *buffers[4];
+//      if (RM_failure == RESOURCE_BORROW_MANY(DMem, buffers, 4, 5, RM_false)) { ... }
+//      ...
+//      RESOURCE_GIVE_BACK_MANY(DMem, buffers, 4, 6);
+#define RESOURCE_BORROW_MANY(type, ptrs, count, uid, ...) \
+    handlers[(type)].borrow_many((void **) (ptrs), (count), (uid), __FILE__, __LINE__, (char *) __func__, __VA_ARGS__)
+#define RESOURCE_GIVE_BACK_MANY(type, ptrs, count, uid) \
+    handlers[(type)].give_back_many((void **) (ptrs), (count), (uid), __FILE__, __LINE__, (char *) __func__)
+
+/**
+ * @brief Initialize the handlers of all the resource types (using the declared object sizes and capacities).
+ * @return On success: RM_success. Otherwise: RM_failure.
+ */
+
+static inline RM_Status
+resources_init() {
+    for (int e = 0; e < EOR; e++) {
+        if (RM_failure == handlers[e].init(resource_object_size[e], resource_capacity[e])) return RM_failure;
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Release all the resources allocated by the handlers.
+ * @note Please note that you can call this function multiple times.
+ */
+
+static inline void
+resources_terminate() {
+    for (int e = 0; e < EOR; e++) {
+        handlers[e].terminate();
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Find a resource from its name, without comparing the name with all the names: `resource_lookup("mysql") => DMysql`.
+//
+// The names are stored in a perfect hash table (there is no collision): a lookup computes one hash, reads one
+// slot and compares one name. The table is built from `resource_name[]`, so it includes the resources declared
+// by `RESOURCES_TYPES`.
+//
+// Please note: the preprocessor cannot compute the hash of a string. Thus, the table is sized at compilation
+// time, but it is filled at run time, by the first lookup (or by `resource_index_init()`, which tells whether the
+// table could be built). Each translation unit that includes this file has its own copy of the table.
+//
+// The hash function is "hash and displace": the hash of a name selects a bucket, and each bucket has a
+// displacement that moves its names into free slots.
+//
+//      hash       = FNV-1a(seed, name)
+//      bucket     = (hash >> 32) % RESOURCE_HASH_BUCKETS
+//      slot       = (low32(hash) + displacement[bucket] * ((hash >> 32) | 1)) & (RESOURCE_HASH_CAPACITY - 1)
+// ---------------------------------------------------------------------------------------------------------------------
+
+// Number of slots: the smallest power of 2 greater than or equal to 2 x EOR (a slot out of two is free).
+#define RESOURCE_HASH_SMEAR1(n) ((n) | ((n) >> 1))
+#define RESOURCE_HASH_SMEAR2(n) (RESOURCE_HASH_SMEAR1(n) | (RESOURCE_HASH_SMEAR1(n) >> 2))
+#define RESOURCE_HASH_SMEAR4(n) (RESOURCE_HASH_SMEAR2(n) | (RESOURCE_HASH_SMEAR2(n) >> 4))
+#define RESOURCE_HASH_SMEAR8(n) (RESOURCE_HASH_SMEAR4(n) | (RESOURCE_HASH_SMEAR4(n) >> 8))
+#define RESOURCE_HASH_CAPACITY (RESOURCE_HASH_SMEAR8(2 * EOR - 1) + 1)
+// Number of buckets: 4 names per bucket on average.
+#define RESOURCE_HASH_BUCKETS ((EOR + 3) / 4)
+// Number of seeds tried before giving up (it only happens if two resources have the same name).
+#define RESOURCE_HASH_SEEDS 32
+// Maximum number of names in a bucket.
+#define RESOURCE_HASH_BUCKET_MAX_SIZE 16
+
+static uint64_t       resource_hash_seed = 0;
+static uint32_t       resource_hash_displacement[RESOURCE_HASH_BUCKETS];
+static enum Resource  resource_hash_table[RESOURCE_HASH_CAPACITY]; // EOR: free slot
+static int            resource_hash_ready  = 0;  // the table is built (set once, see `resource_index_once()`)
+static int            resource_hash_status = -1; // the value returned by `resource_index_init()`
+static pthread_once_t resource_hash_once   = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Hash a name.
+ * @param in_name The name.
+ * @param in_seed The seed.
+ * @param out_length Pointer to a variable used to store the length of the name.
+ * @return The hash.
+ */
+
+static inline uint64_t
+resource_hash(
+        const char *in_name,
+        const uint64_t in_seed,
+        size_t *out_length) {
+    uint64_t hash = 14695981039346656037ULL ^ in_seed;
+    const char *c = in_name;
+
+    while (0 != *c) {
+        hash ^= (unsigned char) *c++;
+        hash *= 1099511628211ULL;
+    }
+    *out_length = (size_t)(c - in_name);
+    return hash ^ (hash >> 29);
+}
+
+static inline uint32_t
+resource_hash_slot(
+        const uint64_t in_hash,
+        const uint32_t in_displacement) {
+    const uint32_t low  = (uint32_t)in_hash;
+    const uint32_t high = (uint32_t)(in_hash >> 32);
+    return (low + in_displacement * (high | 1)) & (RESOURCE_HASH_CAPACITY - 1);
+}
+
+/**
+ * @brief Try to build the hash table for a given seed.
+ * @param in_seed The seed.
+ * @return If the table has been built, the function returns the value 1. Otherwise, it returns the value 0.
+ */
+
+static inline int
+resource_index_build(const uint64_t in_seed) {
+    uint64_t hashes[EOR];
+    int      next[EOR];   // the names of a bucket are chained
+    int      heads[RESOURCE_HASH_BUCKETS];
+    int      sizes[RESOURCE_HASH_BUCKETS];
+    size_t   length;
+
+    for (int b = 0; b < RESOURCE_HASH_BUCKETS; b++) {
+        heads[b] = -1;
+        sizes[b] = 0;
+        resource_hash_displacement[b] = 0;
+    }
+    for (int s = 0; s < RESOURCE_HASH_CAPACITY; s++) {
+        resource_hash_table[s] = EOR;
+    }
+    for (int e = 0; e < EOR; e++) {
+        int b;
+        hashes[e] = resource_hash(resource_name[e], in_seed, &length);
+        b = (int)((hashes[e] >> 32) % RESOURCE_HASH_BUCKETS);
+        next[e] = heads[b];
+        heads[b] = e;
+        if (++sizes[b] > RESOURCE_HASH_BUCKET_MAX_SIZE) return 0;
+    }
+
+    // Place the largest buckets first: they are the hardest to place.
+    for (int size = RESOURCE_HASH_BUCKET_MAX_SIZE; size > 0; size--) {
+        for (int b = 0; b < RESOURCE_HASH_BUCKETS; b++) {
+            uint32_t displacement;
+
+            if (size != sizes[b]) continue;
+            for (displacement = 0; displacement < RESOURCE_HASH_CAPACITY; displacement++) {
+                uint32_t slots[RESOURCE_HASH_BUCKET_MAX_SIZE];
+                int count = 0;
+                int e;
+
+                for (e = heads[b]; e >= 0; e = next[e]) {
+                    uint32_t slot = resource_hash_slot(hashes[e], displacement);
+                    int i;
+                    if (EOR != resource_hash_table[slot]) break;
+                    for (i = 0; (i < count) && (slots[i] != slot); i++);
+                    if (i < count) break;
+                    slots[count++] = slot;
+                }
+                if (e < 0) break; // all the names of the bucket fit
+            }
+            if (RESOURCE_HASH_CAPACITY == displacement) return 0;
+            resource_hash_displacement[b] = displacement;
+            for (int e = heads[b]; e >= 0; e = next[e]) {
+                resource_hash_table[resource_hash_slot(hashes[e], displacement)] = (enum Resource) e;
+            }
+        }
+    }
+    resource_hash_seed = in_seed;
+    return 1;
+}
+
+/**
+ * @brief Build the table used by `resource_lookup()` (called once, see `resource_hash_once`).
+ * @note If the table cannot be built, then it is left empty: all the lookups return `EOR`.
+ */
+
+static void
+resource_index_once() {
+    for (uint64_t seed = 0; (0 != resource_hash_status) && (seed < RESOURCE_HASH_SEEDS); seed++) {
+        if (resource_index_build(seed * 0x9E3779B97F4A7C15ULL)) resource_hash_status = 0;
+    }
+    for (int s = 0; (0 != resource_hash_status) && (s < RESOURCE_HASH_CAPACITY); s++) {
+        resource_hash_table[s] = EOR;
+    }
+    __atomic_store_n(&resource_hash_ready, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Build the table used by `resource_lookup()`, if it is not built yet.
+ * @return On success, the function returns the value 0. Otherwise, it returns the value -1 (two resources have
+ * the same name).
+ * @note Calling this function is optional: the first lookup builds the table. Please note that you can call this
+ * function multiple times.
+ */
+
+static inline int
+resource_index_init() {
+    pthread_once(&resource_hash_once, resource_index_once);
+    return resource_hash_status;
+}
+
+/**
+ * @brief Find a resource from its name.
+ * @param in_name The name of the resource.
+ * @return If the name is found, the function returns the resource. Otherwise, it returns `EOR`.
+ */
+
+static inline enum Resource
+resource_lookup(const char *in_name) {
+    size_t length;
+    uint64_t hash;
+    enum Resource e;
+
+    if (0 == __atomic_load_n(&resource_hash_ready, __ATOMIC_ACQUIRE)) resource_index_init();
+    hash = resource_hash(in_name, resource_hash_seed, &length);
+    e = resource_hash_table[resource_hash_slot(hash, resource_hash_displacement[(hash >> 32) % RESOURCE_HASH_BUCKETS])];
+    if ((EOR == e) || (length != resource_name_length[e])) return EOR;
+    return 0 == memcmp(resource_name[e], in_name, length) ? e : EOR;
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// Sets of resource types: `struct ResourceSet` is a bitset (the bit `e` is set if the resource type `e` is in the set).
+//
+// The number of words is computed from `EOR`. If `EOR <= 64`, then a set is a single 64 bits word, and the loops
+// below are reduced (by the compiler) to single word operations.
+//
+//      struct ResourceSet needed = RESOURCE_SET_EMPTY;
+//      resource_set_add(&needed, DMem);
+//      resource_set_add(&needed, DMysql);
+//      for (enum Resource e = resource_set_first(&needed); EOR != e; e = resource_set_next(&needed, e)) { ... }
+// ---------------------------------------------------------------------------------------------------------------------
+
+#define RESOURCE_SET_WORDS ((EOR + 63) / 64)
+#define RESOURCE_SET_EMPTY { { 0 } }
+// Maximum length of the string returned by `resource_set_to_string()`, without the final zero.
+#define RESOURCE_SET_STRING_CAPACITY 256
+
+struct ResourceSet {
+    uint64_t words[RESOURCE_SET_WORDS];
+};
+
+static inline void
+resource_set_add(
+        struct ResourceSet *in_set,
+        const enum Resource in_resource) {
+    in_set->words[in_resource / 64] |= (uint64_t)1 << (in_resource % 64);
+}
+
+static inline void
+resource_set_remove(
+        struct ResourceSet *in_set,
+        const enum Resource in_resource) {
+    in_set->words[in_resource / 64] &= ~((uint64_t)1 << (in_resource % 64));
+}
+
+static inline int
+resource_set_contains(
+        const struct ResourceSet *in_set,
+        const enum Resource in_resource) {
+    return 0 != (in_set->words[in_resource / 64] & ((uint64_t)1 << (in_resource % 64)));
+}
+
+/**
+ * @brief Tell whether a set contains all the resource types of another set.
+ * @param in_set The set.
+ * @param in_subset The other set.
+ * @return If `in_set` contains all the types of `in_subset`: 1. Otherwise: 0.
+ */
+
+static inline int
+resource_set_contains_all(
+        const struct ResourceSet *in_set,
+        const struct ResourceSet *in_subset) {
+    uint64_t missing = 0;
+    for (int w = 0; w < RESOURCE_SET_WORDS; w++) {
+        missing |= in_subset->words[w] & ~in_set->words[w];
+    }
+    return 0 == missing;
+}
+
+static inline struct ResourceSet
+resource_set_union(
+        const struct ResourceSet *in_a,
+        const struct ResourceSet *in_b) {
+    struct ResourceSet result;
+    for (int w = 0; w < RESOURCE_SET_WORDS; w++) {
+        result.words[w] = in_a->words[w] | in_b->words[w];
+    }
+    return result;
+}
+
+static inline struct ResourceSet
+resource_set_intersection(
+        const struct ResourceSet *in_a,
+        const struct ResourceSet *in_b) {
+    struct ResourceSet result;
+    for (int w = 0; w < RESOURCE_SET_WORDS; w++) {
+        result.words[w] = in_a->words[w] & in_b->words[w];
+    }
+    return result;
+}
+
+static inline int
+resource_set_is_empty(const struct ResourceSet *in_set) {
+    uint64_t bits = 0;
+    for (int w = 0; w < RESOURCE_SET_WORDS; w++) {
+        bits |= in_set->words[w];
+    }
+    return 0 == bits;
+}
+
+/**
+ * @brief Return the number of resource types in a set.
+ * @param in_set The set.
+ * @return The number of resource types.
+ */
+
+static inline int
+resource_set_count(const struct ResourceSet *in_set) {
+    int count = 0;
+    for (int w = 0; w < RESOURCE_SET_WORDS; w++) {
+        count += __builtin_popcountll(in_set->words[w]);
+    }
+    return count;
+}
+
+/**
+ * @brief Return the first resource type of a set which value is greater than or equal to a given value.
+ * @param in_set The set.
+ * @param in_from The given value.
+ * @return The resource type, or `EOR` if there is none.
+ */
+
+static inline enum Resource
+resource_set_from(
+        const struct ResourceSet *in_set,
+        const int in_from) {
+    int w = in_from / 64;
+    uint64_t bits;
+
+    if (in_from >= EOR) return EOR;
+    // Ignore the bits that represent the values lower than `in_from`.
+    bits = in_set->words[w] & (~(uint64_t)0 << (in_from % 64));
+    for (;;) {
+        if (0 != bits) return (enum Resource) (w * 64 + __builtin_ctzll(bits));
+        if (++w >= RESOURCE_SET_WORDS) return EOR;
+        bits = in_set->words[w];
+    }
+}
+
+static inline enum Resource
+resource_set_first(const struct ResourceSet *in_set) {
+    return resource_set_from(in_set, 0);
+}
+
+static inline enum Resource
+resource_set_next(
+        const struct ResourceSet *in_set,
+        const enum Resource in_resource) {
+    return resource_set_from(in_set, (int) in_resource + 1);
+}
+
+/**
+ * @brief Render a set of resource types as a string.
+ *
+ *      "{mem,mysql}"
+ *
+ * @param in_set The set.
+ * @param out_buffer The buffer used to store the string. Its capacity must be (at least)
+ * `RESOURCE_SET_STRING_CAPACITY + 1` bytes. If the names do not fit, then the string ends with "...}".
+ * @return The string (that is: `out_buffer`).
+ */
+
+static inline char *
+resource_set_to_string(
+        const struct ResourceSet *in_set,
+        char *out_buffer) {
+    size_t length = 0;
+
+    out_buffer[length++] = '{';
+    for (enum Resource e = resource_set_first(in_set); EOR != e; e = resource_set_next(in_set, e)) {
+        // Keep room for ",", "...}" and the final zero.
+        if (length + 1 + resource_name_length[e] + 4 > RESOURCE_SET_STRING_CAPACITY) {
+            memcpy(out_buffer + length, "...", 3);
+            length += 3;
+            break;
+        }
+        if (length > 1) out_buffer[length++] = ',';
+        memcpy(out_buffer + length, resource_name[e], resource_name_length[e]);
+        length += resource_name_length[e];
+    }
+    out_buffer[length++] = '}';
+    out_buffer[length] = 0;
+    return out_buffer;
+}
 
 #endif //C_PATTERNS_PATTERN4_H
@@ -0,0 +1,181 @@
+/**
+ * Export an array of structures in bulk, instead of printing each element with `printf()`.
+ *
+ * Synopsis:
+ *
+ *      struct my_struct **array = NULL;
+ *      malloc_array_of_struct(&array, capacity); // see "my_struct/ms_array.h"
+ *      // ... initialize the array ...
+ *      if (MS_failure == MS_export_csv(STDOUT_FILENO, array, capacity)) { ... }
+ *      if (MS_failure == MS_export_binary(fd, array, capacity)) { ... }
+ *
+ * See "bench/bench_ms_export.c" for a comparison with the `printf()` loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "my_struct/ms_array.h"
+#include "my_struct/ms_export.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_ERROR 1
+#define CAPACITY 100000
+enum EnumStatus { failure, success };
+typedef enum EnumStatus Status;
+
+/**
+ * @brief Load the content of a file.
+ * @param in_fd The file descriptor.
+ * @param out_length The number of bytes loaded.
+ * @return On success, a non-NULL value. Otherwise NULL.
+ */
+
+char *
+load_file(
+        FILE *in_fd,
+        size_t *out_length) {
+    long size;
+    char *content;
+
+    if (0 != fseek(in_fd, 0, SEEK_END)) return NULL;
+    size = ftell(in_fd);
+    if (size < 0) return NULL;
+    rewind(in_fd);
+    content = (char *) malloc((size_t)size + 1);
+    if (NULL == content) return NULL;
+    *out_length = fread(content, 1, (size_t)size, in_fd);
+    content[*out_length] = 0;
+    return content;
+}
+
+Status
+test_format_int() {
+    const int values[] = { 0, 1, -1, 9, 10, 99, 100, -100, 12345, 999999999, 1000000000, INT_MAX, INT_MIN };
+    char expected[16];
+    char buffer[16];
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(int); i++) {
+        char *end = MS_format_int(buffer, values[i]);
+        *end = 0;
+        snprintf(expected, sizeof(expected), "%d", values[i]);
+        if (0 != strcmp(expected, buffer)) {
+            printf("MS_format_int(%d) returned [%s]\n", values[i], buffer);
+            return failure;
+        }
+    }
+    return success;
+}
+
+Status
+test_export(struct my_struct **in_array) {
+    FILE *fd;
+    char *content;
+    char *expected;
+    char *p;
+    size_t length;
+    Status status = success;
+
+    // CSV: compare the output with what `printf()` would have produced.
+    if (NULL == (fd = tmpfile())) return failure;
+    if (MS_failure == MS_export_csv(fileno(fd), in_array, CAPACITY)) {
+        fclose(fd);
+        return failure;
+    }
+    content = load_file(fd, &length);
+    fclose(fd);
+    if (NULL == content) return failure;
+
+    expected = (char *) malloc(CAPACITY * 24 + sizeof(MS_EXPORT_CSV_HEADER));
+    if (NULL == expected) {
+        free(content);
+        return failure;
+    }
+    p = expected + sprintf(expected, "%s", MS_EXPORT_CSV_HEADER);
+    for (int i = 0; i < CAPACITY; i++) {
+        if (NULL == in_array[i]) continue;
+        p += sprintf(p, "%d,%d\n", in_array[i]->a, in_array[i]->b);
+    }
+    if (0 != strcmp(expected, content)) {
+        printf("unexpected CSV output\n");
+        status = failure;
+    }
+    free(expected);
+    free(content);
+    if (failure == status) return failure;
+
+    // Binary: read the integers back.
+    if (NULL == (fd = tmpfile())) return failure;
+    if (MS_failure == MS_export_binary(fileno(fd), in_array, CAPACITY)) {
+        fclose(fd);
+        return failure;
+    }
+    content = load_file(fd, &length);
+    fclose(fd);
+    if (NULL == content) return failure;
+
+    p = content;
+    for (int i = 0; i < CAPACITY; i++) {
+        int32_t row[2];
+
+        if (NULL == in_array[i]) continue;
+        if (p + sizeof(row) > content + length) {
+            status = failure;
+            break;
+        }
+        memcpy(row, p, sizeof(row));
+        p += sizeof(row);
+        if ((row[0] != in_array[i]->a) || (row[1] != in_array[i]->b)) {
+            printf("unexpected binary output for row %d\n", i);
+            status = failure;
+            break;
+        }
+    }
+    if (p != content + length) status = failure;
+    free(content);
+    return status;
+}
+
+Status
+test() {
+    struct my_struct **array_of_struct = NULL;
+    Status status;
+
+    if (failure == test_format_int()) return failure;
+
+    if (MS_failure == malloc_array_of_struct(&array_of_struct,
+                                          CAPACITY)) {
+        return failure;
+    }
+    for (int i = 0; i < CAPACITY; i++) {
+        array_of_struct[i]->a = i % 2 ? i : -i;
+        array_of_struct[i]->b = i * 10;
+    }
+    array_of_struct[CAPACITY - 1]->a = INT_MIN;
+    array_of_struct[CAPACITY - 1]->b = INT_MAX;
+
+    // NULL elements are skipped.
+    free(array_of_struct[1]);
+    array_of_struct[1] = NULL;
+
+    status = test_export(array_of_struct);
+
+    // Print the first elements.
+    fflush(stdout);
+    if (MS_failure == MS_export_csv(STDOUT_FILENO, array_of_struct, 10)) status = failure;
+
+    free_array_of_struct(&array_of_struct,
+                         CAPACITY);
+    return status;
+}
+
+int
+main() {
+    Status status = test();
+    printf("%s\n",
+           success == status ? "success" : "failure");
+    return status == success ? EXIT_SUCCESS : EXIT_ERROR;
+}
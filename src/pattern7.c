@@ -0,0 +1,140 @@
+/**
+ * Persist an array of structures between runs, so that the next run starts without having to
+ * allocate and initialize the array again ("warm start").
+ *
+ * Synopsis:
+ *
+ *      MS_MappedArray array;
+ *
+ *      if (MS_failure == MS_mapped_array_open(&array, path)) {
+ *          // Cold start: create and fill the array.
+ *          MS_mapped_array_create(&array, path, capacity);
+ *          ...
+ *          MS_mapped_array_checkpoint(&array, MS_true);
+ *      }
+ *      // Use `array.elements[0]` ... `array.elements[array.capacity - 1]`.
+ *      MS_mapped_array_close(&array);
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "my_struct/ms_persist.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_ERROR 1
+#define CAPACITY 1000000
+#define PATH_CAPACITY 256
+enum EnumStatus { failure, success };
+typedef enum EnumStatus Status;
+
+/**
+ * @brief Open the array if it exists. Otherwise, create it and initialize it.
+ * @param in_array The array.
+ * @param in_path Path to the file used to store the array.
+ * @param out_warm Flag that tells whether the array was loaded (1) or created (0).
+ * @return On success `success`. Otherwise `failure`.
+ */
+
+Status
+open_array_of_struct(
+        MS_MappedArray *in_array,
+        const char *in_path,
+        int *out_warm) {
+    *out_warm = 1;
+    if (MS_success == MS_mapped_array_open(in_array, in_path)) return success;
+
+    *out_warm = 0;
+    if (MS_failure == MS_mapped_array_create(in_array, in_path, CAPACITY)) return failure;
+    for (size_t i = 0; i < in_array->capacity; i++) {
+        in_array->elements[i].a = (int)i;
+        in_array->elements[i].b = (int)i * 10;
+    }
+    if (MS_failure == MS_mapped_array_checkpoint(in_array, MS_true)) {
+        MS_mapped_array_close(in_array);
+        return failure;
+    }
+    return success;
+}
+
+Status
+check_array_of_struct(MS_MappedArray *in_array) {
+    if (CAPACITY != in_array->capacity) return failure;
+    for (size_t i = 0; i < in_array->capacity; i++) {
+        if ((in_array->elements[i].a != (int)i) || (in_array->elements[i].b != (int)i * 10)) return failure;
+    }
+    return success;
+}
+
+Status
+test(const char *in_path) {
+    MS_MappedArray array;
+    int warm;
+    Status status = success;
+
+    // Just to prove the point: you can close an array that was never opened.
+    MS_mapped_array_init(&array);
+    MS_mapped_array_close(&array);
+
+    // First run: the array does not exist yet.
+    unlink(in_path);
+    if (failure == open_array_of_struct(&array, in_path, &warm)) return failure;
+    printf("run 1: %s start, %zu elements\n", warm ? "warm" : "cold", array.capacity);
+    if (warm || (failure == check_array_of_struct(&array))) status = failure;
+    MS_mapped_array_close(&array);
+    if (failure == status) return failure;
+
+    // Second run: the array is loaded.
+    if (failure == open_array_of_struct(&array, in_path, &warm)) return failure;
+    printf("run 2: %s start, %zu elements\n", warm ? "warm" : "cold", array.capacity);
+    if (!warm || (failure == check_array_of_struct(&array))) status = failure;
+
+    // Modifications are persisted.
+    array.elements[10].a = -1;
+    MS_mapped_array_close(&array);
+    if (failure == status) return failure;
+    if (MS_failure == MS_mapped_array_open(&array, in_path)) return failure;
+    if (-1 != array.elements[10].a) status = failure;
+
+    // A file with an unexpected header is rejected.
+    array.header->element_size += 1;
+    MS_mapped_array_close(&array);
+    if (failure == status) return failure;
+    if (MS_success == MS_mapped_array_open(&array, in_path)) {
+        MS_mapped_array_close(&array);
+        return failure;
+    }
+
+    // An array that was never checkpointed (the cold start did not complete) is rejected.
+    if (MS_failure == MS_mapped_array_create(&array, in_path, CAPACITY)) return failure;
+    array.elements[0].a = 1;
+    MS_mapped_array_close(&array);
+    if (MS_success == MS_mapped_array_open(&array, in_path)) {
+        MS_mapped_array_close(&array);
+        return failure;
+    }
+
+    // The functions can be called multiple times.
+    MS_mapped_array_close(&array);
+    MS_mapped_array_close(&array);
+    return success;
+}
+
+int
+main() {
+    char directory[] = "/tmp/pattern7-XXXXXX";
+    char path[PATH_CAPACITY];
+    Status status;
+
+    if (NULL == mkdtemp(directory)) return EXIT_ERROR;
+    snprintf(path, PATH_CAPACITY, "%s/array.bin", directory);
+
+    status = test(path);
+
+    unlink(path);
+    rmdir(directory);
+    printf("%s\n",
+           success == status ? "success" : "failure");
+    return status == success ? EXIT_SUCCESS : EXIT_ERROR;
+}
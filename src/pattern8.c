@@ -0,0 +1,1166 @@
+/**
+ * Borrow resources from the resource manager, and give them back.
+ *
+ * The resource manager hands out resources (memory buffers, files...) through resource handlers
+ * (see `RM_ResourceHandler`). The resources are preallocated: borrowing a resource does not allocate it, and
+ * giving back a resource does not release it.
+ *
+ * Synopsis:
+ *
+ *      void *buffer;
+ *
+ *      RM_init(-1, 0, NULL);
+ *      RM_mem_handler_init(4096, 64);
+ *      if (RM_failure == RM_mem_handler_borrow(&buffer, 1, __FILE__, __LINE__, (char*)__func__, RM_true)) {
+ *          // The pool is exhausted.
+ *      }
+ *      ...
+ *      RM_mem_handler_give_back(&buffer, 2, __FILE__, __LINE__, (char*)__func__);
+ *      RM_mem_handler_terminate();
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "resource_manager/resource_manager.h"
+#include "resource_manager/rm_mem.h"
+#include "resource_manager/rm_file.h"
+#include "resource_manager/rm_conn.h"
+#include "resource_manager/rm_echo.h"
+#include "resource_manager/rm_fault.h"
+#include "resource_manager/rm_metrics.h"
+#include "resource_manager/rm_reaper.h"
+#include "resource_manager/rm_report.h"
+#include "resource_manager/rm_scope.h"
+
+#define EXIT_SUCCESS 0
+#define EXIT_ERROR 1
+#define MEM_OBJECT_SIZE 100
+#define MEM_CAPACITY 8
+#define FILE_CAPACITY 2
+#define PATH_CAPACITY 256
+#define CONN_MIN_SIZE 2
+#define CONN_CAPACITY 4
+#define CONN_IDLE_TIMEOUT_MS 20
+enum EnumStatus { failure, success };
+typedef enum EnumStatus Status;
+
+// The arguments that follow the UID are `in_init`, and then the arguments specific to the handler (if any).
+#define BORROW(handler, ptr, uid, ...) \
+    handler##_borrow((void **) (ptr), (uid), __FILE__, __LINE__, (char *) __func__, __VA_ARGS__)
+#define GIVE_BACK(handler, ptr, uid) \
+    handler##_give_back((void **) (ptr), (uid), __FILE__, __LINE__, (char *) __func__)
+#define BORROW_MANY(handler, ptrs, count, uid, ...) \
+    handler##_borrow_many((void **) (ptrs), (count), (uid), __FILE__, __LINE__, (char *) __func__, __VA_ARGS__)
+#define GIVE_BACK_MANY(handler, ptrs, count, uid) \
+    handler##_give_back_many((void **) (ptrs), (count), (uid), __FILE__, __LINE__, (char *) __func__)
+
+/**
+ * @brief Count the lines of a file.
+ * @param in_path Path to the file.
+ * @return The number of lines (0 if the file does not exist).
+ */
+
+static int
+count_lines(const char *in_path) {
+    FILE *fd = fopen(in_path, "r");
+    int count = 0;
+    int c;
+
+    if (NULL == fd) return 0;
+    while (EOF != (c = fgetc(fd))) {
+        if ('\n' == c) count++;
+    }
+    fclose(fd);
+    return count;
+}
+
+Status
+test_mem() {
+    unsigned char *buffers[MEM_CAPACITY];
+    unsigned char *buffer;
+    unsigned char foreign[MEM_OBJECT_SIZE];
+    Status status = failure;
+
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, MEM_CAPACITY)) return failure;
+
+    // Borrow all the buffers: they are all different, and aligned.
+    for (int i = 0; i < MEM_CAPACITY; i++) {
+        if (RM_failure == BORROW(RM_mem_handler, &buffers[i], 1, RM_false)) goto end;
+        if (0 != (size_t)buffers[i] % 16) goto end;
+        for (int j = 0; j < i; j++) {
+            if (buffers[i] == buffers[j]) goto end;
+        }
+        memset(buffers[i], 0xFF, MEM_OBJECT_SIZE);
+    }
+    // The pool is exhausted.
+    if (RM_success == BORROW(RM_mem_handler, &buffer, 2, RM_false)) goto end;
+    if (NULL != buffer) goto end;
+
+    // The last buffer given back is the next buffer borrowed. It is filled with zeros on request only.
+    buffer = buffers[3];
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[3], 3)) goto end;
+    if (NULL != buffers[3]) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[3], 3)) goto end; // it does not harm
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[3], 4, RM_true)) goto end;
+    if (buffer != buffers[3]) goto end;
+    for (int i = 0; i < MEM_OBJECT_SIZE; i++) {
+        if (0 != buffers[3][i]) goto end;
+    }
+
+    // A buffer that does not belong to the pool cannot be given back.
+    buffer = foreign;
+    if (RM_success == GIVE_BACK(RM_mem_handler, &buffer, 5)) goto end;
+    buffer = buffers[0] + 1;
+    if (RM_success == GIVE_BACK(RM_mem_handler, &buffer, 5)) goto end;
+
+    // A buffer cannot be given back twice (through two different pointers).
+    buffer = buffers[0];
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[0], 5)) goto end;
+    if (RM_success == GIVE_BACK(RM_mem_handler, &buffer, 5)) goto end;
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[0], 5, RM_false)) goto end;
+
+    for (int i = 0; i < MEM_CAPACITY; i++) {
+        if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[i], 6)) goto end;
+    }
+
+    // Simulate a shortage: the call which ID is 10 fails after 2 successes.
+    RM_init(10, 2, NULL);
+    for (int i = 0; i < 3; i++) {
+        RM_Status borrowed = BORROW(RM_mem_handler, &buffers[i], 10, RM_false);
+        if ((i < 2) != (RM_success == borrowed)) goto end;
+    }
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[2], 11, RM_false)) goto end;
+    for (int i = 0; i < 3; i++) {
+        GIVE_BACK(RM_mem_handler, &buffers[i], 12);
+    }
+    RM_init(-1, 0, NULL);
+    status = success;
+
+end:
+    RM_mem_handler_terminate();
+    RM_mem_handler_terminate(); // it does not harm
+    printf("mem:     %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_file() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char paths[3][PATH_CAPACITY];
+    int *fd1 = NULL;
+    int *fd2 = NULL;
+    int *fd3 = NULL;
+    int first_fd;
+    char c;
+    Status status = failure;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    for (int i = 0; i < 3; i++) {
+        snprintf(paths[i], PATH_CAPACITY, "%s/file%d.txt", directory, i);
+    }
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_file_handler_init(0, FILE_CAPACITY)) goto end;
+
+    // The file is created by the first borrower.
+    if (RM_failure == BORROW(RM_file_handler, &fd1, 1, RM_false, paths[0], O_RDWR | O_CREAT, 0600)) goto end;
+    if (3 != write(*fd1, "abc", 3)) goto end;
+    first_fd = *fd1;
+    if (RM_failure == GIVE_BACK(RM_file_handler, &fd1, 2)) goto end;
+    if ((NULL != fd1) || (1 != RM_file_handler_open_count())) goto end;
+
+    // The descriptor is reused (and rewound on request): `open()` is not called.
+    if (RM_failure == BORROW(RM_file_handler, &fd1, 3, RM_true, paths[0], O_RDWR | O_CREAT, 0600)) goto end;
+    if ((first_fd != *fd1) || (1 != read(*fd1, &c, 1)) || ('a' != c)) goto end;
+
+    // A borrowed descriptor is not shared: the same file gets another descriptor.
+    if (RM_failure == BORROW(RM_file_handler, &fd2, 4, RM_false, paths[0], O_RDWR | O_CREAT, 0600)) goto end;
+    if ((*fd1 == *fd2) || (2 != RM_file_handler_open_count())) goto end;
+
+    // All the descriptors are borrowed.
+    if (RM_success == BORROW(RM_file_handler, &fd3, 5, RM_false, paths[1], O_RDWR | O_CREAT, 0600)) goto end;
+
+    // Once a descriptor is given back, it is closed to open another file (least recently given back first).
+    first_fd = *fd1;
+    if (RM_failure == GIVE_BACK(RM_file_handler, &fd1, 6)) goto end;
+    if (RM_failure == GIVE_BACK(RM_file_handler, &fd2, 7)) goto end;
+    if (RM_failure == GIVE_BACK(RM_file_handler, &fd2, 7)) goto end; // it does not harm
+    if (RM_failure == BORROW(RM_file_handler, &fd3, 8, RM_false, paths[1], O_RDWR | O_CREAT, 0600)) goto end;
+    if ((first_fd != *fd3) || (2 != RM_file_handler_open_count())) goto end;
+    if (RM_failure == GIVE_BACK(RM_file_handler, &fd3, 9)) goto end;
+
+    // Failures: the file does not exist, or the failure is simulated.
+    if (RM_success == BORROW(RM_file_handler, &fd1, 10, RM_false, paths[2], O_RDONLY)) goto end;
+    RM_init(11, 0, NULL);
+    if (RM_success == BORROW(RM_file_handler, &fd1, 11, RM_false, paths[0], O_RDWR | O_CREAT, 0600)) goto end;
+    RM_init(-1, 0, NULL);
+    status = success;
+
+end:
+    RM_file_handler_terminate();
+    RM_file_handler_terminate(); // it does not harm
+    for (int i = 0; i < 3; i++) {
+        unlink(paths[i]);
+    }
+    rmdir(directory);
+    printf("file:    %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_conn() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char path[PATH_CAPACITY];
+    RM_ConnectionFactory factory;
+    RM_EchoConnection *connections[CONN_CAPACITY + 1];
+    RM_EchoConnection *connection = NULL;
+    RM_WaitStats stats;
+    struct timespec pause = { 0, 2 * CONN_IDLE_TIMEOUT_MS * 1000000 };
+    Status status = failure;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    snprintf(path, PATH_CAPACITY, "%s/echo.sock", directory);
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_echo_server_start(path)) goto end;
+    factory = RM_echo_factory(path);
+    RM_conn_handler_configure(&factory, CONN_MIN_SIZE, CONN_IDLE_TIMEOUT_MS);
+
+    // Warm-up: the first connections are opened by the initialization.
+    if (RM_failure == RM_conn_handler_init(0, CONN_CAPACITY)) goto end;
+    if (CONN_MIN_SIZE != RM_conn_handler_open_count()) goto end;
+
+    // Borrow all the connections.
+    for (int i = 0; i < CONN_CAPACITY; i++) {
+        if (RM_failure == BORROW(RM_conn_handler, &connections[i], 1, RM_false)) goto end;
+        if (RM_failure == RM_echo_ping(connections[i])) goto end;
+    }
+    if (RM_success == BORROW(RM_conn_handler, &connections[CONN_CAPACITY], 2, RM_false)) goto end;
+    if (RM_success == RM_conn_handler_borrow_timed((void **) &connections[CONN_CAPACITY], 5, 2, __FILE__, __LINE__,
+                                                   (char *) __func__, RM_false)) {
+        goto end;
+    }
+    RM_conn_handler_wait_stats(&stats);
+    if ((1 != stats.timeouts) || (0 != stats.depth)) goto end;
+    if (CONN_CAPACITY != RM_conn_handler_open_count()) goto end;
+    for (int i = 0; i < CONN_CAPACITY; i++) {
+        if (RM_failure == GIVE_BACK(RM_conn_handler, &connections[i], 3)) goto end;
+    }
+    if (RM_failure == GIVE_BACK(RM_conn_handler, &connections[0], 3)) goto end; // it does not harm
+
+    // The idle connections are closed after the timeout (but the pool keeps the minimum number of connections).
+    nanosleep(&pause, NULL);
+    for (int i = 0; i < CONN_CAPACITY; i++) {
+        if (RM_failure == BORROW(RM_conn_handler, &connection, 4, RM_false)) goto end;
+        if (RM_failure == GIVE_BACK(RM_conn_handler, &connection, 5)) goto end;
+    }
+    if (CONN_MIN_SIZE != RM_conn_handler_open_count()) goto end;
+
+    // The server closes the connections: the health check replaces the idle connection before it is borrowed.
+    RM_echo_server_stop();
+    if (RM_failure == RM_echo_server_start(path)) goto end;
+    if (RM_failure == BORROW(RM_conn_handler, &connection, 6, RM_false)) goto end;
+    if (RM_failure == RM_echo_ping(connection)) goto end;
+    if (RM_failure == GIVE_BACK(RM_conn_handler, &connection, 7)) goto end;
+    status = success;
+
+end:
+    RM_conn_handler_terminate();
+    RM_conn_handler_terminate(); // it does not harm
+    RM_echo_server_stop();
+    unlink(path);
+    rmdir(directory);
+    printf("conn:    %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_many() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char report[PATH_CAPACITY];
+    char paths[3][PATH_CAPACITY];
+    char socket_path[PATH_CAPACITY];
+    const char *file_paths[3];
+    void *buffers[MEM_CAPACITY];
+    void *more[MEM_CAPACITY];
+    int *fds[3];
+    void *connections[CONN_CAPACITY + 1];
+    RM_ConnectionFactory factory;
+    Status status = failure;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    snprintf(report, PATH_CAPACITY, "%s/report.txt", directory);
+    snprintf(socket_path, PATH_CAPACITY, "%s/echo.sock", directory);
+    for (int i = 0; i < 3; i++) {
+        snprintf(paths[i], PATH_CAPACITY, "%s/file%d.txt", directory, i);
+        file_paths[i] = paths[i];
+    }
+    RM_init(-1, 0, report);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, MEM_CAPACITY)) goto end;
+
+    // A batch is borrowed in one operation, and recorded once.
+    if (RM_failure == BORROW_MANY(RM_mem_handler, buffers, 3, 1, RM_true)) goto end;
+    for (int i = 0; i < 3; i++) {
+        if ((NULL == buffers[i]) || (0 != ((unsigned char *) buffers[i])[MEM_OBJECT_SIZE - 1])) goto end;
+    }
+    RM_report_flush(); // the records are buffered
+    if (1 != count_lines(report)) goto end;
+
+    // All or nothing: 6 buffers are requested, but only 5 are free.
+    if (RM_success == BORROW_MANY(RM_mem_handler, more, 6, 2, RM_false)) goto end;
+    if ((NULL != more[0]) || (NULL != more[5])) goto end;
+    if (RM_failure == BORROW_MANY(RM_mem_handler, more, 5, 3, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, more, 5, 4)) goto end;
+
+    // A batch that contains a buffer twice is refused as a whole: no buffer is given back.
+    more[0] = buffers[0];
+    more[1] = NULL;
+    more[2] = buffers[0];
+    if (RM_success == GIVE_BACK_MANY(RM_mem_handler, more, 3, 5)) goto end;
+    if (RM_success == BORROW_MANY(RM_mem_handler, more, 6, 6, RM_false)) goto end;
+
+    // The NULL pointers are ignored.
+    buffers[3] = NULL;
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, 4, 7)) goto end;
+    if ((NULL != buffers[0]) || (NULL != buffers[2])) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, 4, 7)) goto end; // it does not harm
+    if (RM_failure == BORROW_MANY(RM_mem_handler, buffers, MEM_CAPACITY, 8, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, MEM_CAPACITY, 9)) goto end;
+    RM_report_flush();
+    if (6 != count_lines(report)) goto end; // BM, BM, GM, GM, BM, GM (the failed calls are not recorded)
+    RM_init(-1, 0, NULL);
+
+    // Files: one descriptor per path.
+    if (RM_failure == RM_file_handler_init(0, 3)) goto end;
+    if (RM_failure == BORROW_MANY(RM_file_handler, fds, 2, 11, RM_false, file_paths, O_RDWR | O_CREAT, 0600)) {
+        goto end;
+    }
+    if ((*fds[0] == *fds[1]) || (2 != RM_file_handler_open_count())) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_file_handler, fds, 2, 12)) goto end;
+    // The third file does not exist: the descriptors taken for the first two files are given back.
+    if (RM_success == BORROW_MANY(RM_file_handler, fds, 3, 13, RM_false, file_paths, O_RDONLY)) goto end;
+    if ((NULL != fds[0]) || (NULL != fds[2])) goto end;
+    if (RM_failure == BORROW_MANY(RM_file_handler, fds, 2, 14, RM_false, file_paths, O_RDWR | O_CREAT, 0600)) {
+        goto end;
+    }
+    if (RM_failure == GIVE_BACK_MANY(RM_file_handler, fds, 2, 15)) goto end;
+
+    // Connections.
+    if (RM_failure == RM_echo_server_start(socket_path)) goto end;
+    factory = RM_echo_factory(socket_path);
+    RM_conn_handler_configure(&factory, CONN_MIN_SIZE, 0);
+    if (RM_failure == RM_conn_handler_init(0, CONN_CAPACITY)) goto end;
+    if (RM_success == BORROW_MANY(RM_conn_handler, connections, CONN_CAPACITY + 1, 16, RM_false)) goto end;
+    if (CONN_MIN_SIZE != RM_conn_handler_open_count()) goto end;
+    if (RM_failure == BORROW_MANY(RM_conn_handler, connections, CONN_CAPACITY, 17, RM_false)) goto end;
+    for (int i = 0; i < CONN_CAPACITY; i++) {
+        if (RM_failure == RM_echo_ping((RM_EchoConnection *) connections[i])) goto end;
+    }
+    if (RM_failure == GIVE_BACK_MANY(RM_conn_handler, connections, CONN_CAPACITY, 18)) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_conn_handler, connections, CONN_CAPACITY, 18)) goto end; // it does not harm
+    status = success;
+
+end:
+    RM_init(-1, 0, NULL);
+    RM_mem_handler_terminate();
+    RM_file_handler_terminate();
+    RM_conn_handler_terminate();
+    RM_echo_server_stop();
+    for (int i = 0; i < 3; i++) {
+        unlink(paths[i]);
+    }
+    unlink(report);
+    unlink(socket_path);
+    rmdir(directory);
+    printf("many:    %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+struct Waiter {
+    int  id;
+    int  borrowed;
+    void *buffer;
+};
+
+static int SERVED[2];       // the IDs of the waiters, in the order they were served
+static int SERVED_COUNT = 0;
+static pthread_mutex_t SERVED_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+static void *
+wait_buffer(void *in_waiter) {
+    struct Waiter *waiter = (struct Waiter *) in_waiter;
+    waiter->borrowed = RM_success == RM_mem_handler_borrow_timed(&waiter->buffer, RM_WAIT_FOREVER, 1, __FILE__,
+                                                                 __LINE__, (char *) __func__, RM_false);
+    pthread_mutex_lock(&SERVED_LOCK);
+    SERVED[SERVED_COUNT++] = waiter->id;
+    pthread_mutex_unlock(&SERVED_LOCK);
+    return NULL;
+}
+
+/**
+ * @brief Wait until the given number of threads wait for a buffer.
+ */
+
+static void
+wait_depth(const size_t in_depth) {
+    struct timespec pause = { 0, 1000000 };
+    RM_WaitStats stats;
+    for (RM_mem_handler_wait_stats(&stats); stats.depth != in_depth; RM_mem_handler_wait_stats(&stats)) {
+        nanosleep(&pause, NULL);
+    }
+}
+
+Status
+test_wait() {
+    void *buffers[2] = { NULL, NULL };
+    void *buffer = NULL;
+    struct Waiter waiters[2] = { { 0, 0, NULL }, { 1, 0, NULL } };
+    pthread_t threads[2];
+    int started = 0;
+    int joined = 0;
+    RM_WaitStats stats;
+    Status status = failure;
+
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 2)) return failure;
+    if (RM_failure == BORROW_MANY(RM_mem_handler, buffers, 2, 1, RM_false)) goto end;
+
+    // The pool is exhausted: "try borrow" fails immediately, and the timed borrow fails after the timeout.
+    if (RM_success == BORROW(RM_mem_handler, &buffer, 2, RM_false)) goto end;
+    if (RM_success == RM_mem_handler_borrow_timed(&buffer, 10, 3, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+        goto end;
+    }
+    RM_mem_handler_wait_stats(&stats);
+    if ((1 != stats.waits) || (1 != stats.timeouts) || (0 != stats.depth) || (stats.max_wait_ns < 10000000)) goto end;
+
+    // Two threads wait: the first arrived is served first, with the buffer given back.
+    for (; started < 2; started++) {
+        if (0 != pthread_create(&threads[started], NULL, wait_buffer, &waiters[started])) goto end;
+        wait_depth((size_t) started + 1);
+    }
+    if (RM_success == BORROW(RM_mem_handler, &buffer, 4, RM_false)) goto end; // no queue jumping
+    buffer = buffers[1];
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[1], 5)) goto end;
+    pthread_join(threads[joined++], NULL);
+    if ((1 != SERVED_COUNT) || (0 != SERVED[0]) || (buffer != waiters[0].buffer)) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[0], 6)) goto end;
+    pthread_join(threads[joined++], NULL);
+    RM_mem_handler_wait_stats(&stats);
+    if ((3 != stats.waits) || (1 != stats.timeouts) || (0 != stats.depth) || (2 != stats.max_depth)) goto end;
+    for (int i = 0; i < 2; i++) {
+        if ((! waiters[i].borrowed) || (RM_failure == GIVE_BACK(RM_mem_handler, &waiters[i].buffer, 7))) goto end;
+    }
+    status = success;
+
+end:
+    // On failure, wake up the threads that still wait.
+    for (int i = joined; i < started; i++) {
+        GIVE_BACK(RM_mem_handler, &buffers[i], 8);
+        pthread_join(threads[i], NULL);
+    }
+    RM_mem_handler_terminate();
+    printf("wait:    %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+static void *
+wait_connection(void *in_waiter) {
+    struct Waiter *waiter = (struct Waiter *) in_waiter;
+    waiter->borrowed = RM_success == RM_conn_borrow_timed(&waiter->buffer, RM_WAIT_FOREVER, 1, RM_false);
+    return NULL;
+}
+
+static void *
+wait_memory(void *in_waiter) {
+    struct Waiter *waiter = (struct Waiter *) in_waiter;
+    waiter->borrowed = RM_success == RM_mem_borrow_timed(&waiter->buffer, RM_WAIT_FOREVER, 1, RM_false);
+    return NULL;
+}
+
+Status
+test_cancel() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char path[PATH_CAPACITY];
+    RM_ConnectionFactory factory;
+    void *buffer = NULL;
+    void *connection = NULL;
+    struct Waiter waiters[2] = { { 0, 1, NULL }, { 1, 1, NULL } };
+    pthread_t threads[2];
+    int started = 0;
+    struct timespec pause = { 0, 1000000 };
+    RM_WaitStats stats;
+    Status status = failure;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    snprintf(path, PATH_CAPACITY, "%s/echo.sock", directory);
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_echo_server_start(path)) goto end;
+    factory = RM_echo_factory(path);
+    RM_conn_handler_configure(&factory, 0, 0);
+    if ((RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 1)) || (RM_failure == RM_conn_handler_init(0, 1))) goto end;
+    if ((RM_failure == RM_mem_borrow(&buffer, 2, RM_false)) || (RM_failure == RM_conn_borrow(&connection, 3, RM_false))) {
+        goto end;
+    }
+
+    // One thread waits for a buffer, and another one waits for a connection.
+    if (0 != pthread_create(&threads[started], NULL, wait_memory, &waiters[started])) goto end;
+    wait_depth((size_t) ++started);
+    if (0 != pthread_create(&threads[started], NULL, wait_connection, &waiters[started])) goto end;
+    for (RM_conn_handler_wait_stats(&stats); 1 != stats.depth; RM_conn_handler_wait_stats(&stats)) {
+        nanosleep(&pause, NULL);
+    }
+    started++;
+    status = success;
+
+end:
+    // The handlers are terminated while the threads wait: the threads are woken up, and they fail to borrow.
+    RM_mem_handler_terminate();
+    RM_conn_handler_terminate();
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+        if (waiters[i].borrowed) status = failure;
+    }
+    RM_echo_server_stop();
+    unlink(path);
+    rmdir(directory);
+    printf("cancel:  %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_ledger() {
+    void *buffers[3] = { NULL, NULL, NULL };
+    void *copy;
+    FILE *report = tmpfile();
+    char line[PATH_CAPACITY];
+    Status status = failure;
+
+    if (NULL == report) return failure;
+    RM_init(-1, 0, NULL);
+    RM_ledger_enable(RM_false);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, MEM_CAPACITY)) goto end;
+
+    // Every borrow is recorded until the resource is given back.
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[0], 1, RM_false)) goto end;
+    if (RM_failure == BORROW_MANY(RM_mem_handler, &buffers[1], 2, 2, RM_false)) goto end;
+    if (3 != RM_report_outstanding(NULL)) goto end;
+    copy = buffers[1];
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[1], 3)) goto end;
+
+    // The report tells where the outstanding resources were borrowed.
+    if (2 != RM_report_outstanding(report)) goto end;
+    rewind(report);
+    if ((NULL == fgets(line, PATH_CAPACITY, report)) || (NULL == strstr(line, "OUTSTANDING mem"))
+        || (NULL == strstr(line, __FILE__)) || (NULL == strstr(line, "[test_ledger]"))) {
+        goto end;
+    }
+
+    // A double give back is detected.
+    if (RM_success == GIVE_BACK(RM_mem_handler, &copy, 4)) goto end;
+    if (1 != RM_ledger_double_give_backs()) goto end;
+
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, 3, 5)) goto end;
+    if (0 != RM_report_outstanding(NULL)) goto end;
+
+    // A resource handed out twice, or given back without being borrowed, is reported (by a faulty handler).
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[0], 6, RM_false)) goto end;
+    record_borrow(&buffers[0], "mem", 7, __FILE__, __LINE__, __func__);
+    copy = line;
+    record_give_back(&copy, "mem", 8, __FILE__, __LINE__, __func__);
+    if ((1 != RM_ledger_duplicate_borrows()) || (1 != RM_ledger_unknown_give_backs())) goto end;
+    if ((RM_failure == GIVE_BACK(RM_mem_handler, &buffers[0], 9)) || (0 != RM_report_outstanding(NULL))) goto end;
+    status = success;
+
+end:
+    RM_ledger_disable();
+    RM_ledger_disable(); // it does not harm
+    RM_mem_handler_terminate();
+    fclose(report);
+    printf("ledger:  %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+/**
+ * @brief Borrow a buffer and give it back, from another thread.
+ */
+
+static void *
+borrow_once(void *in_unused) {
+    void *buffer = NULL;
+    (void) in_unused;
+    if (RM_success == BORROW(RM_mem_handler, &buffer, 1, RM_false)) GIVE_BACK(RM_mem_handler, &buffer, 2);
+    return NULL;
+}
+
+Status
+test_report() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char reports[2][PATH_CAPACITY];
+    void *buffer = NULL;
+    pthread_t thread;
+    Status status = failure;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    for (int i = 0; i < 2; i++) {
+        snprintf(reports[i], PATH_CAPACITY, "%s/report%d.txt", directory, i);
+    }
+    RM_init(-1, 0, reports[0]);
+    if ((RM_false == RM_report_is_open()) || (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 2))) goto end;
+
+    // The records of a thread are written into the file when the thread exits.
+    if (0 != pthread_create(&thread, NULL, borrow_once, NULL)) goto end;
+    pthread_join(thread, NULL);
+    if (2 != count_lines(reports[0])) goto end;
+
+    // The records are written into the previous file before a new file is open.
+    if (RM_failure == BORROW(RM_mem_handler, &buffer, 3, RM_false)) goto end;
+    RM_init(-1, 0, reports[1]);
+    if (3 != count_lines(reports[0])) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 4)) goto end;
+    RM_init(-1, 0, NULL);
+    if ((RM_true == RM_report_is_open()) || (3 != count_lines(reports[0])) || (1 != count_lines(reports[1]))) goto end;
+    RM_report_close(); // it does not harm
+    status = success;
+
+end:
+    RM_init(-1, 0, NULL);
+    RM_mem_handler_terminate();
+    for (int i = 0; i < 2; i++) {
+        unlink(reports[i]);
+    }
+    rmdir(directory);
+    printf("report:  %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+#define FAULT_THREADS_COUNT 4
+#define FAULT_CALLS_COUNT 30
+
+/**
+ * @brief Borrow a buffer and give it back FAULT_CALLS_COUNT times, and count the failures.
+ * @param in_failures The number of failures (in: the uid of the calls).
+ */
+
+static void *
+borrow_faulty(void *in_failures) {
+    long *failures = (long *) in_failures;
+    const long uid = *failures;
+    void *buffer = NULL;
+
+    *failures = 0;
+    for (int i = 0; i < FAULT_CALLS_COUNT; i++) {
+        if (RM_failure == BORROW(RM_mem_handler, &buffer, uid, RM_false)) (*failures)++;
+        else GIVE_BACK(RM_mem_handler, &buffer, uid);
+    }
+    return NULL;
+}
+
+Status
+test_fault() {
+    const RM_FaultRule files = { RM_FAULT_ANY_UID, "file", RM_FAULT_AFTER, 0 };
+    const RM_FaultRule always = { 20, NULL, RM_FAULT_PROBABILITY, 1000000 };
+    const RM_FaultRule slow = { 21, "mem", RM_FAULT_LATENCY, 20000 };
+    const RM_FaultRule invalid = { 22, NULL, RM_FAULT_EVERY, 0 };
+    const RM_FaultRule call = { 30, NULL, RM_FAULT_AFTER, 0 };
+    long failures[FAULT_THREADS_COUNT];
+    pthread_t threads[FAULT_THREADS_COUNT];
+    void *buffer = NULL;
+    int started = 0;
+    long id;
+    struct timespec start;
+    struct timespec stop;
+    Status status = failure;
+
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, FAULT_THREADS_COUNT)) return failure;
+
+    // Concurrent scenarios in one process: each thread has its own rule (thread i: 1 call out of i + 2 fails).
+    for (long i = 0; i < FAULT_THREADS_COUNT; i++) {
+        const RM_FaultRule rule = { 100 + i, "mem", RM_FAULT_EVERY, i + 2 };
+        if (RM_fault_add(&rule) <= 0) goto end;
+    }
+    for (; started < FAULT_THREADS_COUNT; started++) {
+        failures[started] = 100 + started;
+        if (0 != pthread_create(&threads[started], NULL, borrow_faulty, &failures[started])) goto end;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    for (int i = 0; i < started; i++) {
+        if (FAULT_CALLS_COUNT / (i + 2) != failures[i]) goto end;
+    }
+
+    // The rules are keyed by type: a rule for the files does not affect the buffers.
+    if (RM_fault_add(&files) <= 0) goto end;
+    if (RM_failure == BORROW(RM_mem_handler, &buffer, 1, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 2)) goto end;
+    if (RM_false == RM_fault_check("file", 1)) goto end;
+
+    // Probabilistic failure, latency, and removal of a rule.
+    id = RM_fault_add(&always);
+    if ((id <= 0) || (RM_success == BORROW(RM_mem_handler, &buffer, 20, RM_false))) goto end;
+    if ((RM_failure == RM_fault_remove(id)) || (RM_success == RM_fault_remove(id))) goto end;
+    if (RM_failure == BORROW(RM_mem_handler, &buffer, 20, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 20)) goto end;
+    if (RM_fault_add(&slow) <= 0) goto end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (RM_failure == BORROW(RM_mem_handler, &buffer, 21, RM_false)) goto end;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    if ((stop.tv_sec - start.tv_sec) * 1000000000L + (stop.tv_nsec - start.tv_nsec) < 20000000L) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 21)) goto end;
+    if (-1 != RM_fault_add(&invalid)) goto end;
+
+    // A rule for all the types applies to the types named by other rules, and to the others.
+    if (RM_fault_add(&call) <= 0) goto end;
+    if ((RM_false == RM_fault_check("conn", 30)) || (RM_false == RM_fault_check(NULL, 30))) goto end;
+    if ((RM_true == RM_fault_check("conn", 31)) || (RM_true == RM_fault_check("mem", 31))) goto end;
+    if (RM_false == RM_fault_check("mem", 30)) goto end;
+    status = success;
+
+end:
+    RM_fault_clear();
+    RM_fault_clear(); // it does not harm
+    RM_mem_handler_terminate();
+    printf("fault:   %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+/**
+ * @brief Borrow a buffer and give it back, 10 times.
+ */
+
+static void *
+borrow_ten_times(void *in_unused) {
+    void *buffer = NULL;
+    (void) in_unused;
+    for (int i = 0; i < 10; i++) {
+        if (RM_success == BORROW(RM_mem_handler, &buffer, 1, RM_false)) GIVE_BACK(RM_mem_handler, &buffer, 2);
+    }
+    return NULL;
+}
+
+struct IdleThread {
+    pthread_mutex_t lock;
+    pthread_cond_t  condition;
+    int             ready;    // the thread has borrowed and given back a buffer
+    int             released; // the thread may exit
+};
+
+/**
+ * @brief Borrow a buffer and give it back (its magazine keeps buffers), then stay idle until released.
+ */
+
+static void *
+borrow_and_idle(void *in_idle) {
+    struct IdleThread *idle = (struct IdleThread *) in_idle;
+    void *buffer = NULL;
+
+    if (RM_success == BORROW(RM_mem_handler, &buffer, 1, RM_false)) GIVE_BACK(RM_mem_handler, &buffer, 2);
+    pthread_mutex_lock(&idle->lock);
+    idle->ready = 1;
+    pthread_cond_broadcast(&idle->condition);
+    while (! idle->released) {
+        pthread_cond_wait(&idle->condition, &idle->lock);
+    }
+    pthread_mutex_unlock(&idle->lock);
+    return NULL;
+}
+
+Status
+test_metrics() {
+    RM_Metrics before;
+    RM_Metrics after;
+    const RM_TypeMetrics *mem = &after.types[RM_METRICS_MEM];
+    void *buffers[4] = { NULL, NULL, NULL, NULL };
+    void *buffer = NULL;
+    uint64_t waits[RM_METRICS_BUCKETS];
+    struct timespec hold = { 0, 2000000 };
+    pthread_t threads[2];
+    FILE *stream = tmpfile();
+    char line[PATH_CAPACITY];
+    Status status = failure;
+
+    if (NULL == stream) return failure;
+    RM_init(-1, 0, NULL);
+    RM_metrics_set_level(RM_METRICS_TIMING);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 4)) goto end;
+    RM_metrics_snapshot(&before);
+
+    // Utilisation, and holding time (2 ms).
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[0], 1, RM_false)) goto end;
+    if (RM_failure == BORROW_MANY(RM_mem_handler, &buffers[1], 3, 2, RM_false)) goto end;
+    nanosleep(&hold, NULL);
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffers[0], 3)) goto end;
+    RM_metrics_snapshot(&after);
+    if ((4 != mem->capacity) || (3 != mem->borrowed) || (1 != mem->available)) goto end;
+    if ((4 != mem->borrows - before.types[RM_METRICS_MEM].borrows)
+        || (1 != RM_metrics_count(mem->hold) - RM_metrics_count(before.types[RM_METRICS_MEM].hold))
+        || (RM_metrics_percentile(mem->hold, 100.0) < 1500000)) {
+        goto end;
+    }
+
+    // Waiting time: the pool is exhausted, the borrower waits 5 ms (and gives up).
+    if (RM_failure == BORROW(RM_mem_handler, &buffers[0], 4, RM_false)) goto end;
+    if (RM_success == RM_mem_handler_borrow_timed(&buffer, 5, 5, __FILE__, __LINE__, (char *) __func__, RM_false)) {
+        goto end;
+    }
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, 4, 6)) goto end;
+    RM_metrics_snapshot(&after);
+    for (size_t i = 0; i < RM_METRICS_BUCKETS; i++) {
+        waits[i] = mem->wait[i] - before.types[RM_METRICS_MEM].wait[i];
+    }
+    // 4 calls to borrow: 3 did not wait, 1 waited 5 ms.
+    if ((0 != mem->borrowed) || (4 != RM_metrics_count(waits)) || (0 != RM_metrics_percentile(waits, 75.0))
+        || (RM_metrics_percentile(waits, 100.0) < 3500000)) {
+        goto end;
+    }
+
+    // The metrics of the threads that exited are kept.
+    RM_metrics_snapshot(&before);
+    for (int i = 0; i < 2; i++) {
+        if (0 != pthread_create(&threads[i], NULL, borrow_ten_times, NULL)) goto end;
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    RM_metrics_snapshot(&after);
+    if ((20 != mem->borrows - before.types[RM_METRICS_MEM].borrows)
+        || (20 != mem->give_backs - before.types[RM_METRICS_MEM].give_backs)) {
+        goto end;
+    }
+
+    // Nothing is measured when the metrics are off.
+    RM_metrics_set_level(RM_METRICS_OFF);
+    if (RM_failure == BORROW(RM_mem_handler, &buffer, 7, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 8)) goto end;
+    RM_metrics_snapshot(&before);
+    if (before.types[RM_METRICS_MEM].borrows != mem->borrows) goto end;
+
+    // JSON dump: one object per line, keyed by type.
+    RM_metrics_print(&after, stream, RM_METRICS_JSON);
+    rewind(stream);
+    if ((NULL == fgets(line, PATH_CAPACITY, stream)) || (NULL == strstr(line, "{\"mem\":{\"capacity\":4,"))) goto end;
+    status = success;
+
+end:
+    RM_metrics_set_level(RM_METRICS_COUNTS);
+    RM_mem_handler_terminate();
+    fclose(stream);
+    printf("metrics: %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_cache() {
+    void *buffers[8];
+    void *buffer = NULL;
+    void *copy;
+    pthread_t threads[2];
+    struct IdleThread idle = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 };
+    int idle_started = 0;
+    int borrowed = 0;
+    Status status = failure;
+
+    // Batches of 2 buffers: each magazine holds at most 4 buffers.
+    RM_init(-1, 0, NULL);
+    RM_mem_handler_configure(2);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 8)) goto end;
+
+    // The buffer given back stays in the magazine of this thread: a double give back is detected anyway.
+    if (RM_failure == BORROW(RM_mem_handler, &buffer, 1, RM_false)) goto end;
+    copy = buffer;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 2)) goto end;
+    if (RM_success == GIVE_BACK(RM_mem_handler, &copy, 3)) goto end;
+    // The magazine serves the buffer that was just given back.
+    if ((RM_failure == BORROW(RM_mem_handler, &buffer, 4, RM_false)) || (copy != buffer)) goto end;
+    if (RM_failure == GIVE_BACK(RM_mem_handler, &buffer, 5)) goto end;
+
+    // The magazines of the threads are drained when the threads exit, and the magazine of this thread is drained
+    // when a batch needs its buffers: all the buffers can be borrowed at once.
+    for (int i = 0; i < 2; i++) {
+        if (0 != pthread_create(&threads[i], NULL, borrow_ten_times, NULL)) goto end;
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    if (RM_failure == BORROW_MANY(RM_mem_handler, buffers, 8, 6, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, 8, 7)) goto end;
+
+    // A new pool: the magazine filled from the previous pool is forgotten.
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 8)) goto end;
+    if (RM_failure == BORROW_MANY(RM_mem_handler, buffers, 8, 8, RM_false)) goto end;
+    if (RM_success == BORROW(RM_mem_handler, &buffer, 9, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_mem_handler, buffers, 8, 10)) goto end;
+
+    // A waiter reclaims the buffers kept in the magazine of an idle thread.
+    if (0 != pthread_create(&threads[0], NULL, borrow_and_idle, &idle)) goto end;
+    idle_started = 1;
+    pthread_mutex_lock(&idle.lock);
+    while (! idle.ready) {
+        pthread_cond_wait(&idle.condition, &idle.lock);
+    }
+    pthread_mutex_unlock(&idle.lock);
+    for (; borrowed < 8; borrowed++) {
+        if (RM_failure == RM_mem_borrow_timed(&buffers[borrowed], 1000, 11, RM_false)) break;
+    }
+    for (int i = 0; i < borrowed; i++) {
+        GIVE_BACK(RM_mem_handler, &buffers[i], 12);
+    }
+    if (8 != borrowed) goto end;
+    status = success;
+
+end:
+    if (idle_started) {
+        pthread_mutex_lock(&idle.lock);
+        idle.released = 1;
+        pthread_cond_broadcast(&idle.condition);
+        pthread_mutex_unlock(&idle.lock);
+        pthread_join(threads[0], NULL);
+    }
+    RM_mem_handler_configure(0);
+    RM_mem_handler_terminate();
+    printf("cache:   %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_elastic() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char path[PATH_CAPACITY];
+    RM_ConnectionFactory factory;
+    RM_PoolPolicy conn_policy = { 1, 3, CONN_IDLE_TIMEOUT_MS };
+    RM_PoolPolicy file_policy = { 0, 0, CONN_IDLE_TIMEOUT_MS };
+    RM_PoolPolicy no_policy = { 0, 0, 0 };
+    RM_EchoConnection *connections[CONN_CAPACITY];
+    int *fd = NULL;
+    struct timespec pause = { 0, 2 * CONN_IDLE_TIMEOUT_MS * 1000000 };
+    Status status = failure;
+
+    if (NULL == mkdtemp(directory)) return failure;
+    snprintf(path, PATH_CAPACITY, "%s/echo.sock", directory);
+    RM_init(-1, 0, NULL);
+    if (RM_failure == RM_echo_server_start(path)) goto end;
+    factory = RM_echo_factory(path);
+    RM_conn_handler_configure(&factory, 0, 0);
+    RM_conn_handler_set_policy(&conn_policy);
+    RM_file_handler_set_policy(&file_policy);
+
+    // Prewarm: 3 connections are opened by the initialization. The pool grows on demand, up to its capacity.
+    if (RM_failure == RM_conn_handler_init(0, CONN_CAPACITY)) goto end;
+    if (RM_failure == RM_file_handler_init(0, FILE_CAPACITY)) goto end;
+    if (3 != RM_conn_handler_open_count()) goto end;
+    for (int i = 0; i < CONN_CAPACITY; i++) {
+        if (RM_failure == BORROW(RM_conn_handler, &connections[i], 1, RM_false)) goto end;
+    }
+    if (CONN_CAPACITY != RM_conn_handler_open_count()) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_conn_handler, connections, CONN_CAPACITY, 3)) goto end;
+    if (RM_failure == BORROW(RM_file_handler, &fd, 4, RM_false, "/etc/hosts", O_RDONLY)) goto end;
+    if (RM_failure == GIVE_BACK(RM_file_handler, &fd, 5)) goto end;
+
+    // The idle resources expire, but they are only closed by the reaper (here, called by this thread).
+    nanosleep(&pause, NULL);
+    if ((CONN_CAPACITY != RM_conn_handler_open_count()) || (1 != RM_file_handler_open_count())) goto end;
+    RM_reaper_run();
+    if ((1 != RM_conn_handler_open_count()) || (0 != RM_file_handler_open_count())) goto end;
+
+    // The background reaper.
+    if (RM_failure == BORROW_MANY(RM_conn_handler, connections, 2, 6, RM_false)) goto end;
+    if (RM_failure == GIVE_BACK_MANY(RM_conn_handler, connections, 2, 7)) goto end;
+    if (2 != RM_conn_handler_open_count()) goto end;
+    if (RM_failure == RM_reaper_start(CONN_IDLE_TIMEOUT_MS / 4)) goto end;
+    if (RM_success == RM_reaper_start(CONN_IDLE_TIMEOUT_MS / 4)) goto end;
+    nanosleep(&pause, NULL);
+    nanosleep(&pause, NULL);
+    if (1 != RM_conn_handler_open_count()) goto end;
+
+    // `RM_init()` warms the initialized handlers up again.
+    RM_init(-1, 0, NULL);
+    if (3 != RM_conn_handler_open_count()) goto end;
+    status = success;
+
+end:
+    RM_reaper_stop();
+    RM_reaper_stop(); // it does not harm
+    RM_conn_handler_terminate();
+    RM_file_handler_terminate();
+    RM_file_handler_set_policy(&no_policy);
+    RM_echo_server_stop();
+    unlink(path);
+    rmdir(directory);
+    printf("elastic: %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+Status
+test_typed() {
+    char directory[] = "/tmp/pattern8-XXXXXX";
+    char path[PATH_CAPACITY];
+    char line[PATH_CAPACITY];
+    void *buffer = NULL;
+    void *copy;
+    int *fd = NULL;
+    FILE *stream = tmpfile();
+    Status status = failure;
+
+    if (NULL == stream) return failure;
+    if (NULL == mkdtemp(directory)) {
+        fclose(stream);
+        return failure;
+    }
+    snprintf(path, PATH_CAPACITY, "%s/typed.txt", directory);
+    RM_init(-1, 0, NULL);
+    RM_ledger_enable(RM_false);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 1)) goto end;
+    if (RM_failure == RM_file_handler_init(0, FILE_CAPACITY)) goto end;
+
+    // The typed macros give the location of the call to the handler.
+    if (RM_failure == RM_mem_borrow(&buffer, 1, RM_true)) goto end;
+    if (RM_success == RM_mem_borrow_timed(&copy, 1, 2, RM_false)) goto end;
+    if (1 != RM_report_outstanding(stream)) goto end;
+    rewind(stream);
+    if ((NULL == fgets(line, PATH_CAPACITY, stream)) || (NULL == strstr(line, "pattern8.c"))
+        || (NULL == strstr(line, "[test_typed]"))) {
+        goto end;
+    }
+    copy = buffer;
+    if (RM_failure == RM_mem_give_back(&buffer, 3)) goto end;
+    if ((NULL != buffer) || (RM_success == RM_mem_give_back(&copy, 4))) goto end;
+
+    // The arguments specific to the handler are checked by the compiler (`int **`, `const char *`...).
+    if (RM_failure == RM_file_borrow(&fd, 5, RM_false, path, O_WRONLY | O_CREAT, 0600)) goto end;
+    if (2 != write(*fd, "ok", 2)) goto end;
+    if (RM_failure == RM_file_give_back(&fd, 6)) goto end;
+    if (RM_failure == RM_file_borrow(&fd, 7, RM_true, path, O_WRONLY | O_CREAT, 0600)) goto end;
+    if (RM_failure == RM_file_give_back(&fd, 8)) goto end;
+    if ((1 != RM_file_handler_open_count()) || (0 != RM_report_outstanding(NULL))) goto end;
+    status = success;
+
+end:
+    RM_ledger_disable();
+    RM_file_handler_terminate();
+    RM_mem_handler_terminate();
+    fclose(stream);
+    unlink(path);
+    rmdir(directory);
+    printf("typed:   %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+#if RM_HAS_CLEANUP
+
+/**
+ * @brief Borrow a buffer into a scoped variable, and return without giving it back.
+ */
+
+static Status
+borrow_scoped() {
+    void *buffer RM_SCOPED_MEM = NULL;
+    return RM_success == RM_mem_borrow(&buffer, 1, RM_false) ? success : failure;
+}
+
+/**
+ * @brief Borrow a buffer through a frame, and return from the frame.
+ */
+
+static Status
+borrow_in_frame() {
+    RM_FRAME(frame) {
+        void *buffer;
+        return RM_success == RM_frame_mem_borrow(&frame, &buffer, 2, RM_false) ? success : failure;
+    }
+    return failure;
+}
+
+#endif // RM_HAS_CLEANUP
+
+/**
+ * @brief Tell whether all the buffers of the pool (2) are free, and no resource is outstanding.
+ */
+
+static Status
+all_given_back() {
+    void *buffers[2];
+    if ((0 != RM_report_outstanding(NULL)) || (RM_failure == BORROW_MANY(RM_mem_handler, buffers, 2, 3, RM_false))) {
+        return failure;
+    }
+    return RM_success == GIVE_BACK_MANY(RM_mem_handler, buffers, 2, 4) ? success : failure;
+}
+
+Status
+test_scope() {
+    void *buffers[3];
+    int *fd;
+    Status frame_status = failure;
+    Status status = failure;
+
+    RM_init(-1, 0, NULL);
+    RM_ledger_enable(RM_false);
+    if (RM_failure == RM_mem_handler_init(MEM_OBJECT_SIZE, 2)) goto end;
+    if (RM_failure == RM_file_handler_init(0, FILE_CAPACITY)) goto end;
+
+#if RM_HAS_CLEANUP
+    // Scoped variable.
+    if ((failure == borrow_scoped()) || (failure == all_given_back())) goto end;
+#endif
+
+    // The resources of a frame are given back at the end of the block, by `break`, and by `return` (with compiler
+    // support).
+    RM_FRAME(frame) {
+        if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[0], 5, RM_false)) break;
+        if (RM_failure == RM_frame_file_borrow(&frame, &fd, 6, RM_false, "/etc/hosts", O_RDONLY, 0)) break;
+        if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[1], 7, RM_false)) break;
+        if (RM_success == RM_frame_mem_borrow(&frame, &buffers[2], 8, RM_false)) break; // the pool is exhausted
+        if ((3 != frame.count) || (3 != RM_report_outstanding(NULL))) break;
+        frame_status = success;
+    }
+    if ((failure == frame_status) || (failure == all_given_back()) || (1 != RM_file_handler_open_count())) goto end;
+    frame_status = failure;
+    RM_FRAME(frame) {
+        if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[0], 9, RM_false)) break;
+        frame_status = success;
+        break;
+    }
+    if ((failure == frame_status) || (failure == all_given_back())) goto end;
+#if RM_HAS_CLEANUP
+    if ((failure == borrow_in_frame()) || (failure == all_given_back())) goto end;
+#endif
+
+    // A resource given back explicitly does not prevent the frame from giving back the others.
+    RM_FRAME(frame) {
+        if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[0], 10, RM_false)) break;
+        if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[1], 11, RM_false)) break;
+        GIVE_BACK(RM_mem_handler, &buffers[0], 12);
+    }
+    if (failure == all_given_back()) goto end;
+    status = success;
+
+end:
+    RM_ledger_disable();
+    RM_file_handler_terminate();
+    RM_mem_handler_terminate();
+    printf("scope:   %s\n", success == status ? "success" : "failure");
+    return status;
+}
+
+int
+main() {
+    if (failure == test_mem()) return EXIT_ERROR;
+    if (failure == test_file()) return EXIT_ERROR;
+    if (failure == test_conn()) return EXIT_ERROR;
+    if (failure == test_many()) return EXIT_ERROR;
+    if (failure == test_wait()) return EXIT_ERROR;
+    if (failure == test_ledger()) return EXIT_ERROR;
+    if (failure == test_report()) return EXIT_ERROR;
+    if (failure == test_fault()) return EXIT_ERROR;
+    if (failure == test_metrics()) return EXIT_ERROR;
+    if (failure == test_cache()) return EXIT_ERROR;
+    if (failure == test_elastic()) return EXIT_ERROR;
+    if (failure == test_typed()) return EXIT_ERROR;
+    if (failure == test_scope()) return EXIT_ERROR;
+    if (failure == test_cancel()) return EXIT_ERROR;
+    return EXIT_SUCCESS;
+}
@@ -1,11 +1,55 @@
+#include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
 #include "resource_manager.h"
+#include "rm_fault.h"
+#include "rm_reaper.h"
+#include "rm_report.h"
 
-static char *REPORT_FILE       = NULL;
-static long CALL_FAILURE_ID    = -1;
-static long CALL_COUNT_SUCCESS = 0;
-static long CALL_COUNT         = 0;
+#define LEDGER_INITIAL_CAPACITY 64
+// The ledger is split into 2^LEDGER_SHARDS_BITS shards, each one with its own lock.
+#define LEDGER_SHARDS_BITS 4
+#define LEDGER_SHARDS (1 << LEDGER_SHARDS_BITS)
+#define RECORD_SIZE 512
+#define RECORD_ADDRESS_SIZE 20 // "0x" + 16 hexadecimal digits + ","
+
+/**
+ * The ledger of the outstanding borrows: a hash table (open addressing, linear probing) indexed by the address
+ * of the borrowed resource. A borrow inserts an entry, a give back removes it: both are O(1) on average.
+ *
+ * The table is split into shards (selected by the most significant bits of the hash), and each shard has its own
+ * lock: the threads that borrow or give back different resources rarely wait for each other.
+ */
+
+struct LedgerEntry {
+    const void    *handle; // NULL: the slot is empty
+    long          uid;
+    const char    *type;
+    const char    *file;
+    unsigned long line;
+    const char    *function;
+    int64_t       since_ns;
+};
+
+struct LedgerShard {
+    pthread_mutex_t    lock;
+    struct LedgerEntry *entries;
+    size_t             capacity; // a power of 2
+    size_t             count;
+};
+
+static struct LedgerShard LEDGER[LEDGER_SHARDS];
+static pthread_once_t     LEDGER_ONCE          = PTHREAD_ONCE_INIT; // initializes the locks of the shards
+static int                LEDGER_ENABLED       = 0; // read without the lock (acquire: it publishes the locks)
+static int                LEDGER_AT_EXIT       = 0;
+static unsigned long      DOUBLE_GIVE_BACKS    = 0; // the counters are updated atomically
+static unsigned long      DUPLICATE_BORROWS    = 0;
+static unsigned long      UNKNOWN_GIVE_BACKS   = 0;
+static pthread_mutex_t    LEDGER_LOCK          = PTHREAD_MUTEX_INITIALIZER; // serializes `RM_ledger_enable()`
 
 /**
  * @brief Initialize the library.
@@ -24,8 +68,13 @@ static long CALL_COUNT         = 0;
  * @param in_count_success For the specified ID `in_id_failure`, the number of times a call to the function
  * succeeds until it fails programmatically. If the given value is negative or zero, then the first
  * call to the function will fail programmatically (for the given ID `in_id_failure`).
+ * The programmatic failure is a fault injection rule (see `RM_fault_add()`): this function replaces all the rules.
+ *
  * @param in_report_path Path to a file used to record data relative to all "borrow" / "give back".
- * If NULL, then no data is recorded.
+ * If NULL, then no data is recorded. The file stays open until the next call (see `RM_report_open()`): the
+ * records are buffered, and written into the file in blocks.
+ * @note The handlers that are already initialized open their resources again, up to their `prewarm_size` (see
+ * `RM_reaper_prewarm()`). The other handlers are warmed up by their own initialization.
  * @note Please note that this function may (and probably will) be called multiple times.
  */
 
@@ -34,58 +83,565 @@ RM_init(
         const long in_id_failure,
         const long in_count_success,
         char *in_report_path) {
-    CALL_FAILURE_ID    = in_id_failure;
-    CALL_COUNT_SUCCESS = in_count_success;
-    REPORT_FILE        = in_report_path;
+    RM_fault_clear();
+    if (in_id_failure >= 0) {
+        const RM_FaultRule rule = { in_id_failure, NULL, RM_FAULT_AFTER, in_count_success };
+        RM_fault_add(&rule);
+    }
+    RM_report_open(in_report_path);
+    // A failed warm-up is not fatal: the resources are opened on demand.
+    RM_reaper_prewarm();
+}
+
+/**
+ * @brief Tell whether a call to `borrow()` must fail programmatically (see `RM_init()`).
+ * @param in_uid Unique ID of the call to `borrow()`.
+ * @return If the call must fail: RM_true. Otherwise: RM_false.
+ * @note Only the rules that apply to all the types of resources are checked. The resource handlers call
+ * `RM_fault_check()`, which also checks the rules for their type.
+ */
+
+RM_Bool
+RM_must_fail(const long in_uid) {
+    return RM_fault_check(NULL, in_uid);
+}
+
+RM_Status
+RM_none_handler_init(
+        size_t in_object_size,
+        size_t in_capacity) {
+    (void) in_object_size;
+    (void) in_capacity;
+    return RM_success;
 }
 
+/**
+ * @brief Borrow a resource which type has no implementation yet.
+ * @return Always RM_failure.
+ */
+
 RM_Status
-RM_borrow() {
+RM_none_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    (void) in_uid;
+    (void) in_file;
+    (void) in_line;
+    (void) in_function;
+    (void) in_init;
+    *in_ptr = NULL;
+    return RM_failure;
+}
 
+RM_Status
+RM_none_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    (void) in_uid;
+    (void) in_file;
+    (void) in_line;
+    (void) in_function;
+    *in_ptr = NULL;
     return RM_success;
 }
 
+/**
+ * @brief Borrow resources which type has no implementation yet.
+ * @return Always RM_failure.
+ */
+
 RM_Status
-RM_give_back() {
+RM_none_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    (void) in_uid;
+    (void) in_file;
+    (void) in_line;
+    (void) in_function;
+    (void) in_init;
+    for (size_t i = 0; i < in_count; i++) {
+        in_ptrs[i] = NULL;
+    }
+    return RM_failure;
+}
 
+RM_Status
+RM_none_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    (void) in_uid;
+    (void) in_file;
+    (void) in_line;
+    (void) in_function;
+    for (size_t i = 0; i < in_count; i++) {
+        in_ptrs[i] = NULL;
+    }
     return RM_success;
 }
 
 void
-record_borrow(
-        void **in_ptr,
-        char *in_type,
-        long in_id,
+RM_none_handler_terminate() {}
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+ledger_init_locks() {
+    for (size_t i = 0; i < LEDGER_SHARDS; i++) {
+        pthread_mutex_init(&LEDGER[i].lock, NULL);
+    }
+}
+
+static uint64_t
+ledger_hash(const void *in_handle) {
+    uint64_t hash = (uint64_t)(uintptr_t) in_handle;
+    // The resources are aligned: mix the bits, so that the low bits of the index are not always 0.
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static size_t
+ledger_shard(const void *in_handle) {
+    return (size_t)(ledger_hash(in_handle) >> (64 - LEDGER_SHARDS_BITS));
+}
+
+/**
+ * @brief Find the slot of a handle (or the empty slot where it would be inserted).
+ * @note The lock of the shard must be held, and the shard must be allocated.
+ */
+
+static size_t
+ledger_find(
+        const struct LedgerShard *in_shard,
+        const void *in_handle) {
+    size_t slot = (size_t) ledger_hash(in_handle) & (in_shard->capacity - 1);
+    while ((NULL != in_shard->entries[slot].handle) && (in_handle != in_shard->entries[slot].handle)) {
+        slot = (slot + 1) & (in_shard->capacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * @brief Double the capacity of a shard (or allocate it).
+ * @return On success: 0. Otherwise: -1.
+ * @note The lock of the shard must be held.
+ */
+
+static int
+ledger_grow(struct LedgerShard *in_shard) {
+    struct LedgerEntry *old = in_shard->entries;
+    const size_t old_capacity = in_shard->capacity;
+    const size_t capacity = 0 == old_capacity ? LEDGER_INITIAL_CAPACITY : 2 * old_capacity;
+    struct LedgerEntry *entries = (struct LedgerEntry *) calloc(capacity, sizeof(struct LedgerEntry));
+
+    if (NULL == entries) return -1;
+    in_shard->entries = entries;
+    in_shard->capacity = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (NULL != old[i].handle) entries[ledger_find(in_shard, old[i].handle)] = old[i];
+    }
+    free(old);
+    return 0;
+}
+
+/**
+ * @brief Insert a handle into a shard. If the handle is already in the shard, then it has been borrowed twice
+ * (without being given back): this is printed (on the standard error) immediately.
+ * @note The lock of the shard must be held.
+ */
+
+static void
+ledger_insert(
+        struct LedgerShard *in_shard,
+        const void *in_handle,
+        const char *in_type,
+        const long in_uid,
         const char *in_file,
-        unsigned long in_line,
+        const unsigned long in_line,
+        const char *in_function,
+        const int64_t in_now_ns) {
+    struct LedgerEntry *entry;
+
+    // The load factor is kept below 1/2, so that the probe sequences stay short.
+    if ((2 * (in_shard->count + 1) > in_shard->capacity) && (0 != ledger_grow(in_shard))) return;
+    entry = &in_shard->entries[ledger_find(in_shard, in_handle)];
+    if (NULL == entry->handle) {
+        in_shard->count++;
+    } else {
+        __atomic_fetch_add(&DUPLICATE_BORROWS, 1, __ATOMIC_RELAXED);
+        fprintf(stderr,
+                "WARNING: %s %p borrowed at [%s]:%lu [%s] (%ld) is already borrowed at [%s]:%lu [%s] (%ld)!\n",
+                in_type,
+                in_handle,
+                NULL != in_file ? in_file : "",
+                in_line,
+                NULL != in_function ? in_function : "",
+                in_uid,
+                NULL != entry->file ? entry->file : "",
+                entry->line,
+                NULL != entry->function ? entry->function : "",
+                entry->uid);
+    }
+    entry->handle   = in_handle;
+    entry->uid      = in_uid;
+    entry->type     = in_type;
+    entry->file     = in_file;
+    entry->line     = in_line;
+    entry->function = in_function;
+    entry->since_ns = in_now_ns;
+}
+
+/**
+ * @brief Remove a handle from a shard. The entries that follow it in the probe sequence are moved back
+ * ("backward shift deletion"), so that no tombstone is needed.
+ * @return If the handle was in the shard: 1. Otherwise: 0.
+ * @note The lock of the shard must be held.
+ */
+
+static int
+ledger_remove(
+        struct LedgerShard *in_shard,
+        const void *in_handle) {
+    const size_t mask = in_shard->capacity - 1;
+    size_t hole;
+    size_t slot;
+
+    if (0 == in_shard->capacity) return 0;
+    hole = ledger_find(in_shard, in_handle);
+    if (NULL == in_shard->entries[hole].handle) return 0;
+    in_shard->entries[hole].handle = NULL;
+    in_shard->count--;
+    for (slot = (hole + 1) & mask; NULL != in_shard->entries[slot].handle; slot = (slot + 1) & mask) {
+        const size_t home = (size_t) ledger_hash(in_shard->entries[slot].handle) & mask;
+        // Move the entry into the hole if its home slot is not between the hole and the entry (cyclically).
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            in_shard->entries[hole] = in_shard->entries[slot];
+            in_shard->entries[slot].handle = NULL;
+            hole = slot;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Return the set of the shards of a batch of handles.
+ * @return A bit mask: the bit `i` is set if at least one handle belongs to the shard `i`.
+ */
+
+static unsigned int
+ledger_shards_of(
+        void **in_ptrs,
+        const size_t in_count) {
+    unsigned int shards = 0;
+    for (size_t i = 0; i < in_count; i++) {
+        if (NULL != in_ptrs[i]) shards |= 1u << ledger_shard(in_ptrs[i]);
+    }
+    return shards;
+}
+
+/**
+ * @brief Insert a batch of handles into the ledger. Each shard is locked once for the whole batch.
+ */
+
+static void
+ledger_insert_all(
+        void **in_ptrs,
+        const size_t in_count,
+        const char *in_type,
+        const long in_uid,
+        const char *in_file,
+        const unsigned long in_line,
         const char *in_function) {
-    FILE *fd;
+    unsigned int shards;
+    int64_t now;
 
-    if (NULL == REPORT_FILE) return;
+    if (! __atomic_load_n(&LEDGER_ENABLED, __ATOMIC_ACQUIRE)) return;
+    shards = ledger_shards_of(in_ptrs, in_count);
+    now = now_ns();
+    for (size_t s = 0; 0 != shards; s++, shards >>= 1) {
+        if (0 == (shards & 1)) continue;
+        pthread_mutex_lock(&LEDGER[s].lock);
+        for (size_t i = 0; i < in_count; i++) {
+            if ((NULL == in_ptrs[i]) || (s != ledger_shard(in_ptrs[i]))) continue;
+            ledger_insert(&LEDGER[s], in_ptrs[i], in_type, in_uid, in_file, in_line, in_function, now);
+        }
+        pthread_mutex_unlock(&LEDGER[s].lock);
+    }
+}
+
+/**
+ * @brief Remove a batch of handles from the ledger. Each shard is locked once for the whole batch. A handle that
+ * is not in the ledger has not been borrowed since the ledger was enabled: this is printed (on the standard error)
+ * immediately.
+ */
 
-    fd = fopen(REPORT_FILE,
-               "a");
-    if (NULL == fd) {
-        fprintf(stderr, "WARNING: cannot open report file \"%s\"!\n", REPORT_FILE);
-        return;
+static void
+ledger_remove_all(
+        void **in_ptrs,
+        const size_t in_count,
+        const char *in_type,
+        const long in_uid,
+        const char *in_file,
+        const unsigned long in_line,
+        const char *in_function) {
+    unsigned int shards;
+
+    if (! __atomic_load_n(&LEDGER_ENABLED, __ATOMIC_ACQUIRE)) return;
+    shards = ledger_shards_of(in_ptrs, in_count);
+    for (size_t s = 0; 0 != shards; s++, shards >>= 1) {
+        if (0 == (shards & 1)) continue;
+        pthread_mutex_lock(&LEDGER[s].lock);
+        for (size_t i = 0; i < in_count; i++) {
+            if ((NULL == in_ptrs[i]) || (s != ledger_shard(in_ptrs[i]))) continue;
+            if (ledger_remove(&LEDGER[s], in_ptrs[i])) continue;
+            __atomic_fetch_add(&UNKNOWN_GIVE_BACKS, 1, __ATOMIC_RELAXED);
+            fprintf(stderr,
+                    "WARNING: give back of %s %p at [%s]:%lu [%s] (%ld): it is not in the ledger!\n",
+                    in_type,
+                    in_ptrs[i],
+                    NULL != in_file ? in_file : "",
+                    in_line,
+                    NULL != in_function ? in_function : "",
+                    in_uid);
+        }
+        pthread_mutex_unlock(&LEDGER[s].lock);
+    }
+}
+
+static void
+report_at_exit() {
+    if (LEDGER_AT_EXIT) RM_report_outstanding(stderr);
+}
+
+/**
+ * @brief Start recording the outstanding borrows (see `RM_report_outstanding()`).
+ * @param in_report_at_exit Flag that tells whether the outstanding borrows must be printed (on the standard error)
+ * when the process exits.
+ * @note The resources borrowed before this call are not recorded. The strings given to the handlers (`in_file`,
+ * `in_function`) are not copied: they must stay valid (`__FILE__` and `__func__` do).
+ */
+
+void
+RM_ledger_enable(const RM_Bool in_report_at_exit) {
+    static int registered = 0;
+
+    pthread_once(&LEDGER_ONCE, ledger_init_locks);
+    pthread_mutex_lock(&LEDGER_LOCK);
+    if (in_report_at_exit && (! registered)) registered = 0 == atexit(report_at_exit);
+    LEDGER_AT_EXIT = in_report_at_exit ? 1 : 0;
+    __atomic_store_n(&LEDGER_ENABLED, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&LEDGER_LOCK);
+}
+
+/**
+ * @brief Stop recording the outstanding borrows, and forget the recorded borrows.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_ledger_disable() {
+    pthread_once(&LEDGER_ONCE, ledger_init_locks);
+    pthread_mutex_lock(&LEDGER_LOCK);
+    __atomic_store_n(&LEDGER_ENABLED, 0, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < LEDGER_SHARDS; i++) {
+        pthread_mutex_lock(&LEDGER[i].lock);
+        free(LEDGER[i].entries);
+        LEDGER[i].entries  = NULL;
+        LEDGER[i].capacity = 0;
+        LEDGER[i].count    = 0;
+        pthread_mutex_unlock(&LEDGER[i].lock);
     }
+    LEDGER_AT_EXIT = 0;
+    __atomic_store_n(&DOUBLE_GIVE_BACKS, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&DUPLICATE_BORROWS, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&UNKNOWN_GIVE_BACKS, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&LEDGER_LOCK);
+}
+
+/**
+ * @brief Print the resources that are borrowed and not given back yet (see `RM_ledger_enable()`).
+ * @param in_stream The stream to print into (NULL: nothing is printed).
+ * @return The number of outstanding borrows.
+ */
+
+size_t
+RM_report_outstanding(FILE *in_stream) {
+    const int64_t now = now_ns();
+    size_t count = 0;
+
+    pthread_once(&LEDGER_ONCE, ledger_init_locks);
+    for (size_t s = 0; s < LEDGER_SHARDS; s++) {
+        struct LedgerShard *shard = &LEDGER[s];
+        pthread_mutex_lock(&shard->lock);
+        count += shard->count;
+        for (size_t i = 0; (NULL != in_stream) && (i < shard->capacity); i++) {
+            const struct LedgerEntry *entry = &shard->entries[i];
+            if (NULL == entry->handle) continue;
+            fprintf(in_stream,
+                    "OUTSTANDING %s %p borrowed at [%s]:%lu [%s] (%ld), %.3f ms ago\n",
+                    entry->type,
+                    entry->handle,
+                    NULL != entry->file ? entry->file : "",
+                    entry->line,
+                    NULL != entry->function ? entry->function : "",
+                    entry->uid,
+                    (double)(now - entry->since_ns) / 1e6);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    return count;
+}
+
+/**
+ * @brief Return the number of double give backs detected (see `record_give_back_failure()`).
+ * @return The number of double give backs.
+ */
+
+unsigned long
+RM_ledger_double_give_backs() {
+    return __atomic_load_n(&DOUBLE_GIVE_BACKS, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Return the number of resources borrowed while they were already outstanding (see `ledger_insert()`).
+ * @return The number of duplicate borrows.
+ */
+
+unsigned long
+RM_ledger_duplicate_borrows() {
+    return __atomic_load_n(&DUPLICATE_BORROWS, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Return the number of resources given back that were not in the ledger (see `ledger_remove_all()`).
+ * @return The number of unknown give backs.
+ */
+
+unsigned long
+RM_ledger_unknown_give_backs() {
+    return __atomic_load_n(&UNKNOWN_GIVE_BACKS, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Report the resources that a handler refused to give back. If the ledger is enabled, and a resource is
+ * not outstanding, then it has already been given back (or it has never been borrowed): the double give back is
+ * printed (on the standard error) immediately.
+ * @param in_ptrs An array of `in_count` pointers to the resources. The NULL pointers are ignored.
+ * @param in_count The number of pointers.
+ * @param in_type The type of the resources.
+ * @param in_id Unique ID of the call to `give_back()`.
+ * @param in_file Path to the file from which `give_back()` is called.
+ * @param in_line The line, within the file `in_file`, where `give_back()` is called.
+ * @param in_function Name of the function from which `give_back()` is called.
+ */
+
+void
+record_give_back_failure(
+        void **in_ptrs,
+        size_t in_count,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    if (! __atomic_load_n(&LEDGER_ENABLED, __ATOMIC_ACQUIRE)) return;
+    for (size_t i = 0; i < in_count; i++) {
+        struct LedgerShard *shard;
+        int outstanding;
 
-    if (fprintf(fd,
-                "B %s %s[%s] [%s]:%lud %p %p (%ld)\n",
+        if (NULL == in_ptrs[i]) continue;
+        shard = &LEDGER[ledger_shard(in_ptrs[i])];
+        pthread_mutex_lock(&shard->lock);
+        outstanding = (0 != shard->capacity) && (NULL != shard->entries[ledger_find(shard, in_ptrs[i])].handle);
+        pthread_mutex_unlock(&shard->lock);
+        if (outstanding) continue;
+        __atomic_fetch_add(&DOUBLE_GIVE_BACKS, 1, __ATOMIC_RELAXED);
+        fprintf(stderr,
+                "WARNING: double give back of %s %p at [%s]:%lu [%s] (%ld): it is not borrowed!\n",
                 in_type,
-                (NULL != in_function) ? "+" : "-",
-                (NULL != in_function) ? in_function : "",
-                in_file,
+                in_ptrs[i],
+                NULL != in_file ? in_file : "",
                 in_line,
-                in_ptr,  // the address of the pointer used to store the address of the borrowed resource handler
-                *in_ptr, // the address of the borrowed resource handler
-                in_id) < 0) {
-        fprintf(stderr, "WARNING: error while while writing into report file \"%s\"!\n", REPORT_FILE);
+                NULL != in_function ? in_function : "",
+                in_id);
     }
+}
 
-    if (0 != fclose(fd)) {
-        fprintf(stderr, "WARNING: error while closing report file \"%s\"!\n", REPORT_FILE);
+/**
+ * @brief Format a record, and add it to the report (see `RM_report_write()`).
+ * @param in_format The format of the record (see `printf()`).
+ */
+
+static void
+report(const char *in_format, ...) {
+    char buffer[RECORD_SIZE];
+    char *record = buffer;
+    va_list arguments;
+    int length;
+
+    va_start(arguments, in_format);
+    length = vsnprintf(buffer, sizeof(buffer), in_format, arguments);
+    va_end(arguments);
+    if ((length >= 0) && ((size_t) length >= sizeof(buffer))) {
+        record = (char *) malloc((size_t) length + 1);
+        if (NULL == record) length = -1;
+        else {
+            va_start(arguments, in_format);
+            length = vsnprintf(record, (size_t) length + 1, in_format, arguments);
+            va_end(arguments);
+        }
     }
+    if (length < 0) fprintf(stderr, "WARNING: error while while writing into report file!\n");
+    else RM_report_write(record, (size_t) length);
+    if (buffer != record) free(record);
+}
+
+void
+record_borrow(
+        void **in_ptr,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    ledger_insert_all(in_ptr, 1, in_type, in_id, in_file, in_line, in_function);
+    if (RM_false == RM_report_is_open()) return;
+
+    report("B %s %s[%s] [%s]:%lud %p %p (%ld)\n",
+           in_type,
+           (NULL != in_function) ? "+" : "-",
+           (NULL != in_function) ? in_function : "",
+           (NULL != in_file) ? in_file : "",
+           in_line,
+           (void *) in_ptr, // the address of the pointer used to store the address of the borrowed resource handler
+           *in_ptr,         // the address of the borrowed resource handler
+           in_id);
 }
 
 void
@@ -96,29 +652,93 @@ record_give_back(
         const char *in_file,
         unsigned long in_line,
         const char *in_function) {
+    ledger_remove_all(in_ptr, 1, in_type, in_id, in_file, in_line, in_function);
+    if (RM_false == RM_report_is_open()) return;
 
-    FILE *fd;
+    report("G %s %s[%s] [%s]:%lud %p %p (%ld)\n",
+           in_type,
+           (NULL != in_function) ? "+" : "-",
+           (NULL != in_function) ? in_function : "",
+           (NULL != in_file) ? in_file : "",
+           in_line,
+           (void *) in_ptr, // the address of the pointer used to store the address of the handler to the resource to give back
+           *in_ptr,         // the address of the handler to the resource to give back
+           in_id);
+}
 
-    if (NULL == REPORT_FILE) return;
+/**
+ * @brief Write a single record for a batch of resources ("BM" for `borrow_many()`, "GM" for `give_back_many()`).
+ * The record lists the addresses of the resources, separated by commas. A batch of NULL pointers is not recorded
+ * (as for `record_give_back()`, which is not called for a NULL pointer).
+ */
 
-    fd = fopen(REPORT_FILE, "a");
-    if (NULL == fd) {
-        fprintf(stderr, "WARNING: cannot open report file \"%s\"!\n", REPORT_FILE);
-        return;
-    }
-    if (fprintf(fd,
-                "G %s %s[%s] [%s]:%lud %p %p (%ld)\n",
-                in_type,
-                (NULL != in_function) ? "+" : "-",
-                (NULL != in_function) ? in_function : "",
-                in_file,
-                in_line,
-                in_ptr,  // the address of the pointer used to store the address of the handler to the resource to give back
-                *in_ptr, // the address of the handler to the resource to give back
-                in_id) < 0) {
-        fprintf(stderr, "WARNING: error while while writing into report file \"%s\"!\n", REPORT_FILE);
+static void
+record_many(
+        const char *in_action,
+        void **in_ptrs,
+        const size_t in_count,
+        const char *in_type,
+        const long in_id,
+        const char *in_file,
+        const unsigned long in_line,
+        const char *in_function) {
+    char buffer[RECORD_SIZE];
+    char *addresses = buffer;
+    size_t length = 0;
+    size_t i;
+
+    if (RM_false == RM_report_is_open()) return;
+    for (i = 0; (i < in_count) && (NULL == in_ptrs[i]); i++) {}
+    if (i == in_count) return;
+
+    if (in_count * RECORD_ADDRESS_SIZE + 1 > sizeof(buffer)) {
+        addresses = (char *) malloc(in_count * RECORD_ADDRESS_SIZE + 1);
+        if (NULL == addresses) {
+            fprintf(stderr, "WARNING: error while while writing into report file!\n");
+            return;
+        }
     }
-    if (0 != fclose(fd)) {
-        fprintf(stderr, "WARNING: error while closing report file \"%s\"!\n", REPORT_FILE);
+    addresses[0] = 0;
+    for (i = 0; i < in_count; i++) {
+        const int written = snprintf(addresses + length, RECORD_ADDRESS_SIZE + 1, i > 0 ? ",%p" : "%p", in_ptrs[i]);
+        if (written > 0) length += (size_t) written;
     }
+    report("%s %s %s[%s] [%s]:%lud %p %zu %s (%ld)\n",
+           in_action,
+           in_type,
+           (NULL != in_function) ? "+" : "-",
+           (NULL != in_function) ? in_function : "",
+           (NULL != in_file) ? in_file : "",
+           in_line,
+           (void *) in_ptrs, // the address of the array of pointers
+           in_count,
+           addresses,
+           in_id);
+    if (buffer != addresses) free(addresses);
+}
+
+void
+record_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    ledger_insert_all(in_ptrs, in_count, in_type, in_id, in_file, in_line, in_function);
+    record_many("BM", in_ptrs, in_count, in_type, in_id, in_file, in_line, in_function);
+}
+
+void
+record_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    ledger_remove_all(in_ptrs, in_count, in_type, in_id, in_file, in_line, in_function);
+    record_many("GM", in_ptrs, in_count, in_type, in_id, in_file, in_line, in_function);
 }
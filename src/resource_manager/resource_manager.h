@@ -2,20 +2,81 @@
 #define C_PATTERNS_RESOURCE_MANAGER_H
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
 
 enum RM_EnumStatus { RM_failure, RM_success };
 enum RM_EnumBool { RM_true=1, RM_false=0 };
 typedef enum RM_EnumStatus RM_Status;
 typedef enum RM_EnumBool RM_Bool;
 
+// The location of a call (file, line, function), given to the handlers by the typed macros (`RM_mem_borrow()`...).
+// It is used by the report and by the ledger. Compile with `-DRM_TRACE=0` to leave the locations out: the
+// records then show an empty location, and the calls do not carry the strings.
+#ifndef RM_TRACE
+#define RM_TRACE 1
+#endif
+#if RM_TRACE
+#define RM_HERE __FILE__, __LINE__, __func__
+#else
+#define RM_HERE NULL, 0, NULL
+#endif
+
 void
 RM_init(
         long in_id_failure,
         long in_count_success,
         char *in_report_path);
 
+RM_Bool
+RM_must_fail(
+        long in_uid);
+
+// The ledger of the outstanding borrows (leak detection):
+//
+//      RM_ledger_enable(RM_true); // the outstanding borrows are printed when the process exits
+//      ...
+//      if (0 != RM_report_outstanding(stdout)) { /* some resources have not been given back */ }
+
+void
+RM_ledger_enable(
+        RM_Bool in_report_at_exit);
+
+void
+RM_ledger_disable();
+
+size_t
+RM_report_outstanding(
+        FILE *in_stream);
+
+unsigned long
+RM_ledger_double_give_backs();
+
+unsigned long
+RM_ledger_duplicate_borrows();
+
+unsigned long
+RM_ledger_unknown_give_backs();
+
+
+/**
+ * A resource handler: the set of functions that manage one type of resource.
+ *
+ * The resource types, and their handlers, are declared by "pattern4.h" (see `handlers[]`).
+ * Please note that a handler manages a single resource type (its state is global).
+ */
 
 struct RM_StructResourceHandler {
+    /**
+     * @brief Initialize the handler.
+     * @param in_object_size The size of a resource (the meaning depends on the handler).
+     * @param in_capacity The maximum number of resources that can be borrowed at the same time.
+     * @return On success: RM_success. Otherwise: RM_failure.
+     * @note Please note that this function may be called multiple times.
+     */
+    RM_Status (*init)(
+            size_t in_object_size,
+            size_t in_capacity);
     /**
      * @brief Borrow a resource.
      * @param in_ptr The address of a pointer that will be assigned to the address of the borrowed resource handler.
@@ -33,7 +94,7 @@ struct RM_StructResourceHandler {
      * @param ... Other parameters that depend on the resource to borrow.
      * @return On success: RM_success. Otherwise: RM_failure.
      */
-    RM_Status *(*borrow)(
+    RM_Status (*borrow)(
             void **in_ptr,
             long in_uid,
             char *in_file,
@@ -55,19 +116,114 @@ struct RM_StructResourceHandler {
      * @param ... Other parameters that depend on the resource to borrow.
      * @return On success: RM_success. Otherwise: RM_failure.
      */
-    RM_Status *(*give_back)(
+    RM_Status (*give_back)(
             void **in_ptr,
             long in_uid,
             char *in_file,
             unsigned long in_line,
             char *in_function,
             ...);
+    /**
+     * @brief Borrow several resources at once. Either all the resources are borrowed, or none.
+     * The call is recorded once (see `record_borrow_many()`), and counts as a single call for `RM_must_fail()`.
+     * @param in_ptrs An array of `in_count` pointers that will be assigned to the addresses of the borrowed
+     * resource handlers. On failure, all the pointers are set to NULL.
+     * @param in_count The number of resources to borrow.
+     * @param in_uid Unique ID of the call to `borrow_many()`.
+     * @param in_file Path to the file from which this function is called.
+     * @param in_line The line, within the file `in_file`, where this function is called.
+     * @param in_function Name of the function from which this function is called.
+     * @param in_init Flag that tells whether the borrowed resources must be initialized or not.
+     * @param ... Other parameters that depend on the resources to borrow.
+     * @return On success: RM_success. Otherwise: RM_failure.
+     */
+    RM_Status (*borrow_many)(
+            void **in_ptrs,
+            size_t in_count,
+            long in_uid,
+            char *in_file,
+            unsigned long in_line,
+            char *in_function,
+            RM_Bool in_init,
+            ...);
+    /**
+     * @brief Give back several resources at once. Either all the resources are given back, or none.
+     * @param in_ptrs An array of `in_count` pointers that are assigned to the addresses of the borrowed resource
+     * handlers. On success, all the pointers are set to NULL. The NULL pointers are ignored.
+     * @param in_count The number of pointers in the array.
+     * @param in_uid Unique ID of the call to `give_back_many()`.
+     * @param in_file Path to the file from which this function is called.
+     * @param in_line The line, within the file `in_file`, where this function is called.
+     * @param in_function Name of the function from which this function is called.
+     * @param ... Other parameters that depend on the resources to give back.
+     * @return On success: RM_success. Otherwise: RM_failure.
+     */
+    RM_Status (*give_back_many)(
+            void **in_ptrs,
+            size_t in_count,
+            long in_uid,
+            char *in_file,
+            unsigned long in_line,
+            char *in_function,
+            ...);
+    /**
+     * @brief Release all the resources allocated by the handler.
+     * @note Please note that you can call this function multiple times.
+     */
+    void (*terminate)();
 };
 
 typedef struct RM_StructResourceHandler RM_ResourceHandler;
 
+// Handler of the resource types that have no implementation yet: `borrow()` always fails.
 
+RM_Status
+RM_none_handler_init(
+        size_t in_object_size,
+        size_t in_capacity);
 
+RM_Status
+RM_none_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_none_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+RM_Status
+RM_none_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_none_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+void
+RM_none_handler_terminate();
 
 void
 record_borrow(
@@ -87,4 +243,34 @@ record_give_back(
         unsigned long in_line,
         const char *in_function);
 
+void
+record_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+void
+record_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+void
+record_give_back_failure(
+        void **in_ptrs,
+        size_t in_count,
+        char *in_type,
+        long in_id,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
 #endif //C_PATTERNS_RESOURCE_MANAGER_H
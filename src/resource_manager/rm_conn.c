@@ -0,0 +1,672 @@
+/**
+ * Connection pool handler: keep the connections open, so that borrowing a connection does not connect.
+ *
+ * - At initialization, the pool opens `prewarm size` connections (warm-up), and at least `min size`. `RM_init()`
+ *   opens the missing connections again (see `RM_reaper_prewarm()`).
+ * - Borrowing a connection takes the most recently given back idle connection, after checking that it is still
+ *   usable (health check). If the check fails, then the connection is replaced. If there is no idle connection,
+ *   then a new connection is opened, unless `max size` connections are already open.
+ * - The idle connections that have not been used for `idle timeout` milliseconds are closed (as long as more
+ *   than `min size` connections are open). This is done when connections are given back (one per call), and by
+ *   the background reaper (see "rm_reaper.h"), never when connections are borrowed.
+ *
+ * The connections are created, checked and closed by a factory (see `RM_ConnectionFactory`), so that the pool
+ * can be used with any kind of connection. The factory calls are performed without holding the lock.
+ *
+ * When all the connections are borrowed, `RM_conn_handler_borrow_timed()` waits in a FIFO queue (see
+ * "rm_wait.c"): a slot that becomes available is handed to the oldest waiter.
+ *
+ * Please note: the connections are few (tens at most), so the borrowed connection is found by a linear search.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "resource_manager.h"
+#include "rm_fault.h"
+#include "rm_metrics.h"
+#include "rm_reaper.h"
+#include "rm_wait.h"
+#include "rm_conn.h"
+
+enum SlotState { SlotFree, SlotBorrowed, SlotIdle };
+
+struct Slot {
+    void           *connection;
+    enum SlotState state;
+    int64_t        last_used_ms;
+    int64_t        since_ns; // when the connection was borrowed (see `RM_metrics_clock()`)
+};
+
+static RM_ConnectionFactory FACTORY;
+static int                  CONFIGURED      = 0;
+static size_t               MIN_SIZE        = 0;
+static size_t               PREWARM_SIZE    = 0;
+static unsigned long        IDLE_TIMEOUT_MS = 0;
+static struct Slot          *SLOTS          = NULL;
+static size_t               MAX_SIZE        = 0;
+static unsigned long        OPEN_COUNT      = 0; // borrowed, idle, or being opened
+static pthread_mutex_t      LOCK            = PTHREAD_MUTEX_INITIALIZER;
+static RM_WaitQueue         QUEUE           = { NULL, NULL, { 0, 0, 0, 0, 0, 0 } }; // items: slot index + 1
+
+static int64_t
+now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Close an idle connection that has not been used for too long (at most one per call, so that the cost is
+ * spread over the calls to `give_back()`).
+ * @return If a connection was closed: 1. Otherwise: 0.
+ * @note The lock must not be held.
+ */
+
+static int
+reap_one() {
+    void *expired = NULL;
+    const int64_t now = now_ms();
+
+    pthread_mutex_lock(&LOCK);
+    if ((IDLE_TIMEOUT_MS > 0) && (OPEN_COUNT > MIN_SIZE)) {
+        for (size_t i = 0; i < MAX_SIZE; i++) {
+            if ((SlotIdle == SLOTS[i].state) && (now - SLOTS[i].last_used_ms >= (int64_t)IDLE_TIMEOUT_MS)) {
+                expired = SLOTS[i].connection;
+                SLOTS[i].connection = NULL;
+                SLOTS[i].state = SlotFree;
+                OPEN_COUNT--;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&LOCK);
+    if (NULL == expired) return 0;
+    FACTORY.disconnect(expired);
+    return 1;
+}
+
+/**
+ * @brief Close all the idle connections that have not been used for too long (see `RM_reaper_register()`).
+ */
+
+static void
+reap_all() {
+    while (reap_one()) {}
+}
+
+/**
+ * @brief Configure the pool. This function must be called before `RM_conn_handler_init()`.
+ * @param in_factory The functions used to create, check and close the connections.
+ * @param in_min_size The number of connections opened by `RM_conn_handler_init()`, and kept open even if they
+ * are idle.
+ * @param in_idle_timeout_ms The duration after which an idle connection is closed (if more than `in_min_size`
+ * connections are open). The value 0 means "never".
+ */
+
+void
+RM_conn_handler_configure(
+        const RM_ConnectionFactory *in_factory,
+        const size_t in_min_size,
+        const unsigned long in_idle_timeout_ms) {
+    pthread_mutex_lock(&LOCK);
+    FACTORY         = *in_factory;
+    MIN_SIZE        = in_min_size;
+    PREWARM_SIZE    = in_min_size;
+    IDLE_TIMEOUT_MS = in_idle_timeout_ms;
+    CONFIGURED      = 1;
+    pthread_mutex_unlock(&LOCK);
+}
+
+/**
+ * @brief Set the sizing policy of the pool (it replaces the sizes given to `RM_conn_handler_configure()`).
+ * @param in_policy The policy. The maximum size of the pool is the capacity given to `RM_conn_handler_init()`.
+ * @note The minimum size and the idle timeout apply immediately, the warm-up applies to the next initialization
+ * (of the handler, or of the library: see `RM_init()`).
+ */
+
+void
+RM_conn_handler_set_policy(const RM_PoolPolicy *in_policy) {
+    pthread_mutex_lock(&LOCK);
+    MIN_SIZE        = in_policy->min_size;
+    PREWARM_SIZE    = in_policy->prewarm_size;
+    IDLE_TIMEOUT_MS = in_policy->idle_ttl_ms;
+    pthread_mutex_unlock(&LOCK);
+}
+
+/**
+ * @brief Reserve slots for borrowers: the most recently used idle slots first (they are the least likely to
+ * have been closed by the server), then free slots.
+ * @param out_indexes An array that will receive the indexes of the `in_count` reserved slots.
+ * @param in_count The number of slots to reserve.
+ * @return If `in_count` slots are idle or free: RM_success. Otherwise, no slot is reserved: RM_failure.
+ * @note The lock must be held.
+ */
+
+static RM_Status
+reserve(
+        size_t *out_indexes,
+        const size_t in_count) {
+    size_t available = 0;
+
+    for (size_t i = 0; i < MAX_SIZE; i++) {
+        if (SlotBorrowed != SLOTS[i].state) available++;
+    }
+    if (available < in_count) return RM_failure;
+
+    for (size_t n = 0; n < in_count; n++) {
+        size_t index = MAX_SIZE;
+        size_t free_index = MAX_SIZE;
+        for (size_t i = 0; i < MAX_SIZE; i++) {
+            if ((SlotIdle == SLOTS[i].state)
+                && ((MAX_SIZE == index) || (SLOTS[i].last_used_ms > SLOTS[index].last_used_ms))) {
+                index = i;
+            }
+            if ((SlotFree == SLOTS[i].state) && (MAX_SIZE == free_index)) free_index = i;
+        }
+        if (MAX_SIZE == index) {
+            index = free_index;
+            OPEN_COUNT++;
+        }
+        SLOTS[index].state = SlotBorrowed;
+        SLOTS[index].since_ns = RM_metrics_clock();
+        out_indexes[n] = index;
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Hand the available slots (idle or free) to the waiters, oldest first. The slots are reserved for the
+ * waiters.
+ * @note The lock must be held.
+ */
+
+static void
+serve_waiters() {
+    size_t index;
+    while ((NULL != QUEUE.head) && (RM_success == reserve(&index, 1))) {
+        RM_wait_queue_serve(&QUEUE, (void *)(uintptr_t)(index + 1));
+    }
+}
+
+/**
+ * @brief Open connections until the pool holds `prewarm size` connections, and at least `min size` (warm-up).
+ * @return On success: RM_success. Otherwise (a connection cannot be opened): RM_failure.
+ * @note The lock must not be held. A slot being opened is reserved (borrowed, without a connection).
+ * @note This function is registered with the reaper (see `RM_reaper_prewarm()`).
+ */
+
+static RM_Status
+prewarm() {
+    for (;;) {
+        size_t warm;
+        size_t index = 0;
+        void *connection;
+
+        pthread_mutex_lock(&LOCK);
+        warm = PREWARM_SIZE > MIN_SIZE ? PREWARM_SIZE : MIN_SIZE;
+        if (warm > MAX_SIZE) warm = MAX_SIZE;
+        if (OPEN_COUNT >= warm) {
+            pthread_mutex_unlock(&LOCK);
+            return RM_success;
+        }
+        while (SlotFree != SLOTS[index].state) index++; // OPEN_COUNT < MAX_SIZE: there is a free slot
+        SLOTS[index].state = SlotBorrowed;
+        OPEN_COUNT++;
+        pthread_mutex_unlock(&LOCK);
+
+        connection = FACTORY.connect(FACTORY.context);
+
+        pthread_mutex_lock(&LOCK);
+        SLOTS[index].connection   = connection;
+        SLOTS[index].state        = NULL == connection ? SlotFree : SlotIdle;
+        SLOTS[index].last_used_ms = now_ms();
+        if (NULL == connection) OPEN_COUNT--;
+        serve_waiters(); // a borrower may have waited for the reserved slot
+        pthread_mutex_unlock(&LOCK);
+        if (NULL == connection) return RM_failure;
+    }
+}
+
+/**
+ * @brief Initialize the pool, and open the first connections (see `RM_conn_handler_set_policy()`).
+ * @param in_object_size Not used.
+ * @param in_capacity The maximum number of open connections.
+ * @return On success: RM_success. Otherwise (a connection cannot be opened): RM_failure.
+ * If the pool is not configured, then the function succeeds, but borrowing a connection fails.
+ * @note Please note that this function may be called multiple times. The connections opened by the previous
+ * calls are closed.
+ */
+
+RM_Status
+RM_conn_handler_init(
+        const size_t in_object_size,
+        const size_t in_capacity) {
+    (void) in_object_size;
+    RM_conn_handler_terminate();
+    pthread_mutex_lock(&LOCK);
+    if ((0 == in_capacity) || (! CONFIGURED)) {
+        pthread_mutex_unlock(&LOCK);
+        return RM_success; // borrowing will fail
+    }
+    SLOTS = (struct Slot *) calloc(in_capacity, sizeof(struct Slot));
+    if (NULL == SLOTS) {
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    MAX_SIZE = in_capacity;
+    pthread_mutex_unlock(&LOCK);
+    RM_metrics_capacity(RM_METRICS_CONN, in_capacity);
+    RM_reaper_register(reap_all, prewarm);
+
+    if (RM_failure == prewarm()) {
+        RM_conn_handler_terminate();
+        return RM_failure;
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Make sure that a reserved slot holds a usable connection: check the idle connection, and replace it if
+ * it is not usable anymore (or if a new connection is required).
+ * @param in_index The index of the reserved slot.
+ * @param in_init Flag that tells whether a new connection must be opened.
+ * @return The connection, or NULL if the connection failed (the slot is freed).
+ * @note The lock must not be held.
+ */
+
+static void *
+connect_slot(
+        const size_t in_index,
+        const RM_Bool in_init) {
+    void *connection;
+
+    pthread_mutex_lock(&LOCK);
+    connection = SLOTS[in_index].connection;
+    pthread_mutex_unlock(&LOCK);
+
+    if ((NULL != connection) && (in_init || (RM_false == FACTORY.check(connection)))) {
+        FACTORY.disconnect(connection);
+        connection = NULL;
+    }
+    if (NULL == connection) connection = FACTORY.connect(FACTORY.context);
+
+    pthread_mutex_lock(&LOCK);
+    SLOTS[in_index].connection = connection;
+    if (NULL == connection) {
+        SLOTS[in_index].state = SlotFree;
+        OPEN_COUNT--;
+        serve_waiters(); // a waiter may succeed where this borrower failed
+    }
+    pthread_mutex_unlock(&LOCK);
+    return connection;
+}
+
+/**
+ * @brief Make borrowed connections idle. Either all the connections are given back, or none.
+ * @param in_connections An array of `in_count` connections. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @return If all the connections are borrowed from the pool (and appear once): RM_success. Otherwise: RM_failure.
+ */
+
+static RM_Status
+release(
+        void **in_connections,
+        const size_t in_count) {
+    const int64_t now = now_ms();
+    size_t n;
+
+    pthread_mutex_lock(&LOCK);
+    for (n = 0; n < in_count; n++) {
+        size_t i;
+        if (NULL == in_connections[n]) continue;
+        for (i = 0; i < MAX_SIZE; i++) {
+            if ((SlotBorrowed == SLOTS[i].state) && (in_connections[n] == SLOTS[i].connection)) break;
+        }
+        if (i == MAX_SIZE) break;
+        SLOTS[i].state = SlotIdle;
+        SLOTS[i].last_used_ms = now;
+    }
+    if (n < in_count) {
+        // Undo: the connections given back so far are borrowed again.
+        for (size_t i = 0; i < MAX_SIZE; i++) {
+            for (size_t k = 0; k < n; k++) {
+                if ((NULL != in_connections[k]) && (SlotIdle == SLOTS[i].state)
+                    && (in_connections[k] == SLOTS[i].connection)) {
+                    SLOTS[i].state = SlotBorrowed;
+                }
+            }
+        }
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    for (size_t i = 0; i < MAX_SIZE; i++) {
+        if (0 == SLOTS[i].since_ns) continue;
+        for (size_t k = 0; k < in_count; k++) {
+            if ((SlotIdle == SLOTS[i].state) && (in_connections[k] == SLOTS[i].connection)) {
+                RM_metrics_hold(RM_METRICS_CONN, SLOTS[i].since_ns);
+                SLOTS[i].since_ns = 0;
+            }
+        }
+    }
+    serve_waiters();
+    pthread_mutex_unlock(&LOCK);
+    return RM_success;
+}
+
+/**
+ * @brief Borrow a connection.
+ * @param in_ptr The address of a pointer that will be assigned to the connection (as returned by the factory).
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @param in_init Flag that tells whether a new connection must be opened (instead of reusing an idle one).
+ * @return On success: RM_success. Otherwise (all the connections are borrowed, the connection failed, or a
+ * failure is simulated): RM_failure.
+ * @note This function never waits ("try borrow"). See `RM_conn_handler_borrow_timed()`.
+ */
+
+RM_Status
+RM_conn_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    return RM_conn_borrow_at(in_ptr, 0, in_init, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Borrow a connection. If all the connections are borrowed, wait until a connection is given back.
+ * @param in_ptr The address of a pointer that will be assigned to the connection (as returned by the factory).
+ * @param in_timeout_ms The maximum waiting time, in milliseconds. The value 0 means "do not wait", and the value
+ * `RM_WAIT_FOREVER` means "wait as long as necessary".
+ * @param in_init Flag that tells whether a new connection must be opened (instead of reusing an idle one).
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (the timeout expired, the connection failed, or a failure is
+ * simulated): RM_failure.
+ * @note The waiting threads are served in the order of arrival.
+ * @note This function is not variadic: it is the entry point of the typed macros (see `RM_conn_borrow()`).
+ */
+
+RM_Status
+RM_conn_borrow_at(
+        void **in_ptr,
+        long in_timeout_ms,
+        RM_Bool in_init,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    size_t index;
+    RM_Status status;
+    uint64_t wait_ns = 0;
+
+    *in_ptr = NULL;
+    if (RM_true == RM_fault_check("conn", in_uid)) return RM_failure;
+
+    pthread_mutex_lock(&LOCK);
+    // The waiters are served first: a newcomer does not take a slot while threads are waiting.
+    status = NULL == QUEUE.head ? reserve(&index, 1) : RM_failure;
+    if ((RM_failure == status) && (0 != in_timeout_ms) && (MAX_SIZE > 0)) {
+        RM_Waiter waiter;
+        RM_wait_queue_enqueue(&QUEUE, &waiter);
+        status = RM_wait_queue_wait(&QUEUE, &waiter, &LOCK, in_timeout_ms);
+        if (RM_success == status) index = (size_t)(uintptr_t) waiter.item - 1;
+        wait_ns = waiter.waited_ns;
+    }
+    pthread_mutex_unlock(&LOCK);
+    if (RM_failure == status) {
+        if (0 != wait_ns) RM_metrics_borrow(RM_METRICS_CONN, 0, wait_ns); // timeout
+        return RM_failure;
+    }
+
+    *in_ptr = connect_slot(index, in_init);
+    if (NULL == *in_ptr) return RM_failure;
+    RM_metrics_borrow(RM_METRICS_CONN, 1, wait_ns);
+    record_borrow(in_ptr, "conn", in_uid, in_file, in_line, in_function);
+    return RM_success;
+}
+
+/**
+ * @brief Borrow a connection. If none is available, wait until a connection is given back (see `RM_conn_borrow_at()`).
+ */
+
+RM_Status
+RM_conn_handler_borrow_timed(
+        void **in_ptr,
+        long in_timeout_ms,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    return RM_conn_borrow_at(in_ptr, in_timeout_ms, in_init, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Give back a connection. The connection is not closed: it waits for the next borrower.
+ * @param in_ptr The address of a pointer that is assigned to the connection. The pointer is set to NULL.
+ * @param in_uid Unique ID of the call.
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (the connection was not borrowed from the pool): RM_failure.
+ * @note Please note that you can call this function multiple times.
+ */
+
+RM_Status
+RM_conn_give_back_at(
+        void **in_ptr,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    if (NULL == *in_ptr) return RM_success;
+    if (RM_failure == release(in_ptr, 1)) {
+        record_give_back_failure(in_ptr, 1, "conn", in_uid, in_file, in_line, in_function);
+        return RM_failure;
+    }
+
+    RM_metrics_give_back(RM_METRICS_CONN, 1);
+    record_give_back(in_ptr, "conn", in_uid, in_file, in_line, in_function);
+    *in_ptr = NULL;
+    reap_one();
+    return RM_success;
+}
+
+/**
+ * @brief Give back a connection (see `RM_conn_give_back_at()`).
+ */
+
+RM_Status
+RM_conn_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    return RM_conn_give_back_at(in_ptr, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Borrow several connections. The slots are reserved under a single lock.
+ * @param in_ptrs An array of `in_count` pointers that will be assigned to the connections.
+ * @param in_count The number of connections to borrow.
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @param in_init Flag that tells whether new connections must be opened (instead of reusing idle ones).
+ * @return On success: RM_success. Otherwise (less than `in_count` connections are available, a connection
+ * failed, or a failure is simulated), no connection is borrowed: RM_failure.
+ */
+
+RM_Status
+RM_conn_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    size_t *indexes;
+    RM_Status status;
+    size_t n;
+
+    for (n = 0; n < in_count; n++) {
+        in_ptrs[n] = NULL;
+    }
+    if (RM_true == RM_fault_check("conn", in_uid)) return RM_failure;
+    if (0 == in_count) return RM_success;
+    indexes = (size_t *) malloc(in_count * sizeof(size_t));
+    if (NULL == indexes) return RM_failure;
+
+    pthread_mutex_lock(&LOCK);
+    // A batch does not wait, and does not take the slots from the waiters.
+    status = NULL == QUEUE.head ? reserve(indexes, in_count) : RM_failure;
+    pthread_mutex_unlock(&LOCK);
+    if (RM_failure == status) {
+        free(indexes);
+        return RM_failure;
+    }
+
+    for (n = 0; n < in_count; n++) {
+        in_ptrs[n] = connect_slot(indexes[n], in_init);
+        if (NULL == in_ptrs[n]) break;
+    }
+    if (n < in_count) {
+        // The failed slot is already free. The slots not yet connected are released, the others are given back.
+        pthread_mutex_lock(&LOCK);
+        for (size_t k = 0; k < n; k++) {
+            SLOTS[indexes[k]].since_ns = 0; // not a real borrow: no holding time
+        }
+        for (size_t k = n + 1; k < in_count; k++) {
+            struct Slot *slot = &SLOTS[indexes[k]];
+            if (NULL != slot->connection) {
+                slot->state = SlotIdle;
+            } else {
+                slot->state = SlotFree;
+                OPEN_COUNT--;
+            }
+        }
+        serve_waiters();
+        pthread_mutex_unlock(&LOCK);
+        release(in_ptrs, n);
+        for (size_t k = 0; k < in_count; k++) {
+            in_ptrs[k] = NULL;
+        }
+        free(indexes);
+        return RM_failure;
+    }
+    free(indexes);
+    RM_metrics_borrow(RM_METRICS_CONN, in_count, 0);
+    record_borrow_many(in_ptrs, in_count, "conn", in_uid, in_file, in_line, in_function);
+    return RM_success;
+}
+
+/**
+ * @brief Give back several connections, under a single lock.
+ * @param in_ptrs An array of `in_count` pointers that are assigned to the connections. The pointers are set to
+ * NULL. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @param in_uid Unique ID of the call.
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (a connection was not borrowed from the pool), no connection is
+ * given back: RM_failure.
+ */
+
+RM_Status
+RM_conn_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    size_t count = 0;
+
+    if (RM_failure == release(in_ptrs, in_count)) {
+        record_give_back_failure(in_ptrs, in_count, "conn", in_uid, in_file, in_line, in_function);
+        return RM_failure;
+    }
+
+    for (size_t i = 0; i < in_count; i++) {
+        if (NULL != in_ptrs[i]) count++;
+    }
+    RM_metrics_give_back(RM_METRICS_CONN, count);
+    record_give_back_many(in_ptrs, in_count, "conn", in_uid, in_file, in_line, in_function);
+    for (size_t i = 0; i < in_count; i++) {
+        in_ptrs[i] = NULL;
+    }
+    reap_one();
+    return RM_success;
+}
+
+/**
+ * @brief Close all the connections.
+ * @note The threads that wait for a connection are woken up: their calls to `borrow()` fail.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_conn_handler_terminate() {
+    struct Slot *slots;
+    size_t max_size;
+
+    RM_reaper_unregister(reap_all);
+    pthread_mutex_lock(&LOCK);
+    RM_wait_queue_cancel_all(&QUEUE);
+    slots      = SLOTS;
+    max_size   = MAX_SIZE;
+    SLOTS      = NULL;
+    MAX_SIZE   = 0;
+    OPEN_COUNT = 0;
+    pthread_mutex_unlock(&LOCK);
+    RM_metrics_capacity(RM_METRICS_CONN, 0);
+
+    for (size_t i = 0; i < max_size; i++) {
+        if (NULL != slots[i].connection) FACTORY.disconnect(slots[i].connection);
+    }
+    free(slots);
+}
+
+/**
+ * @brief Return the number of open connections (borrowed or idle).
+ * @return The number of open connections.
+ */
+
+unsigned long
+RM_conn_handler_open_count() {
+    unsigned long count;
+    pthread_mutex_lock(&LOCK);
+    count = OPEN_COUNT;
+    pthread_mutex_unlock(&LOCK);
+    return count;
+}
+
+/**
+ * @brief Return the statistics of the wait queue (see `RM_conn_handler_borrow_timed()`).
+ * @param out_stats The statistics.
+ */
+
+void
+RM_conn_handler_wait_stats(RM_WaitStats *out_stats) {
+    pthread_mutex_lock(&LOCK);
+    *out_stats = QUEUE.stats;
+    pthread_mutex_unlock(&LOCK);
+}
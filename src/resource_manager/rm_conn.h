@@ -0,0 +1,157 @@
+#ifndef C_PATTERNS_RM_CONN_H
+#define C_PATTERNS_RM_CONN_H
+
+#include "resource_manager.h"
+#include "rm_reaper.h"
+#include "rm_wait.h"
+
+// Connection pool handler: the resources are connections (to a database, a server...), created by a factory.
+//
+//      RM_conn_handler_configure(&factory, 2, 60000); // keep at least 2 connections, close the others after 60s
+//      RM_conn_handler_init(0, 8);                    // at most 8 connections, 2 are opened now (warm-up)
+//      if (RM_failure == RM_conn_handler_borrow(&connection, 1, __FILE__, __LINE__, (char*)__func__, RM_false)) { ... }
+//      ...
+//      RM_conn_handler_give_back(&connection, 2, __FILE__, __LINE__, (char*)__func__);
+//
+// The pool is elastic (see "rm_reaper.h"): it opens connections on demand, up to its capacity.
+//
+//      RM_PoolPolicy policy = { 2, 4, 60000 }; // keep 2 connections, open 4 now, close the others after 60s
+//      RM_conn_handler_set_policy(&policy);
+//
+// `RM_conn_handler_borrow()` fails immediately if all the connections are borrowed. `RM_conn_handler_borrow_timed()`
+// waits for a connection (in a FIFO queue):
+//
+//      RM_conn_handler_borrow_timed(&connection, RM_WAIT_FOREVER, 3, __FILE__, __LINE__, (char*)__func__, RM_false);
+//
+// The typed macros call the handler without varargs, and capture the location of the call (see `RM_HERE`):
+//
+//      if (RM_failure == RM_conn_borrow_timed(&connection, 100, 4, RM_false)) { ... }
+//      RM_conn_give_back(&connection, 5);
+
+/**
+ * The functions that create, check and destroy the connections.
+ */
+
+struct RM_StructConnectionFactory {
+    /**
+     * @brief Open a connection.
+     * @param in_context The value of the field `context`.
+     * @return On success: the connection. Otherwise: NULL.
+     */
+    void *(*connect)(void *in_context);
+    /**
+     * @brief Check that a connection is still usable (called before an idle connection is borrowed).
+     * @param in_connection The connection.
+     * @return If the connection is usable: RM_true. Otherwise: RM_false.
+     */
+    RM_Bool (*check)(void *in_connection);
+    /**
+     * @brief Close a connection.
+     * @param in_connection The connection.
+     */
+    void (*disconnect)(void *in_connection);
+    void *context;
+};
+
+typedef struct RM_StructConnectionFactory RM_ConnectionFactory;
+
+void
+RM_conn_handler_configure(
+        const RM_ConnectionFactory *in_factory,
+        size_t in_min_size,
+        unsigned long in_idle_timeout_ms);
+
+void
+RM_conn_handler_set_policy(
+        const RM_PoolPolicy *in_policy);
+
+RM_Status
+RM_conn_handler_init(
+        size_t in_object_size,
+        size_t in_capacity);
+
+RM_Status
+RM_conn_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_conn_handler_borrow_timed(
+        void **in_ptr,
+        long in_timeout_ms,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_conn_borrow_at(
+        void **in_ptr,
+        long in_timeout_ms,
+        RM_Bool in_init,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+#define RM_conn_borrow(ptr, uid, init) RM_conn_borrow_at((ptr), 0, (init), (uid), RM_HERE)
+#define RM_conn_borrow_timed(ptr, timeout_ms, uid, init) RM_conn_borrow_at((ptr), (timeout_ms), (init), (uid), RM_HERE)
+
+RM_Status
+RM_conn_give_back_at(
+        void **in_ptr,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+#define RM_conn_give_back(ptr, uid) RM_conn_give_back_at((ptr), (uid), RM_HERE)
+
+RM_Status
+RM_conn_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+RM_Status
+RM_conn_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_conn_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+void
+RM_conn_handler_terminate();
+
+unsigned long
+RM_conn_handler_open_count();
+
+void
+RM_conn_handler_wait_stats(
+        RM_WaitStats *out_stats);
+
+#endif //C_PATTERNS_RM_CONN_H
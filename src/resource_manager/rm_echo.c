@@ -0,0 +1,189 @@
+/**
+ * A local "echo" server, used as a stand-in for a real server (a database...) when testing the connection pool.
+ *
+ * The server is a thread that waits (using `poll()`) for new connections and for data on the open connections,
+ * and sends the data back. Stopping the server closes all the connections: the clients see them as closed.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "rm_echo.h"
+
+// Maximum number of connections handled by the server at the same time.
+#define ECHO_MAX_CONNECTIONS 256
+#define ECHO_BUFFER_CAPACITY 4096
+
+static pthread_t SERVER_THREAD;
+static int       SERVER_RUNNING = 0;
+static int       LISTEN_FD      = -1;
+static int       WAKE_UP[2]     = { -1, -1 }; // writing into WAKE_UP[1] stops the server
+
+static void *
+serve(void *in_unused) {
+    struct pollfd fds[ECHO_MAX_CONNECTIONS + 2];
+    nfds_t count = 2;
+    char buffer[ECHO_BUFFER_CAPACITY];
+
+    (void) in_unused;
+    fds[0].fd = WAKE_UP[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = LISTEN_FD;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, count, -1) < 0) {
+            if (EINTR == errno) continue;
+            break;
+        }
+        if (0 != fds[0].revents) break; // stop
+        if ((0 != (fds[1].revents & POLLIN)) && (count < ECHO_MAX_CONNECTIONS + 2)) {
+            int fd = accept(LISTEN_FD, NULL, NULL);
+            if (fd >= 0) {
+                fds[count].fd = fd;
+                fds[count].events = POLLIN;
+                fds[count].revents = 0;
+                count++;
+            }
+        }
+        for (nfds_t i = 2; i < count; i++) {
+            ssize_t length;
+
+            if (0 == fds[i].revents) continue;
+            length = read(fds[i].fd, buffer, ECHO_BUFFER_CAPACITY);
+            if ((length > 0) && (length == send(fds[i].fd, buffer, (size_t)length, MSG_NOSIGNAL))) continue;
+            // The client closed the connection (or an error occurred).
+            close(fds[i].fd);
+            fds[i--] = fds[--count];
+        }
+    }
+
+    for (nfds_t i = 2; i < count; i++) {
+        close(fds[i].fd);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start the echo server.
+ * @param in_path Path to the Unix socket. If a file exists at this path, it is removed.
+ * @return On success: RM_success. Otherwise: RM_failure.
+ */
+
+RM_Status
+RM_echo_server_start(const char *in_path) {
+    struct sockaddr_un address;
+
+    if (SERVER_RUNNING || (strlen(in_path) >= sizeof(address.sun_path))) return RM_failure;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, in_path);
+    unlink(in_path);
+
+    LISTEN_FD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (LISTEN_FD < 0) return RM_failure;
+    if ((0 != bind(LISTEN_FD, (struct sockaddr *) &address, sizeof(address)))
+        || (0 != listen(LISTEN_FD, ECHO_MAX_CONNECTIONS))
+        || (0 != pipe(WAKE_UP))) {
+        close(LISTEN_FD);
+        LISTEN_FD = -1;
+        return RM_failure;
+    }
+    if (0 != pthread_create(&SERVER_THREAD, NULL, serve, NULL)) {
+        close(LISTEN_FD);
+        close(WAKE_UP[0]);
+        close(WAKE_UP[1]);
+        LISTEN_FD = -1;
+        return RM_failure;
+    }
+    SERVER_RUNNING = 1;
+    return RM_success;
+}
+
+/**
+ * @brief Stop the echo server, and close all the connections.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_echo_server_stop() {
+    if (! SERVER_RUNNING) return;
+    if (1 != write(WAKE_UP[1], "x", 1)) {} // the server cannot miss it: the pipe is empty
+    pthread_join(SERVER_THREAD, NULL);
+    close(LISTEN_FD);
+    close(WAKE_UP[0]);
+    close(WAKE_UP[1]);
+    LISTEN_FD = -1;
+    SERVER_RUNNING = 0;
+}
+
+static void *
+echo_connect(void *in_path) {
+    struct sockaddr_un address;
+    RM_EchoConnection *connection = (RM_EchoConnection *) malloc(sizeof(RM_EchoConnection));
+
+    if (NULL == connection) return NULL;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, (const char *) in_path, sizeof(address.sun_path) - 1);
+    connection->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if ((connection->fd < 0) || (0 != connect(connection->fd, (struct sockaddr *) &address, sizeof(address)))) {
+        if (connection->fd >= 0) close(connection->fd);
+        free(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+/**
+ * @brief Check that the server has not closed the connection, without waiting.
+ */
+
+static RM_Bool
+echo_check(void *in_connection) {
+    char c;
+    ssize_t length = recv(((RM_EchoConnection *) in_connection)->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    // 0: the connection is closed. -1 and EAGAIN: there is nothing to read (the connection is open).
+    return (length < 0) && ((EAGAIN == errno) || (EWOULDBLOCK == errno)) ? RM_true : RM_false;
+}
+
+static void
+echo_disconnect(void *in_connection) {
+    close(((RM_EchoConnection *) in_connection)->fd);
+    free(in_connection);
+}
+
+/**
+ * @brief Return a connection factory for the echo server.
+ * @param in_path Path to the Unix socket. The string must not be freed while the factory is used.
+ * @return The factory (the connections are `RM_EchoConnection *`).
+ */
+
+RM_ConnectionFactory
+RM_echo_factory(const char *in_path) {
+    RM_ConnectionFactory factory;
+    factory.connect    = echo_connect;
+    factory.check      = echo_check;
+    factory.disconnect = echo_disconnect;
+    factory.context    = (void *) in_path;
+    return factory;
+}
+
+/**
+ * @brief Send a byte to the echo server, and wait for it to come back.
+ * @param in_connection The connection.
+ * @return On success: RM_success. Otherwise: RM_failure.
+ */
+
+RM_Status
+RM_echo_ping(const RM_EchoConnection *in_connection) {
+    char c = 'p';
+    if (1 != send(in_connection->fd, &c, 1, MSG_NOSIGNAL)) return RM_failure;
+    if (1 != read(in_connection->fd, &c, 1)) return RM_failure;
+    return 'p' == c ? RM_success : RM_failure;
+}
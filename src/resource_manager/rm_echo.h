@@ -0,0 +1,37 @@
+#ifndef C_PATTERNS_RM_ECHO_H
+#define C_PATTERNS_RM_ECHO_H
+
+#include "resource_manager.h"
+#include "rm_conn.h"
+
+// A local stand-in server (it sends back everything it receives, over a Unix socket), and the connection factory
+// that connects to it. They are used to test the connection pool (see "rm_conn.h") without a real server.
+//
+//      RM_echo_server_start("/tmp/echo.sock");
+//      RM_ConnectionFactory factory = RM_echo_factory("/tmp/echo.sock");
+//      RM_conn_handler_configure(&factory, 2, 60000);
+//      ...
+//      RM_echo_server_stop();
+
+struct RM_StructEchoConnection {
+    int fd;
+};
+
+typedef struct RM_StructEchoConnection RM_EchoConnection;
+
+RM_Status
+RM_echo_server_start(
+        const char *in_path);
+
+void
+RM_echo_server_stop();
+
+RM_ConnectionFactory
+RM_echo_factory(
+        const char *in_path);
+
+RM_Status
+RM_echo_ping(
+        const RM_EchoConnection *in_connection);
+
+#endif //C_PATTERNS_RM_ECHO_H
@@ -0,0 +1,555 @@
+/**
+ * Fault injection for the resource handlers.
+ *
+ * The rules are stored in an immutable table. A writer (add, remove, clear) builds a new table, publishes it with
+ * a single atomic exchange, and releases the previous table after a grace period. The writers are serialized by
+ * WRITER_LOCK.
+ *
+ * Grace period: each reading thread has its own slot (allocated on first use), where it writes the value of
+ * EPOCH before it loads the table, and 0 when it is done. After the exchange, the writer increments EPOCH, and
+ * waits for the readers which slots hold an older epoch: they may use the previous table. The readers that
+ * started later use the new table, and are not waited for (a stream of readers cannot starve a writer). A reader
+ * only writes its own slot: checking the rules does not write any shared cache line.
+ *
+ * Index: for each type named by a rule (plus one entry for the other types), the table holds a small hash table
+ * by uid. Each entry lists, in the order they were added, all the rules that apply to the (type, uid) pair,
+ * including the rules for all the types and for all the calls. Checking a call is one search among the few
+ * types, and one probe.
+ *
+ * The counters of the rules (number of calls) are shared by the successive tables: adding a rule does not reset
+ * the counters of the other rules.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "rm_fault.h"
+
+struct Rule {
+    long         id;
+    RM_FaultRule rule; // `rule.type` points to a copy owned by the rule
+    uint64_t     calls;
+};
+
+struct UidEntry {
+    long        uid;   // RM_FAULT_ANY_UID: empty slot
+    size_t      count;
+    struct Rule **rules;
+};
+
+struct TypeIndex {
+    const char      *type;     // NULL: the types that no rule names
+    size_t          mask;      // number of slots in `uids`, minus 1
+    struct UidEntry *uids;     // NULL: no rule for a specific call
+    size_t          any_count;
+    struct Rule     **any_rules; // the rules for all the calls
+};
+
+struct Table {
+    size_t           count;
+    struct Rule      **rules;
+    size_t           types_count;
+    struct TypeIndex *types; // the last index is the one for the types that no rule names
+};
+
+struct Reader {
+    uint64_t      epoch; // 0: the thread does not read the table
+    struct Reader *next;
+};
+
+static struct Table    *TABLE       = NULL; // NULL: no rule
+static uint64_t        EPOCH        = 1;
+static struct Reader   *READERS     = NULL;
+static long            NEXT_ID      = 1;
+static pthread_mutex_t WRITER_LOCK  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t READERS_LOCK = PTHREAD_MUTEX_INITIALIZER; // READERS
+static pthread_key_t   KEY;
+static pthread_once_t  ONCE         = PTHREAD_ONCE_INIT;
+static __thread uint64_t RANDOM     = 0;
+static __thread struct Reader *THREAD_READER = NULL;
+
+/**
+ * @brief Return a pseudo random number (xorshift64*, one generator per thread).
+ */
+
+static uint64_t
+next_random() {
+    if (0 == RANDOM) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        RANDOM = ((uint64_t) ts.tv_nsec << 20) ^ (uint64_t)(uintptr_t) &RANDOM ^ 1;
+    }
+    RANDOM ^= RANDOM >> 12;
+    RANDOM ^= RANDOM << 25;
+    RANDOM ^= RANDOM >> 27;
+    return RANDOM * 0x2545F4914F6CDD1DULL;
+}
+
+static void
+thread_exit(void *in_reader) {
+    struct Reader *reader = (struct Reader *) in_reader;
+    struct Reader **link;
+
+    pthread_mutex_lock(&READERS_LOCK);
+    for (link = &READERS; reader != *link; link = &(*link)->next) {}
+    *link = reader->next;
+    pthread_mutex_unlock(&READERS_LOCK);
+    free(reader);
+    THREAD_READER = NULL;
+}
+
+static void
+setup() {
+    pthread_key_create(&KEY, thread_exit);
+}
+
+/**
+ * @brief Return the slot of the calling thread (it is allocated on first use).
+ * @return The slot, or NULL if it cannot be allocated.
+ */
+
+static inline struct Reader *
+this_reader() {
+    struct Reader *reader = THREAD_READER;
+
+    if (NULL != reader) return reader;
+    reader = (struct Reader *) calloc(1, sizeof(struct Reader));
+    if (NULL == reader) return NULL;
+    pthread_once(&ONCE, setup);
+    pthread_setspecific(KEY, reader);
+    pthread_mutex_lock(&READERS_LOCK);
+    reader->next = READERS;
+    READERS = reader;
+    pthread_mutex_unlock(&READERS_LOCK);
+    THREAD_READER = reader;
+    return reader;
+}
+
+static void
+free_rule(struct Rule *in_rule) {
+    free((char *) in_rule->rule.type);
+    free(in_rule);
+}
+
+/**
+ * @brief Release a table (but not its rules).
+ * @param in_table The table (may be NULL, or partially indexed).
+ */
+
+static void
+free_table(struct Table *in_table) {
+    if (NULL == in_table) return;
+    for (size_t i = 0; (NULL != in_table->types) && (i < in_table->types_count); i++) {
+        struct TypeIndex *index = &in_table->types[i];
+        for (size_t j = 0; (NULL != index->uids) && (j <= index->mask); j++) {
+            free(index->uids[j].rules);
+        }
+        free(index->uids);
+        free(index->any_rules);
+    }
+    free(in_table->types);
+    free(in_table->rules);
+    free(in_table);
+}
+
+/**
+ * @brief Replace the table of rules.
+ * @param in_table The new table (NULL: no rule).
+ * @return The previous table. No reader uses it anymore: it can be released.
+ * @note The lock WRITER_LOCK must be held.
+ */
+
+static struct Table *
+publish(struct Table *in_table) {
+    struct Table *previous = __atomic_exchange_n(&TABLE, in_table, __ATOMIC_SEQ_CST);
+    const uint64_t epoch = __atomic_add_fetch(&EPOCH, 1, __ATOMIC_SEQ_CST);
+    uint64_t reading;
+
+    // Only the readers that loaded the table before the exchange are waited for.
+    pthread_mutex_lock(&READERS_LOCK);
+    for (const struct Reader *reader = READERS; NULL != reader; reader = reader->next) {
+        while ((0 != (reading = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST))) && (reading < epoch)) {
+            sched_yield();
+        }
+    }
+    pthread_mutex_unlock(&READERS_LOCK);
+    return previous;
+}
+
+/**
+ * @brief Allocate a table (not indexed yet).
+ * @param in_count The number of rules.
+ * @return The table, or NULL (if the allocation failed).
+ */
+
+static struct Table *
+new_table(const size_t in_count) {
+    struct Table *table = (struct Table *) calloc(1, sizeof(struct Table));
+    if (NULL == table) return NULL;
+    table->count = in_count;
+    table->rules = (struct Rule **) malloc(in_count * sizeof(struct Rule *));
+    if (NULL == table->rules) {
+        free(table);
+        return NULL;
+    }
+    return table;
+}
+
+/**
+ * @brief Test whether a rule applies to a call.
+ * @param in_rule The rule.
+ * @param in_type The type of the call (NULL: a type that no rule names).
+ * @param in_uid The uid of the call (RM_FAULT_ANY_UID: only the rules for all the calls apply).
+ * @return If the rule applies: 1. Otherwise: 0.
+ */
+
+static int
+rule_applies(
+        const struct Rule *in_rule,
+        const char *in_type,
+        const long in_uid) {
+    return ((NULL == in_rule->rule.type) || ((NULL != in_type) && (0 == strcmp(in_type, in_rule->rule.type))))
+            && ((RM_FAULT_ANY_UID == in_rule->rule.uid) || (in_uid == in_rule->rule.uid));
+}
+
+/**
+ * @brief Select, in the order they were added, the rules of a table that apply to a call.
+ * @param in_table The table.
+ * @param in_type The type of the call (see `rule_applies()`).
+ * @param in_uid The uid of the call (see `rule_applies()`).
+ * @param out_rules The selected rules (NULL if no rule applies). The caller must release the array.
+ * @param out_count The number of selected rules.
+ * @return On success: RM_success. Otherwise (allocation failure): RM_failure.
+ */
+
+static RM_Status
+select_rules(
+        const struct Table *in_table,
+        const char *in_type,
+        const long in_uid,
+        struct Rule ***out_rules,
+        size_t *out_count) {
+    size_t count = 0;
+
+    *out_rules = NULL;
+    for (size_t i = 0; i < in_table->count; i++) {
+        if (rule_applies(in_table->rules[i], in_type, in_uid)) count++;
+    }
+    *out_count = count;
+    if (0 == count) return RM_success;
+    *out_rules = (struct Rule **) malloc(count * sizeof(struct Rule *));
+    if (NULL == *out_rules) return RM_failure;
+    for (size_t i = 0, j = 0; i < in_table->count; i++) {
+        if (rule_applies(in_table->rules[i], in_type, in_uid)) (*out_rules)[j++] = in_table->rules[i];
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Find the slot of a uid (open addressing, linear probing).
+ * @param in_index The index (`in_index->uids` must not be NULL).
+ * @param in_uid The uid (positive or 0).
+ * @return The slot of the uid, or the empty slot where it would be.
+ */
+
+static inline struct UidEntry *
+find_uid(
+        const struct TypeIndex *in_index,
+        const long in_uid) {
+    size_t slot = (size_t)(((uint64_t) in_uid * 0x9E3779B97F4A7C15ULL) >> 32) & in_index->mask;
+
+    while ((RM_FAULT_ANY_UID != in_index->uids[slot].uid) && (in_uid != in_index->uids[slot].uid)) {
+        slot = (slot + 1) & in_index->mask;
+    }
+    return &in_index->uids[slot];
+}
+
+/**
+ * @brief Build the index of a type.
+ * @param in_table The table.
+ * @param out_index The index (zeroed).
+ * @param in_type The type (NULL: the types that no rule names).
+ * @return On success: RM_success. Otherwise (allocation failure): RM_failure. The index must be released anyway.
+ * @note The uids of the calls are positive or 0: the rules for negative uids (other than RM_FAULT_ANY_UID) never
+ * apply, and they are not indexed.
+ */
+
+static RM_Status
+index_type(
+        const struct Table *in_table,
+        struct TypeIndex *out_index,
+        const char *in_type) {
+    size_t uids_count = 0;
+    size_t slots = 2;
+
+    out_index->type = in_type;
+    if (RM_failure == select_rules(in_table, in_type, RM_FAULT_ANY_UID, &out_index->any_rules,
+                                   &out_index->any_count)) {
+        return RM_failure;
+    }
+    for (size_t i = 0; i < in_table->count; i++) {
+        const struct Rule *rule = in_table->rules[i];
+        size_t j = 0;
+        if ((rule->rule.uid < 0) || (! rule_applies(rule, in_type, rule->rule.uid))) continue;
+        while ((j < i) && ((rule->rule.uid != in_table->rules[j]->rule.uid)
+                           || (! rule_applies(in_table->rules[j], in_type, rule->rule.uid)))) {
+            j++;
+        }
+        if (j == i) uids_count++;
+    }
+    if (0 == uids_count) return RM_success;
+
+    while (slots < 2 * uids_count) slots <<= 1;
+    out_index->uids = (struct UidEntry *) calloc(slots, sizeof(struct UidEntry));
+    if (NULL == out_index->uids) return RM_failure;
+    out_index->mask = slots - 1;
+    for (size_t i = 0; i < slots; i++) {
+        out_index->uids[i].uid = RM_FAULT_ANY_UID;
+    }
+    for (size_t i = 0; i < in_table->count; i++) {
+        const struct Rule *rule = in_table->rules[i];
+        struct UidEntry *entry;
+        if ((rule->rule.uid < 0) || (! rule_applies(rule, in_type, rule->rule.uid))) continue;
+        entry = find_uid(out_index, rule->rule.uid);
+        if (RM_FAULT_ANY_UID != entry->uid) continue;
+        entry->uid = rule->rule.uid;
+        if (RM_failure == select_rules(in_table, in_type, entry->uid, &entry->rules, &entry->count)) {
+            return RM_failure;
+        }
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Build the index of a table, once its rules are set.
+ * @param in_table The table.
+ * @return On success: RM_success. Otherwise (allocation failure): RM_failure. The table must be released.
+ */
+
+static RM_Status
+index_table(struct Table *in_table) {
+    in_table->types = (struct TypeIndex *) calloc(in_table->count + 1, sizeof(struct TypeIndex));
+    if (NULL == in_table->types) return RM_failure;
+    for (size_t i = 0; i < in_table->count; i++) {
+        const char *type = in_table->rules[i]->rule.type;
+        size_t j = 0;
+        if (NULL == type) continue;
+        while ((j < in_table->types_count) && (0 != strcmp(type, in_table->types[j].type))) j++;
+        if (j < in_table->types_count) continue;
+        if (RM_failure == index_type(in_table, &in_table->types[in_table->types_count++], type)) return RM_failure;
+    }
+    return index_type(in_table, &in_table->types[in_table->types_count++], NULL);
+}
+
+/**
+ * @brief Add a rule.
+ * @param in_rule The rule. It is copied (including the type).
+ * @return On success: the ID of the rule (positive). Otherwise (invalid rule, or allocation failure): -1.
+ */
+
+long
+RM_fault_add(const RM_FaultRule *in_rule) {
+    struct Rule *rule;
+    struct Table *table;
+    struct Table *previous;
+    size_t count;
+
+    if ((NULL == in_rule)
+        || ((RM_FAULT_EVERY == in_rule->kind) && (in_rule->value <= 0))
+        || ((RM_FAULT_LATENCY == in_rule->kind) && (in_rule->value < 0))) {
+        return -1;
+    }
+    rule = (struct Rule *) malloc(sizeof(struct Rule));
+    if (NULL == rule) return -1;
+    rule->rule  = *in_rule;
+    rule->calls = 0;
+    if (NULL != in_rule->type) {
+        rule->rule.type = strdup(in_rule->type);
+        if (NULL == rule->rule.type) {
+            free(rule);
+            return -1;
+        }
+    }
+
+    pthread_mutex_lock(&WRITER_LOCK);
+    count = NULL == TABLE ? 0 : TABLE->count;
+    table = new_table(count + 1);
+    if (NULL != table) {
+        if (count > 0) memcpy(table->rules, TABLE->rules, count * sizeof(struct Rule *));
+        table->rules[count] = rule;
+        if (RM_failure == index_table(table)) {
+            free_table(table);
+            table = NULL;
+        }
+    }
+    if (NULL == table) {
+        pthread_mutex_unlock(&WRITER_LOCK);
+        free_rule(rule);
+        return -1;
+    }
+    rule->id = NEXT_ID++;
+    previous = publish(table);
+    pthread_mutex_unlock(&WRITER_LOCK);
+    free_table(previous);
+    return rule->id;
+}
+
+/**
+ * @brief Remove a rule.
+ * @param in_id The ID of the rule (see `RM_fault_add()`).
+ * @return If the rule was found: RM_success. Otherwise (or if the allocation of the new table failed): RM_failure.
+ */
+
+RM_Status
+RM_fault_remove(const long in_id) {
+    struct Rule *rule = NULL;
+    struct Table *table = NULL;
+    struct Table *previous;
+    size_t count;
+
+    pthread_mutex_lock(&WRITER_LOCK);
+    count = NULL == TABLE ? 0 : TABLE->count;
+    for (size_t i = 0; (NULL == rule) && (i < count); i++) {
+        if (in_id == TABLE->rules[i]->id) rule = TABLE->rules[i];
+    }
+    if ((NULL == rule) || ((count > 1) && (NULL == (table = new_table(count - 1))))) {
+        pthread_mutex_unlock(&WRITER_LOCK);
+        return RM_failure;
+    }
+    for (size_t i = 0, j = 0; (NULL != table) && (i < count); i++) {
+        if (rule != TABLE->rules[i]) table->rules[j++] = TABLE->rules[i];
+    }
+    if ((NULL != table) && (RM_failure == index_table(table))) {
+        pthread_mutex_unlock(&WRITER_LOCK);
+        free_table(table);
+        return RM_failure;
+    }
+    previous = publish(table);
+    pthread_mutex_unlock(&WRITER_LOCK);
+    free_table(previous);
+    free_rule(rule);
+    return RM_success;
+}
+
+/**
+ * @brief Remove all the rules.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_fault_clear() {
+    struct Table *previous;
+
+    pthread_mutex_lock(&WRITER_LOCK);
+    previous = publish(NULL);
+    pthread_mutex_unlock(&WRITER_LOCK);
+    for (size_t i = 0; (NULL != previous) && (i < previous->count); i++) {
+        free_rule(previous->rules[i]);
+    }
+    free_table(previous);
+}
+
+/**
+ * @brief Apply the rules of a table to a call.
+ * @param in_table The table (NULL: no rule).
+ * @param in_type The type of the call (see `RM_fault_check()`).
+ * @param in_uid The uid of the call (see `RM_fault_check()`).
+ * @param io_latency_us The latency of the call, in microseconds: the latency rules are added to it.
+ * @return If the call must fail: RM_true. Otherwise: RM_false.
+ */
+
+static RM_Bool
+apply_rules(
+        const struct Table *in_table,
+        const char *in_type,
+        const long in_uid,
+        long *io_latency_us) {
+    const struct TypeIndex *index;
+    struct Rule *const *rules;
+    size_t count;
+    size_t last;
+    RM_Bool fail = RM_false;
+
+    if (NULL == in_table) return RM_false;
+    last = in_table->types_count - 1;
+    index = &in_table->types[last];
+    for (size_t i = 0; (NULL != in_type) && (i < last); i++) {
+        if (0 == strcmp(in_type, in_table->types[i].type)) {
+            index = &in_table->types[i];
+            break;
+        }
+    }
+    rules = index->any_rules;
+    count = index->any_count;
+    if ((in_uid >= 0) && (NULL != index->uids)) {
+        const struct UidEntry *entry = find_uid(index, in_uid);
+        if (RM_FAULT_ANY_UID != entry->uid) {
+            rules = entry->rules;
+            count = entry->count;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        struct Rule *rule = rules[i];
+        switch (rule->rule.kind) {
+            case RM_FAULT_AFTER:
+                if ((int64_t) __atomic_fetch_add(&rule->calls, 1, __ATOMIC_RELAXED) >= rule->rule.value) {
+                    fail = RM_true;
+                }
+                break;
+            case RM_FAULT_EVERY:
+                if (0 == (__atomic_add_fetch(&rule->calls, 1, __ATOMIC_RELAXED) % (uint64_t) rule->rule.value)) {
+                    fail = RM_true;
+                }
+                break;
+            case RM_FAULT_PROBABILITY:
+                if ((rule->rule.value > 0) && (next_random() % 1000000 < (uint64_t) rule->rule.value)) fail = RM_true;
+                break;
+            case RM_FAULT_LATENCY:
+                *io_latency_us += rule->rule.value;
+                break;
+        }
+    }
+    return fail;
+}
+
+/**
+ * @brief Apply the rules to a call. All the rules that match the call are applied (their counters are updated).
+ * @param in_type The type of the resource ("mem", "file", "conn"...). If NULL, then only the rules that apply to
+ * all the types match.
+ * @param in_uid Unique ID of the call. A negative value matches only the rules for all the calls
+ * (RM_FAULT_ANY_UID).
+ * @return If the call must fail: RM_true. Otherwise: RM_false.
+ * @note This function is called by the resource handlers, before they borrow a resource. If a latency rule
+ * matches, then the calling thread sleeps.
+ */
+
+RM_Bool
+RM_fault_check(
+        const char *in_type,
+        const long in_uid) {
+    struct Reader *reader;
+    RM_Bool fail;
+    long latency_us = 0;
+
+    if (NULL == __atomic_load_n(&TABLE, __ATOMIC_ACQUIRE)) return RM_false;
+    reader = this_reader();
+    if (NULL == reader) {
+        // No slot: the writers cannot release the table while the lock is held.
+        pthread_mutex_lock(&WRITER_LOCK);
+        fail = apply_rules(TABLE, in_type, in_uid, &latency_us);
+        pthread_mutex_unlock(&WRITER_LOCK);
+    } else {
+        __atomic_store_n(&reader->epoch, __atomic_load_n(&EPOCH, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+        fail = apply_rules(__atomic_load_n(&TABLE, __ATOMIC_SEQ_CST), in_type, in_uid, &latency_us);
+        __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    }
+
+    if (latency_us > 0) {
+        struct timespec delay = { latency_us / 1000000, (latency_us % 1000000) * 1000 };
+        while (0 != nanosleep(&delay, &delay)) {}
+    }
+    return fail;
+}
@@ -0,0 +1,59 @@
+#ifndef C_PATTERNS_RM_FAULT_H
+#define C_PATTERNS_RM_FAULT_H
+
+#include <stdint.h>
+#include "resource_manager.h"
+
+// Fault injection: a table of rules, checked by the resource handlers before they borrow a resource.
+//
+//      RM_FaultRule every_third = { 12, "mem", RM_FAULT_EVERY, 3 };  // uid 12: 1 call out of 3 fails
+//      RM_FaultRule slow_files  = { RM_FAULT_ANY_UID, "file", RM_FAULT_LATENCY, 500 }; // +500 us per file borrow
+//      long id = RM_fault_add(&every_third);
+//      RM_fault_add(&slow_files);
+//      ...
+//      RM_fault_remove(id);
+//      RM_fault_clear();
+//
+// The rules can be added and removed while other threads borrow resources: the table is replaced as a whole
+// (copy on write), and a borrower reads a consistent table with a single atomic load. The table is indexed by
+// (type, uid): checking a call does not scan the rules. When the table is empty, checking the rules costs one
+// atomic load. `RM_init()` replaces all the rules by a single "after" rule.
+
+// Value of `RM_FaultRule.uid` that matches all the calls.
+#define RM_FAULT_ANY_UID (-1L)
+
+enum RM_EnumFaultKind {
+    RM_FAULT_AFTER,       // the calls fail after `value` successful calls
+    RM_FAULT_EVERY,       // one call out of `value` fails (the value-th, the 2*value-th...)
+    RM_FAULT_PROBABILITY, // a call fails with the probability `value` / 1000000
+    RM_FAULT_LATENCY      // a call is delayed by `value` microseconds (it does not fail)
+};
+
+typedef enum RM_EnumFaultKind RM_FaultKind;
+
+struct RM_StructFaultRule {
+    long         uid;   // the ID of the calls (see `borrow()`), or RM_FAULT_ANY_UID
+    const char   *type; // the type of the resources ("mem", "file", "conn"...), or NULL for all the types
+    RM_FaultKind kind;
+    long         value;
+};
+
+typedef struct RM_StructFaultRule RM_FaultRule;
+
+long
+RM_fault_add(
+        const RM_FaultRule *in_rule);
+
+RM_Status
+RM_fault_remove(
+        long in_id);
+
+void
+RM_fault_clear();
+
+RM_Bool
+RM_fault_check(
+        const char *in_type,
+        long in_uid);
+
+#endif //C_PATTERNS_RM_FAULT_H
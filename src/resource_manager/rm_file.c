@@ -0,0 +1,637 @@
+/**
+ * File resource handler: keep the file descriptors open, so that borrowing a file does not call `open()`.
+ *
+ * Each descriptor is stored in an entry, identified by the path and the flags given to `open()`.
+ * An entry is either:
+ * - free (no descriptor),
+ * - borrowed (the descriptor is used by one borrower: it cannot be borrowed twice at the same time),
+ * - idle (the descriptor is open, and waits for the next borrower of the same path and flags).
+ *
+ * The entries are found by a hash table (path, flags) => entries. The idle entries are also linked into a
+ * LRU list: when all the entries are used, the least recently given back descriptor is closed, and its entry
+ * is reused.
+ *
+ * The idle descriptors that have not been used for `idle timeout` milliseconds are closed, as long as more than
+ * `min size` descriptors are open (see `RM_file_handler_set_policy()`). The oldest idle descriptor is at the head
+ * of the LRU list, so finding an expired descriptor is O(1). This is done when descriptors are given back (one per
+ * call), and by the background reaper (see "rm_reaper.h").
+ *
+ * Please note: a cached descriptor keeps referring to the file it was opened on, even if the file is renamed
+ * or deleted. The flags `O_CREAT` and `O_TRUNC` only take effect when the descriptor is opened.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "resource_manager.h"
+#include "rm_fault.h"
+#include "rm_metrics.h"
+#include "rm_reaper.h"
+#include "rm_file.h"
+
+#define NO_ENTRY -1
+
+enum EntryState { EntryFree, EntryBorrowed, EntryIdle };
+
+struct Entry {
+    int             fd;          // must be the first field: the borrower gets a pointer to it
+    int             flags;
+    char            *path;
+    uint64_t        hash;
+    enum EntryState state;
+    int             next;        // next entry in the same bucket (or in the list of free entries)
+    int             lru_previous;
+    int             lru_next;
+    int64_t         since_ns;    // when the descriptor was borrowed (see `RM_metrics_clock()`)
+    int64_t         last_used_ms; // when the descriptor was given back (only if there is an idle timeout)
+};
+
+static struct Entry    *ENTRIES        = NULL;
+static int             *BUCKETS        = NULL;
+static size_t          CAPACITY        = 0;
+static size_t          BUCKETS_COUNT   = 0; // a power of 2
+static int             FREE_ENTRIES    = NO_ENTRY;
+static int             LRU_OLDEST      = NO_ENTRY;
+static int             LRU_NEWEST      = NO_ENTRY;
+static unsigned long   OPEN_COUNT      = 0;
+static size_t          MIN_SIZE        = 0;
+static unsigned long   IDLE_TIMEOUT_MS = 0; // 0: the idle descriptors are closed only when an entry is needed
+static pthread_mutex_t LOCK            = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t
+now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint64_t
+hash_key(
+        const char *in_path,
+        const int in_flags) {
+    uint64_t hash = 14695981039346656037ULL ^ (uint64_t)(unsigned int)in_flags;
+    while (0 != *in_path) {
+        hash ^= (unsigned char) *in_path++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void
+lru_remove(const int in_entry) {
+    struct Entry *entry = &ENTRIES[in_entry];
+    if (NO_ENTRY != entry->lru_previous) ENTRIES[entry->lru_previous].lru_next = entry->lru_next;
+    else LRU_OLDEST = entry->lru_next;
+    if (NO_ENTRY != entry->lru_next) ENTRIES[entry->lru_next].lru_previous = entry->lru_previous;
+    else LRU_NEWEST = entry->lru_previous;
+    entry->lru_previous = NO_ENTRY;
+    entry->lru_next = NO_ENTRY;
+}
+
+static void
+lru_push(const int in_entry) {
+    ENTRIES[in_entry].lru_previous = LRU_NEWEST;
+    ENTRIES[in_entry].lru_next = NO_ENTRY;
+    if (NO_ENTRY != LRU_NEWEST) ENTRIES[LRU_NEWEST].lru_next = in_entry;
+    else LRU_OLDEST = in_entry;
+    LRU_NEWEST = in_entry;
+}
+
+static void
+bucket_remove(const int in_entry) {
+    int *link = &BUCKETS[ENTRIES[in_entry].hash & (BUCKETS_COUNT - 1)];
+    while (in_entry != *link) link = &ENTRIES[*link].next;
+    *link = ENTRIES[in_entry].next;
+}
+
+static void
+bucket_insert(const int in_entry) {
+    int *head = &BUCKETS[ENTRIES[in_entry].hash & (BUCKETS_COUNT - 1)];
+    ENTRIES[in_entry].next = *head;
+    *head = in_entry;
+}
+
+/**
+ * @brief Close the idle descriptor that has not been used for the longest time, if it has expired (at most one per
+ * call, so that the cost is spread over the calls to `give_back()`).
+ * @return If a descriptor was closed: 1. Otherwise: 0.
+ * @note The lock must not be held.
+ */
+
+static int
+reap_one() {
+    int fd = -1;
+    char *path = NULL;
+
+    pthread_mutex_lock(&LOCK);
+    if ((IDLE_TIMEOUT_MS > 0) && (OPEN_COUNT > MIN_SIZE) && (NO_ENTRY != LRU_OLDEST)
+        && (now_ms() - ENTRIES[LRU_OLDEST].last_used_ms >= (int64_t) IDLE_TIMEOUT_MS)) {
+        const int index = LRU_OLDEST;
+        lru_remove(index);
+        bucket_remove(index);
+        fd = ENTRIES[index].fd;
+        path = ENTRIES[index].path;
+        ENTRIES[index].fd = -1;
+        ENTRIES[index].path = NULL;
+        ENTRIES[index].state = EntryFree;
+        ENTRIES[index].next = FREE_ENTRIES;
+        FREE_ENTRIES = index;
+        OPEN_COUNT--;
+    }
+    pthread_mutex_unlock(&LOCK);
+    if (fd < 0) return 0;
+    close(fd);
+    free(path);
+    return 1;
+}
+
+/**
+ * @brief Close all the idle descriptors that have not been used for too long (see `RM_reaper_register()`).
+ */
+
+static void
+reap_all() {
+    while (reap_one()) {}
+}
+
+/**
+ * @brief Set the sizing policy of the handler.
+ * @param in_policy The policy. The maximum number of open descriptors is the capacity given to
+ * `RM_file_handler_init()`. The field `prewarm_size` is not used: the paths of the files are not known in advance.
+ * @note The policy applies immediately.
+ */
+
+void
+RM_file_handler_set_policy(const RM_PoolPolicy *in_policy) {
+    pthread_mutex_lock(&LOCK);
+    MIN_SIZE        = in_policy->min_size;
+    IDLE_TIMEOUT_MS = in_policy->idle_ttl_ms;
+    pthread_mutex_unlock(&LOCK);
+}
+
+/**
+ * @brief Initialize the file handler.
+ * @param in_object_size Not used.
+ * @param in_capacity The maximum number of open descriptors.
+ * @return On success: RM_success. Otherwise: RM_failure.
+ * @note Please note that this function may be called multiple times. The descriptors opened by the previous
+ * calls are closed.
+ */
+
+RM_Status
+RM_file_handler_init(
+        const size_t in_object_size,
+        const size_t in_capacity) {
+    size_t buckets_count = 1;
+
+    (void) in_object_size;
+    RM_file_handler_terminate();
+    if (0 == in_capacity) return RM_success; // borrowing will fail
+    if (in_capacity > INT32_MAX / 2) return RM_failure;
+    while (buckets_count < 2 * in_capacity) buckets_count *= 2;
+
+    pthread_mutex_lock(&LOCK);
+    ENTRIES = (struct Entry *) malloc(in_capacity * sizeof(struct Entry));
+    BUCKETS = (int *) malloc(buckets_count * sizeof(int));
+    if ((NULL == ENTRIES) || (NULL == BUCKETS)) {
+        free(ENTRIES);
+        free(BUCKETS);
+        ENTRIES = NULL;
+        BUCKETS = NULL;
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    for (size_t i = 0; i < buckets_count; i++) {
+        BUCKETS[i] = NO_ENTRY;
+    }
+    for (size_t i = 0; i < in_capacity; i++) {
+        ENTRIES[i].fd = -1;
+        ENTRIES[i].path = NULL;
+        ENTRIES[i].state = EntryFree;
+        ENTRIES[i].next = i + 1 < in_capacity ? (int)(i + 1) : NO_ENTRY;
+        ENTRIES[i].lru_previous = NO_ENTRY;
+        ENTRIES[i].lru_next = NO_ENTRY;
+    }
+    FREE_ENTRIES  = 0;
+    LRU_OLDEST    = NO_ENTRY;
+    LRU_NEWEST    = NO_ENTRY;
+    CAPACITY      = in_capacity;
+    BUCKETS_COUNT = buckets_count;
+    pthread_mutex_unlock(&LOCK);
+    RM_metrics_capacity(RM_METRICS_FILE, in_capacity);
+    RM_reaper_register(reap_all, NULL); // no warm-up: the paths are not known in advance
+    return RM_success;
+}
+
+/**
+ * @brief Take a descriptor for a path and flags: an idle descriptor if there is one, otherwise a new one.
+ * @param out_ptr The address of a pointer that will be assigned to the address of the descriptor.
+ * @param in_path The path to the file.
+ * @param in_flags The flags given to `open()`.
+ * @param in_mode The mode given to `open()`.
+ * @param in_init Flag that tells whether the offset of the descriptor must be set to the beginning of the file.
+ * @return On success: RM_success. Otherwise: RM_failure.
+ */
+
+static RM_Status
+take(
+        void **out_ptr,
+        const char *in_path,
+        const int in_flags,
+        const int in_mode,
+        const RM_Bool in_init) {
+    const uint64_t hash = hash_key(in_path, in_flags);
+    int index;
+    int old_fd = -1;
+    char *old_path = NULL;
+    char *new_path;
+    int fd;
+
+    pthread_mutex_lock(&LOCK);
+    if (0 == CAPACITY) {
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+
+    // Is there an idle descriptor for this path and these flags?
+    for (index = BUCKETS[hash & (BUCKETS_COUNT - 1)]; NO_ENTRY != index; index = ENTRIES[index].next) {
+        struct Entry *entry = &ENTRIES[index];
+        if ((EntryIdle == entry->state) && (hash == entry->hash) && (in_flags == entry->flags)
+            && (0 == strcmp(in_path, entry->path))) {
+            lru_remove(index);
+            entry->state = EntryBorrowed;
+            pthread_mutex_unlock(&LOCK);
+            if (in_init && (lseek(entry->fd, 0, SEEK_SET) < 0)) {
+                pthread_mutex_lock(&LOCK);
+                entry->state = EntryIdle;
+                lru_push(index);
+                pthread_mutex_unlock(&LOCK);
+                return RM_failure;
+            }
+            entry->since_ns = RM_metrics_clock();
+            *out_ptr = &entry->fd;
+            return RM_success;
+        }
+    }
+
+    // No: take a free entry, or close the least recently used idle descriptor.
+    if (NO_ENTRY != FREE_ENTRIES) {
+        index = FREE_ENTRIES;
+        FREE_ENTRIES = ENTRIES[index].next;
+    } else if (NO_ENTRY != LRU_OLDEST) {
+        index = LRU_OLDEST;
+        lru_remove(index);
+        bucket_remove(index);
+        old_fd = ENTRIES[index].fd;
+        old_path = ENTRIES[index].path;
+        ENTRIES[index].fd = -1;
+        ENTRIES[index].path = NULL;
+        OPEN_COUNT--;
+    } else {
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    ENTRIES[index].state = EntryBorrowed; // reserved: not in the hash table, nor in the LRU list
+    pthread_mutex_unlock(&LOCK);
+
+    // The system calls are performed without holding the lock.
+    if (old_fd >= 0) close(old_fd);
+    free(old_path);
+    new_path = strdup(in_path);
+    fd = NULL == new_path ? -1 : open(in_path, in_flags, in_mode);
+
+    pthread_mutex_lock(&LOCK);
+    if (fd < 0) {
+        free(new_path);
+        ENTRIES[index].state = EntryFree;
+        ENTRIES[index].next = FREE_ENTRIES;
+        FREE_ENTRIES = index;
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    ENTRIES[index].fd    = fd;
+    ENTRIES[index].flags = in_flags;
+    ENTRIES[index].path  = new_path;
+    ENTRIES[index].hash  = hash;
+    ENTRIES[index].since_ns = RM_metrics_clock();
+    bucket_insert(index);
+    OPEN_COUNT++;
+    *out_ptr = &ENTRIES[index].fd;
+    pthread_mutex_unlock(&LOCK);
+    return RM_success;
+}
+
+/**
+ * @brief Make borrowed descriptors idle. Either all the descriptors are given back, or none.
+ * @param in_ptrs An array of `in_count` pointers to descriptors. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @return If all the descriptors are borrowed (and appear once): RM_success. Otherwise: RM_failure.
+ */
+
+static RM_Status
+release(
+        void **in_ptrs,
+        const size_t in_count) {
+    int64_t now;
+    size_t n;
+
+    pthread_mutex_lock(&LOCK);
+    now = IDLE_TIMEOUT_MS > 0 ? now_ms() : 0;
+    for (n = 0; n < in_count; n++) {
+        struct Entry *entry = (struct Entry *) in_ptrs[n];
+        if (NULL == entry) continue;
+        if ((NULL == ENTRIES) || (entry < ENTRIES) || (entry >= ENTRIES + CAPACITY)
+            || (0 != ((size_t)((char *) entry - (char *) ENTRIES)) % sizeof(struct Entry))
+            || (EntryBorrowed != entry->state) || (entry->fd < 0)) {
+            break;
+        }
+        entry->state = EntryIdle; // a descriptor that appears twice is not "borrowed" the second time
+    }
+    if (n < in_count) {
+        for (size_t k = 0; k < n; k++) {
+            if (NULL != in_ptrs[k]) ((struct Entry *) in_ptrs[k])->state = EntryBorrowed;
+        }
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    for (n = 0; n < in_count; n++) {
+        struct Entry *entry = (struct Entry *) in_ptrs[n];
+        if (NULL == entry) continue;
+        RM_metrics_hold(RM_METRICS_FILE, entry->since_ns);
+        entry->since_ns = 0;
+        entry->last_used_ms = now;
+        lru_push((int)(entry - ENTRIES));
+    }
+    pthread_mutex_unlock(&LOCK);
+    return RM_success;
+}
+
+/**
+ * @brief Borrow a file descriptor.
+ * @param in_ptr The address of a pointer that will be assigned to the address of the descriptor (`int *`).
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @param in_init Flag that tells whether the offset of the descriptor must be set to the beginning of the file.
+ * @param ... `const char *in_path, int in_flags` and, if `in_flags` contains `O_CREAT`, `int in_mode` (see `open()`).
+ * @return On success: RM_success. Otherwise (all the descriptors are borrowed, `open()` failed, or a failure is
+ * simulated): RM_failure.
+ */
+
+RM_Status
+RM_file_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    va_list arguments;
+    const char *path;
+    int flags;
+    int mode = 0;
+
+    va_start(arguments, in_init);
+    path  = va_arg(arguments, const char *);
+    flags = va_arg(arguments, int);
+    if (0 != (flags & O_CREAT)) mode = va_arg(arguments, int);
+    va_end(arguments);
+    return RM_file_borrow_at((int **) in_ptr, path, flags, mode, in_init, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Borrow a file descriptor.
+ * @param in_fd The address of a pointer that will be assigned to the address of the descriptor.
+ * @param in_path The path to the file.
+ * @param in_flags The flags given to `open()`.
+ * @param in_mode The mode given to `open()` (only used if `in_flags` contains `O_CREAT`).
+ * @param in_init Flag that tells whether the offset of the descriptor must be set to the beginning of the file.
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (all the descriptors are borrowed, `open()` failed, or a failure is
+ * simulated): RM_failure.
+ * @note This function is not variadic: it is the entry point of the typed macros (see `RM_file_borrow()`).
+ */
+
+RM_Status
+RM_file_borrow_at(
+        int **in_fd,
+        const char *in_path,
+        int in_flags,
+        int in_mode,
+        RM_Bool in_init,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    void **ptr = (void **) in_fd;
+
+    *ptr = NULL;
+    if (RM_true == RM_fault_check("file", in_uid)) return RM_failure;
+
+    if (RM_failure == take(ptr, in_path, in_flags, in_mode, in_init)) return RM_failure;
+    RM_metrics_borrow(RM_METRICS_FILE, 1, 0);
+    record_borrow(ptr, "file", in_uid, in_file, in_line, in_function);
+    return RM_success;
+}
+
+/**
+ * @brief Give back a file descriptor. The descriptor is not closed: it waits for the next borrower.
+ * @param in_ptr The address of a pointer that is assigned to the address of the descriptor.
+ * The pointer is set to NULL.
+ * @param in_uid Unique ID of the call.
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (the descriptor was not borrowed from this handler): RM_failure.
+ * @note Please note that you can call this function multiple times.
+ */
+
+RM_Status
+RM_file_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    return RM_file_give_back_at((int **) in_ptr, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Give back a file descriptor (see `RM_file_handler_give_back()`).
+ * @note This function is not variadic: it is the entry point of the typed macros (see `RM_file_give_back()`).
+ */
+
+RM_Status
+RM_file_give_back_at(
+        int **in_fd,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function) {
+    void **ptr = (void **) in_fd;
+
+    if (NULL == *ptr) return RM_success;
+    if (RM_failure == release(ptr, 1)) {
+        record_give_back_failure(ptr, 1, "file", in_uid, in_file, in_line, in_function);
+        return RM_failure;
+    }
+
+    RM_metrics_give_back(RM_METRICS_FILE, 1);
+    record_give_back(ptr, "file", in_uid, in_file, in_line, in_function);
+    *ptr = NULL;
+    reap_one();
+    return RM_success;
+}
+
+/**
+ * @brief Borrow several file descriptors (one per path, with the same flags).
+ * @param in_ptrs An array of `in_count` pointers that will be assigned to the addresses of the descriptors.
+ * @param in_count The number of descriptors to borrow.
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @param in_init Flag that tells whether the offsets of the descriptors must be set to the beginning of the files.
+ * @param ... `const char *const *in_paths` (an array of `in_count` paths), `int in_flags` and, if `in_flags`
+ * contains `O_CREAT`, `int in_mode` (see `open()`).
+ * @return On success: RM_success. Otherwise, no descriptor is borrowed: RM_failure.
+ * @note Please note that the descriptors that must be opened are opened one after the other. If one of them
+ * cannot be opened, then the descriptors already taken are given back (they stay open, and idle).
+ */
+
+RM_Status
+RM_file_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    va_list arguments;
+    const char *const *paths;
+    int flags;
+    int mode = 0;
+    size_t n;
+
+    for (n = 0; n < in_count; n++) {
+        in_ptrs[n] = NULL;
+    }
+    va_start(arguments, in_init);
+    paths = va_arg(arguments, const char *const *);
+    flags = va_arg(arguments, int);
+    if (0 != (flags & O_CREAT)) mode = va_arg(arguments, int);
+    va_end(arguments);
+    if (RM_true == RM_fault_check("file", in_uid)) return RM_failure;
+
+    for (n = 0; n < in_count; n++) {
+        if (RM_failure == take(&in_ptrs[n], paths[n], flags, mode, in_init)) break;
+    }
+    if (n < in_count) {
+        for (size_t k = 0; k < n; k++) {
+            ((struct Entry *) in_ptrs[k])->since_ns = 0; // not a real borrow: no holding time
+        }
+        release(in_ptrs, n);
+        for (size_t k = 0; k < n; k++) {
+            in_ptrs[k] = NULL;
+        }
+        return RM_failure;
+    }
+    RM_metrics_borrow(RM_METRICS_FILE, in_count, 0);
+    record_borrow_many(in_ptrs, in_count, "file", in_uid, in_file, in_line, in_function);
+    return RM_success;
+}
+
+/**
+ * @brief Give back several file descriptors, under a single lock.
+ * @param in_ptrs An array of `in_count` pointers that are assigned to the addresses of the descriptors.
+ * The pointers are set to NULL. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @param in_uid Unique ID of the call.
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (a descriptor was not borrowed from this handler), no descriptor is
+ * given back: RM_failure.
+ */
+
+RM_Status
+RM_file_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    size_t count = 0;
+
+    if (RM_failure == release(in_ptrs, in_count)) {
+        record_give_back_failure(in_ptrs, in_count, "file", in_uid, in_file, in_line, in_function);
+        return RM_failure;
+    }
+    for (size_t i = 0; i < in_count; i++) {
+        if (NULL != in_ptrs[i]) count++;
+    }
+    RM_metrics_give_back(RM_METRICS_FILE, count);
+
+    record_give_back_many(in_ptrs, in_count, "file", in_uid, in_file, in_line, in_function);
+    for (size_t i = 0; i < in_count; i++) {
+        in_ptrs[i] = NULL;
+    }
+    reap_one();
+    return RM_success;
+}
+
+/**
+ * @brief Close all the descriptors.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_file_handler_terminate() {
+    RM_reaper_unregister(reap_all);
+    pthread_mutex_lock(&LOCK);
+    for (size_t i = 0; i < CAPACITY; i++) {
+        if (ENTRIES[i].fd >= 0) close(ENTRIES[i].fd);
+        free(ENTRIES[i].path);
+    }
+    free(ENTRIES);
+    free(BUCKETS);
+    ENTRIES       = NULL;
+    BUCKETS       = NULL;
+    CAPACITY      = 0;
+    BUCKETS_COUNT = 0;
+    FREE_ENTRIES  = NO_ENTRY;
+    LRU_OLDEST    = NO_ENTRY;
+    LRU_NEWEST    = NO_ENTRY;
+    OPEN_COUNT    = 0;
+    pthread_mutex_unlock(&LOCK);
+    RM_metrics_capacity(RM_METRICS_FILE, 0);
+}
+
+/**
+ * @brief Return the number of open descriptors (borrowed or idle).
+ * @return The number of open descriptors.
+ */
+
+unsigned long
+RM_file_handler_open_count() {
+    unsigned long count;
+    pthread_mutex_lock(&LOCK);
+    count = OPEN_COUNT;
+    pthread_mutex_unlock(&LOCK);
+    return count;
+}
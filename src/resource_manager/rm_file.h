@@ -0,0 +1,114 @@
+#ifndef C_PATTERNS_RM_FILE_H
+#define C_PATTERNS_RM_FILE_H
+
+#include "resource_manager.h"
+#include "rm_reaper.h"
+
+// File resource handler: the resources are open file descriptors, cached by (path, flags).
+//
+//      int *fd;
+//      RM_file_handler_init(0, 64); // at most 64 descriptors are open
+//      if (RM_failure == RM_file_handler_borrow(&fd, 1, __FILE__, __LINE__, (char*)__func__, RM_true,
+//                                               "/etc/hosts", O_RDONLY)) { ... }
+//      read(*fd, buffer, sizeof(buffer));
+//      RM_file_handler_give_back(&fd, 2, __FILE__, __LINE__, (char*)__func__);
+//
+// The typed macros call the handler without varargs, and capture the location of the call (see `RM_HERE`):
+//
+//      if (RM_failure == RM_file_borrow(&fd, 4, RM_false, "/tmp/log", O_WRONLY | O_CREAT | O_APPEND, 0644)) { ... }
+//      RM_file_give_back(&fd, 5);
+//
+// Several descriptors (one per path, with the same flags) can be borrowed at once:
+//
+//      const char *paths[2] = { "/etc/hosts", "/etc/passwd" };
+//      int *fds[2];
+//      RM_file_handler_borrow_many(fds, 2, 3, __FILE__, __LINE__, (char*)__func__, RM_false, paths, O_RDONLY);
+//
+// Giving back a descriptor does not close it: the next borrower of the same (path, flags) gets it without
+// calling `open()`. When all the descriptors are open, the least recently given back descriptor is closed.
+// The idle descriptors can also be closed after a timeout (see "rm_reaper.h"):
+//
+//      RM_PoolPolicy policy = { 0, 0, 30000 }; // close the descriptors unused for 30 s
+//      RM_file_handler_set_policy(&policy);
+
+void
+RM_file_handler_set_policy(
+        const RM_PoolPolicy *in_policy);
+
+RM_Status
+RM_file_handler_init(
+        size_t in_object_size,
+        size_t in_capacity);
+
+RM_Status
+RM_file_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_file_borrow_at(
+        int **in_fd,
+        const char *in_path,
+        int in_flags,
+        int in_mode,
+        RM_Bool in_init,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+#define RM_file_borrow(fd, uid, init, path, flags, mode) \
+    RM_file_borrow_at((fd), (path), (flags), (mode), (init), (uid), RM_HERE)
+
+RM_Status
+RM_file_give_back_at(
+        int **in_fd,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+#define RM_file_give_back(fd, uid) RM_file_give_back_at((fd), (uid), RM_HERE)
+
+RM_Status
+RM_file_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+RM_Status
+RM_file_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_file_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+void
+RM_file_handler_terminate();
+
+unsigned long
+RM_file_handler_open_count();
+
+#endif //C_PATTERNS_RM_FILE_H
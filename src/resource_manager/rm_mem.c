@@ -1,352 +1,605 @@
+/**
+ * Memory resource handler: the resources are buffers of a fixed size, served from a pool allocated once
+ * (by `RM_mem_handler_init()`).
+ *
+ * The pool is lock-free (see "rm_pool.c"): borrowing a buffer pops it from a stack of free buffers, giving back
+ * a buffer pushes it. Both operations are O(1), they never call `malloc()` or `free()`, and the threads that
+ * borrow buffers at the same time do not wait for each other.
+ *
+ *      +-----------+-----------+-----------+-----------+
+ *      | buffer 0  | buffer 1  | buffer 2  | buffer 3  |   POOL (capacity x stride bytes)
+ *      +-----------+-----------+-----------+-----------+
+ *      free stack = 3 -> 1   => buffers 0 and 2 are borrowed
+ *
+ * When the pool is exhausted, `RM_mem_handler_borrow_timed()` waits in a FIFO queue (see "rm_wait.c"): the
+ * buffers given back are handed to the oldest waiter. The queue is protected by a lock, which is only taken when
+ * threads are waiting.
+ *
+ * Optionally (see `RM_mem_handler_configure()`), each thread has a magazine: a small stack of buffers in front of
+ * the pool (see "rm_pool.c"). The thread borrows its buffers from its magazine, and gives them back to its
+ * magazine; the magazine exchanges whole batches with the pool. The threads do not contend on the pool anymore,
+ * but each thread may keep up to 2 batches of free buffers for itself. The magazine is drained when the thread
+ * exits, and when the thread notices that other threads wait for a buffer. A thread that is about to wait also
+ * reclaims the buffers kept in the magazines of all the threads (including the idle ones, which would not notice
+ * it): the magazines are registered in MAGAZINES, and each one has a small lock, taken by its thread around each
+ * operation (uncontended, unless the magazine is reclaimed). The batches (`borrow_many()`...) bypass the
+ * magazines.
+ *
+ * Please note: `RM_mem_handler_init()` and `RM_mem_handler_terminate()` must not be called while other threads
+ * borrow or give back buffers.
+ */
+
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
+#include <sched.h>
+#include <pthread.h>
 #include "resource_manager.h"
+#include "rm_fault.h"
+#include "rm_metrics.h"
+#include "rm_pool.h"
+#include "rm_wait.h"
 #include "rm_mem.h"
 
-static long       MALLOC_ID    = -1;
-static long       MALLOC_COUNT = 0;
-static long       COUNT        = 0;
-static const char *DUMP_PATH;
+static RM_Pool         POOL    = { 0, NULL, NULL, NULL, 0, RM_POOL_ALIGNMENT, 0 };
+static pthread_mutex_t LOCK    = PTHREAD_MUTEX_INITIALIZER; // protects QUEUE
+static RM_WaitQueue    QUEUE   = { NULL, NULL, { 0, 0, 0, 0, 0, 0 } };
+static unsigned long   WAITING = 0; // number of threads in QUEUE (read without the lock)
+static int64_t         *SINCE  = NULL; // SINCE[i]: when the buffer i was borrowed (see `RM_metrics_clock()`)
+
+static size_t          CONFIGURED_BATCH = 0; // see `RM_mem_handler_configure()`
+static size_t          BATCH            = 0; // the size of the batches of the magazines (0: no magazine)
+static unsigned long   GENERATION       = 0; // incremented each time the pool is replaced or released
+static pthread_once_t  KEY_ONCE         = PTHREAD_ONCE_INIT;
+static pthread_key_t   KEY; // its destructor drains the magazine of the thread that exits
+
+struct ThreadMagazine {
+    RM_Magazine           magazine;
+    unsigned long         generation; // the pool from which the magazine was filled
+    int                   busy;       // lock of the magazine (its thread, or a thread that reclaims its buffers)
+    int                   registered; // the magazine is in MAGAZINES
+    struct ThreadMagazine *next;
+};
+
+static struct ThreadMagazine *MAGAZINES = NULL; // the magazines of all the threads (protected by LOCK)
+
+static __thread struct ThreadMagazine THREAD_MAGAZINE = { { NULL, 0, 0 }, 0, 0, 0, NULL };
 
 /**
- * @brief Initialize the "s_alloc" library.
- *
- * Synopsis:
- *
- *      s_alloc_init(10, 2, "/tmp/dump-10.txt");
- *      // call (to `s_malloc` or `s_realloc`) which ID is 10 will fail after 2 iterations.
- *      ...
- *      s_alloc_init(11, 3, "/tmp/dump-11.txt");
- *      // call (to `s_malloc` or `s_realloc`) which ID is 11 will fail after 3 iterations.
- *      ...
- *
- * @param in_id_failure The ID of the call to the function `s_malloc()` that must fail after `in_count`
- * calls. If the given value is negative, then the call will never fail (unless, of course, if
- * your process really runs out of memory!).
- * @param in_count_success For the specified ID `in_id`, the number of times a call to the function
- * `s_malloc()` succeeds until it fails. If the given value is negative or zero, that the first
- * call to the function will fail (for the given ID `in_id`).
- * @param in_dump_path Path to a file used to record data relative to all allocations / deallocations.
- * If NULL, then no data is recorded.
- * @param in_exit_on_data_recording_error Flag that tells whether the library should terminate the process
- * execution if it is impossible to record allocation data.
- * - true: the library terminates the process execution.
- * - false: the library does not terminate the process execution (why would you do that?)
- * @note Please note that this function may (and probably will) be called multiple times.
+ * @brief Hand the free buffers to the waiters, oldest first.
+ * @note The lock must be held.
  */
 
-void
-s_alloc_init(
-        const long in_id_failure,
-        const long in_count_success,
-        const char *in_dump_path,
-        const Bool in_exit_on_data_recording_error) {
-    MALLOC_ID = in_id_failure;
-    MALLOC_COUNT = in_count_success;
-    DUMP_PATH                    = in_dump_path;
-    EXIT_ON_DATA_RECORDING_ERROR = in_exit_on_data_recording_error;
+static void
+serve_waiters() {
+    while (NULL != QUEUE.head) {
+        void *buffer = RM_pool_pop(&POOL);
+        if (NULL == buffer) break;
+        RM_wait_queue_serve(&QUEUE, buffer);
+    }
+}
+
+static inline void
+lock_magazine(struct ThreadMagazine *in_magazine) {
+    while (0 != __atomic_exchange_n(&in_magazine->busy, 1, __ATOMIC_ACQUIRE)) {
+        sched_yield();
+    }
+}
+
+static inline void
+unlock_magazine(struct ThreadMagazine *in_magazine) {
+    __atomic_store_n(&in_magazine->busy, 0, __ATOMIC_RELEASE);
 }
 
 /**
- * @brief The `s_malloc()` function allocates `in_size` bytes.
- *
- * Synopsis:
- *
- *      #define ID_FAIL 10
- *
- *      char *c;
- *
- *      s_alloc_init(ID_FAIL, 2, "/tmp/dump-10.txt");
- *      ...
- *      for (int i=0; i<3; i++) {
- *         if (failure == s_malloc(&c, ID_FAIL, 100, true, __FILE__, __LINE__, __func__)) {
- *              // i=2 => this bloc is executed
- *              ...
- *         }
- *         // i=0 => OK.
- *         // i=1 => OK.
- *         ...
- *         s_free(&c, __FILE__, __LINE__, __func__);
- *      }
- *
- * @param in_ptr The address of a pointer that will be assigned to the address of the allocated memory.
- * @param in_id Unique ID of the call to `s_malloc()`.
- * @param in_size Number of bytes to allocate.
- * @param in_initialize Flag that tells whether the allocated memory must be initialized with all zeros or not.
- * - true: the allocated memory is initialized with all zeros.
- * - false: the allocated memory is not initialized with all zeros.
- * @param in_file Path to the file from which this function is called (typically, you set the value `__FILE__`).
- * Optional: you can assign the value NULL to this parameter.
- * @param in_line The line, within the file `in_file`, where this function is called (typically, you set the value
- * `__LINE__`).
- * Optional: you can assign the value 0 to this parameter.
- * @param in_function Name of the function from which this function is called (typically, you set the value `__func__`).
- * Optional: you can assign the value NULL to this parameter.
- * @return Upon successful completion: `success`. Otherwise: `failure`.
+ * @brief Put the buffers of a magazine back into the pool, and hand them to the waiters (if any).
+ * @param in_magazine The magazine.
+ * @return The number of buffers put back into the pool.
  */
 
-Status
-s_malloc(
-        void **in_ptr,
-        const long in_id,
-        const size_t in_size,
-        Bool in_initialize,
-        const char *in_file,
-        unsigned long in_line,
-        const char *in_function) {
-    // Shall we simulate a shortage of resources?
-    if ((MALLOC_ID >= 0) && (in_id >= 0) && (MALLOC_ID == in_id)) {
-        if (COUNT >= MALLOC_COUNT) {
-            return failure;
-        }
-        COUNT += 1;
+static size_t
+drain(struct ThreadMagazine *in_magazine) {
+    size_t count;
+
+    lock_magazine(in_magazine);
+    count = RM_magazine_drain(&POOL, &in_magazine->magazine);
+    unlock_magazine(in_magazine);
+    if (0 == count) return 0;
+    // See `put()`.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (0 != __atomic_load_n(&WAITING, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&LOCK);
+        serve_waiters();
+        pthread_mutex_unlock(&LOCK);
     }
-    *in_ptr = (void*)malloc(in_size);
-    if (in_initialize) memset(*in_ptr, 0, in_size);
-    // Dump data into the dump file.
-    record_malloc(in_ptr, in_id, in_size, in_file, in_line, in_function);
-    return success;
+    return count;
 }
 
 /**
- * @brief Reallocate memory.
- *
- *      #define ID_OK 9
- *      #define ID_FAIL 10
- *
- *      char *c;
- *
- *      s_alloc_init(ID_FAIL, 2, "/tmp/dump-10.txt");
- *      ...
- *      if (failure == s_malloc(&c, ID_OK, 100, true, __FILE__, __LINE__, __func__)) {
- *              // treat the error
- *      }
- *
- *      for (int i=0; i<3; i++) {
- *          it (failure == s_realloc(&c, ID_FAIL, 1000, __FILE__, __LINE__, __func__)) {
- *              // i=2 => this bloc is executed
- *              ...
- *          }
- *         // i=0 => OK.
- *         // i=1 => OK.
- *         ...
- *      }
- *
- *      s_free(&c, __FILE__, __LINE__, __func__);
- *
- * @param in_ptr The address of a pointer that:
- * (1) is assigned to the address of the memory to reallocate
- * and
- * (2) will be assigned to the address of the reallocated memory.
- * @param in_id Unique ID of the call to `s_realloc()`.
- * @param in_new_size The new required size of the memory.
- * @param in_file Path to the file from which this function is called (typically, you set the value `__FILE__`).
- * Optional: you can assign the value NULL to this parameter.
- * @param in_line The line, within the file `in_file`, where this function is called (typically, you set the value
- * `__LINE__`).
- * Optional: you can assign the value 0 to this parameter.
- * @param in_function Name of the function from which this function is called (typically, you set the value `__func__`).
- * Optional: you can assign the value NULL to this parameter.
- * @return Upon successful completion: `success`. Otherwise: `failure`.
+ * @brief Put the buffers kept in the magazines of all the threads back into the pool.
+ * @note The lock must be held. The magazines filled from a previous pool are ignored.
  */
 
-Status
-s_realloc(
-        void **in_ptr,
-        const long in_id,
-        size_t in_new_size,
-        const char *in_file,
-        unsigned long in_line,
-        const char *in_function) {
-    void *p;
-    void *old_ptr = *in_ptr;
+static void
+reclaim() {
+    const unsigned long generation = __atomic_load_n(&GENERATION, __ATOMIC_ACQUIRE);
 
-    // Shall we simulate a shortage of resources?
-    if ((MALLOC_ID >= 0) && (in_id >= 0) && (MALLOC_ID == in_id)) {
-        if (COUNT >= MALLOC_COUNT) return failure;
-        COUNT += 1;
+    for (struct ThreadMagazine *magazine = MAGAZINES; NULL != magazine; magazine = magazine->next) {
+        lock_magazine(magazine);
+        if (generation == magazine->generation) RM_magazine_drain(&POOL, &magazine->magazine);
+        unlock_magazine(magazine);
     }
-    p = realloc(*in_ptr, in_new_size);
-    if (NULL == p) return failure;
-    *in_ptr = p;
-    // Dump data into the dump file.
-    record_realloc(in_ptr, old_ptr, in_id, in_new_size, in_file, in_line, in_function);
-    return success;
 }
 
+static void
+destroy_magazine(void *in_magazine) {
+    struct ThreadMagazine *magazine = (struct ThreadMagazine *) in_magazine;
+    struct ThreadMagazine **link;
+
+    pthread_mutex_lock(&LOCK);
+    for (link = &MAGAZINES; magazine != *link; link = &(*link)->next) {}
+    *link = magazine->next;
+    pthread_mutex_unlock(&LOCK);
+    magazine->registered = 0;
+    if (magazine->generation == __atomic_load_n(&GENERATION, __ATOMIC_ACQUIRE)) drain(magazine);
+    RM_magazine_terminate(&magazine->magazine);
+}
+
+static void
+create_key() {
+    pthread_key_create(&KEY, destroy_magazine);
+}
 
 /**
- * @brief Free the memory located at the address
- *
- * Synopsis:
- *
- *      #define ID_FAIL 10
- *
- *      char *c;
- *
- *      s_alloc_init(ID_FAIL, 2, "/tmp/dump-10.txt");
- *
- *      if (failure == s_malloc(&c, ID_FAIL, 100, true, __FILE__, __LINE__, __func__)) {
- *          // Treat the error
- *      }
- *      ...
- *      s_free(&c, __FILE__, __LINE__, __func__);
- *      s_free(&c, __FILE__, __LINE__, __func__); // it might seem useless or risky (it's debatable), but it does not harm
- *
- * @param in_ptr The address of a pointer that is assigned to the address of the memory to free.
- * @param in_file Path to the file from which this function is called (typically, you set the value `__FILE__`).
- * Optional: you can assign the value NULL to this parameter.
- * @param in_line The line, within the file `in_file`, where this function is called (typically, you set the value
- * `__LINE__`).
- * Optional: you can assign the value 0 to this parameter.
- * @param in_function Name of the function from which this function is called (typically, you set the value `__func__`).
- * Optional: you can assign the value NULL to this parameter.
+ * @brief Return the magazine of the calling thread.
+ * @return The magazine, or NULL if the magazines are disabled (or if the magazine could not be allocated).
+ * @note A magazine filled from a previous pool is emptied (its buffers do not exist anymore).
  */
 
-void
-s_free(void **in_ptr,
-       const char *in_file,
-       unsigned long in_line,
-       const char *in_function) {
-    // Dump data into the dump file, if required.
-    record_free(in_ptr, in_file, in_line, in_function);
-    if (NULL == *in_ptr) return;
-    free(*in_ptr);
-    *in_ptr = NULL;
+static struct ThreadMagazine *
+magazine() {
+    const unsigned long generation = __atomic_load_n(&GENERATION, __ATOMIC_ACQUIRE);
+    RM_Status status;
+
+    if (0 == BATCH) return NULL;
+    if (THREAD_MAGAZINE.generation != generation) {
+        lock_magazine(&THREAD_MAGAZINE);
+        RM_magazine_terminate(&THREAD_MAGAZINE.magazine);
+        status = RM_magazine_init(&THREAD_MAGAZINE.magazine, BATCH);
+        if (RM_success == status) THREAD_MAGAZINE.generation = generation;
+        unlock_magazine(&THREAD_MAGAZINE);
+        if (RM_failure == status) return NULL;
+        if (! THREAD_MAGAZINE.registered) {
+            pthread_once(&KEY_ONCE, create_key);
+            pthread_setspecific(KEY, &THREAD_MAGAZINE);
+            pthread_mutex_lock(&LOCK);
+            THREAD_MAGAZINE.next = MAGAZINES;
+            MAGAZINES = &THREAD_MAGAZINE;
+            pthread_mutex_unlock(&LOCK);
+            THREAD_MAGAZINE.registered = 1;
+        }
+    }
+    return &THREAD_MAGAZINE;
+}
+
+/**
+ * @brief Return the address of the borrowing time of a buffer.
+ * @param in_buffer The buffer. It must belong to the pool.
+ */
+
+static inline int64_t *
+since(const void *in_buffer) {
+    return &SINCE[(size_t)((const unsigned char *) in_buffer - POOL.objects) / POOL.stride];
 }
 
-// -------------------------------------------------------------------------------------
-// Private API
-// -------------------------------------------------------------------------------------
+/**
+ * @brief Record the metrics of buffers given back.
+ * @param in_buffers An array of `in_count` buffers. The NULL pointers, and the buffers that do not belong to the
+ * pool, are ignored.
+ * @param in_count The number of pointers in the array.
+ * @note This function must be called before the buffers are put back into the pool (another thread could borrow
+ * them). The borrowing time of a buffer is reset, so that a double give back is not measured twice.
+ */
 
 static void
-record_malloc(
-        void **in_ptr,
-        const long in_id,
-        const size_t in_size,
-        const char *in_file,
-        unsigned long in_line,
-        const char *in_function) {
-    FILE *fd;
+measure_give_back(
+        void **in_buffers,
+        const size_t in_count) {
+    for (size_t i = 0; (NULL != SINCE) && (i < in_count); i++) {
+        int64_t *borrowed;
+        if ((NULL == in_buffers[i]) || (RM_false == RM_pool_contains(&POOL, in_buffers[i]))) continue;
+        borrowed = since(in_buffers[i]);
+        if (0 != __atomic_load_n(borrowed, __ATOMIC_RELAXED)) {
+            RM_metrics_hold(RM_METRICS_MEM, __atomic_exchange_n(borrowed, 0, __ATOMIC_RELAXED));
+        }
+    }
+}
+
+/**
+ * @brief Take a buffer, and wait for it if necessary.
+ * @param in_timeout_ms The maximum waiting time, in milliseconds (0: do not wait, `RM_WAIT_FOREVER`: no limit).
+ * @param out_wait_ns The time spent waiting, in nanoseconds.
+ * @return The buffer, or NULL.
+ */
 
-    if (NULL == DUMP_PATH) return;
+static void *
+take(
+        const long in_timeout_ms,
+        uint64_t *out_wait_ns) {
+    void *buffer = NULL;
+    struct ThreadMagazine *cache = magazine();
+    RM_Waiter waiter;
 
-    fd = fopen(DUMP_PATH, "a");
-    if (NULL == fd) {
-        fprintf(stderr,
-                "WARNING: cannot open dump file \"%s\"!\n",
-                DUMP_PATH);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_ERROR);
+    // The waiters are served first: if a thread waits, then the buffers given back are not for newcomers (and the
+    // buffers kept in the magazine of this thread are for them).
+    *out_wait_ns = 0;
+    if (0 == __atomic_load_n(&WAITING, __ATOMIC_SEQ_CST)) {
+        if (NULL == cache) {
+            buffer = RM_pool_pop(&POOL);
+        } else {
+            lock_magazine(cache);
+            buffer = RM_magazine_pop(&POOL, &cache->magazine);
+            unlock_magazine(cache);
+        }
+    } else if (NULL != cache) {
+        drain(cache);
+    }
+    if ((NULL != buffer) || (0 == in_timeout_ms)) return buffer;
+
+    pthread_mutex_lock(&LOCK);
+    RM_wait_queue_enqueue(&QUEUE, &waiter);
+    __atomic_add_fetch(&WAITING, 1, __ATOMIC_SEQ_CST);
+    // A buffer may have been given back before WAITING was incremented (the giver did not see this waiter), or it
+    // may be kept in the magazine of a thread that does not borrow or give back anymore.
+    serve_waiters();
+    if ((NULL != QUEUE.head) && (0 != BATCH)) {
+        reclaim();
+        serve_waiters();
     }
-    if (fprintf(fd,
-                "A %s[%s] %s[%s]:%lud %p %p %lud (%ld)\n",
-                (NULL != in_function) ? "+" : "-",
-                (NULL != in_function) ? in_function : "",
-                (NULL != in_file) ? "+" : "-",
-                (NULL != in_file) ? in_file : "",
-                in_line,
-                in_ptr,  // the address of the pointer used to store the address of the allocated memory
-                *in_ptr, // the address of the allocated memory
-                in_size, // the size of the allocated memory
-                in_id) < 0) {
-        fprintf(stderr,
-                "WARNING: error while while writing into file \"%s\"!\n",
-                DUMP_PATH);
-        fclose(fd);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_ERROR);
+    if (RM_success == RM_wait_queue_wait(&QUEUE, &waiter, &LOCK, in_timeout_ms)) buffer = waiter.item;
+    *out_wait_ns = waiter.waited_ns;
+    __atomic_sub_fetch(&WAITING, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&LOCK);
+    return buffer;
+}
+
+/**
+ * @brief Put buffers back into the pool, and hand them to the waiters (if any).
+ * @param in_buffers An array of `in_count` buffers. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @return On success: RM_success. Otherwise (see `RM_pool_push_many()`): RM_failure.
+ */
+
+static RM_Status
+put(
+        void **in_buffers,
+        const size_t in_count) {
+    if (RM_failure == RM_pool_push_many(&POOL, in_buffers, in_count)) return RM_failure;
+    // The buffers are pushed before WAITING is read (and WAITING is incremented before a waiter tries to take a
+    // buffer): either the giver sees the waiter, or the waiter sees the buffer.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (0 != __atomic_load_n(&WAITING, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&LOCK);
+        serve_waiters();
+        pthread_mutex_unlock(&LOCK);
     }
-    if (0 != fclose(fd)) {
-        fprintf(stderr,
-                "WARNING: error while closing dump file \"%s\"!\n",
-                DUMP_PATH);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_ERROR);
+    return RM_success;
+}
+
+/**
+ * @brief Give back a single buffer: put it into the magazine of the calling thread, or into the pool.
+ * @param in_buffer The buffer.
+ * @return On success: RM_success. Otherwise (see `RM_pool_push_many()`): RM_failure.
+ */
+
+static RM_Status
+put_one(void *in_buffer) {
+    struct ThreadMagazine *cache = magazine();
+    RM_Status status;
+
+    if (NULL == cache) return put(&in_buffer, 1);
+    lock_magazine(cache);
+    status = RM_magazine_push(&POOL, &cache->magazine, in_buffer);
+    unlock_magazine(cache);
+    if (RM_failure == status) return RM_failure;
+    // The buffer is in the magazine before WAITING is read (and a waiter increments WAITING before it reclaims the
+    // magazines): either the giver sees the waiter, or the waiter finds the buffer. See `put()`.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (0 != __atomic_load_n(&WAITING, __ATOMIC_SEQ_CST)) drain(cache);
+    return RM_success;
+}
+
+/**
+ * @brief Set the size of the magazines (the per-thread caches of buffers).
+ * @param in_batch_size The number of buffers exchanged between a magazine and the pool at once. A magazine
+ * holds at most twice this number of buffers. The value 0 (the default) disables the magazines.
+ * @note The configuration is applied by the next call to `RM_mem_handler_init()`.
+ */
+
+void
+RM_mem_handler_configure(const size_t in_batch_size) {
+    CONFIGURED_BATCH = in_batch_size;
+}
+
+/**
+ * @brief Initialize the memory handler: allocate the pool of buffers.
+ * @param in_object_size The size of the buffers, in bytes.
+ * @param in_capacity The number of buffers in the pool (that is, the maximum number of buffers borrowed at
+ * the same time).
+ * @return On success: RM_success. Otherwise: RM_failure.
+ * @note Please note that this function may be called multiple times. The previous pool is released: the
+ * buffers borrowed from the previous pool must not be used anymore.
+ */
+
+RM_Status
+RM_mem_handler_init(
+        const size_t in_object_size,
+        const size_t in_capacity) {
+    RM_mem_handler_terminate();
+    if (RM_failure == RM_pool_init(&POOL, in_object_size, in_capacity)) return RM_failure;
+    SINCE = (int64_t *) calloc(in_capacity > 0 ? in_capacity : 1, sizeof(int64_t));
+    if (NULL == SINCE) {
+        RM_pool_terminate(&POOL);
+        return RM_failure;
     }
+    BATCH = CONFIGURED_BATCH;
+    __atomic_add_fetch(&GENERATION, 1, __ATOMIC_RELEASE);
+    RM_metrics_capacity(RM_METRICS_MEM, in_capacity); // capacity 0: borrowing will fail
+    return RM_success;
 }
 
-static void
-record_realloc(
+/**
+ * @brief Borrow a buffer from the pool.
+ * @param in_ptr The address of a pointer that will be assigned to the address of the buffer.
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @param in_init Flag that tells whether the buffer must be filled with zeros or not.
+ * If RM_false, then the content of the buffer is unspecified (it may contain data from a previous borrower).
+ * @return On success: RM_success. Otherwise (the pool is exhausted, or a failure is simulated): RM_failure.
+ * @note This function never waits ("try borrow"). See `RM_mem_handler_borrow_timed()`.
+ */
+
+RM_Status
+RM_mem_handler_borrow(
         void **in_ptr,
-        void *in_old_address,
-        const long in_id,
-        const size_t in_size,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    return RM_mem_borrow_at(in_ptr, 0, in_init, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Borrow a buffer from the pool. If the pool is exhausted, wait until a buffer is given back.
+ * @param in_ptr The address of a pointer that will be assigned to the address of the buffer.
+ * @param in_timeout_ms The maximum waiting time, in milliseconds. The value 0 means "do not wait", and the value
+ * `RM_WAIT_FOREVER` means "wait as long as necessary".
+ * @param in_init Flag that tells whether the buffer must be filled with zeros or not.
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (the timeout expired, or a failure is simulated): RM_failure.
+ * @note The waiting threads are served in the order of arrival.
+ * @note This function is not variadic: it is the entry point of the typed macros (see `RM_mem_borrow()`).
+ */
+
+RM_Status
+RM_mem_borrow_at(
+        void **in_ptr,
+        long in_timeout_ms,
+        RM_Bool in_init,
+        long in_uid,
         const char *in_file,
         unsigned long in_line,
         const char *in_function) {
-    FILE *fd;
+    uint64_t wait_ns;
 
-    if (NULL == DUMP_PATH) return;
+    *in_ptr = NULL;
+    if (RM_true == RM_fault_check("mem", in_uid)) return RM_failure;
 
-    fd = fopen(DUMP_PATH,
-               "a");
-    if (NULL == fd) {
-        fprintf(stderr,
-                "WARNING: cannot open dump file \"%s\"!\n",
-                DUMP_PATH);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_ERROR);
-    }
-    if (fprintf(fd,
-                "R %s[%s] %s[%s]:%lud %p %p %p %lud (%ld)\n",
-                (NULL != in_function) ? "+" : "-",
-                (NULL != in_function) ? in_function : "",
-                (NULL != in_file) ? "+" : "-",
-                (NULL != in_file) ? in_file : "",
-                in_line,
-                in_ptr,     // the address of the pointer used to store the address of the allocated memory
-                in_old_address, // the previous address of the allocated memory
-                *in_ptr,    // the new address of the allocated memory
-                in_size,    // the new size of the allocated memory
-                in_id) < 0) {
-        fprintf(stderr,
-                "WARNING: error while while writing into file \"%s\"!\n",
-                DUMP_PATH);
-        fclose(fd);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_ERROR);
-    }
-    if (0 != fclose(fd)) {
-        fprintf(stderr,
-                "WARNING: error while closing dump file \"%s\"!\n",
-                DUMP_PATH);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_ERROR);
+    *in_ptr = take(in_timeout_ms, &wait_ns);
+    if (NULL == *in_ptr) {
+        if (0 != wait_ns) RM_metrics_borrow(RM_METRICS_MEM, 0, wait_ns); // timeout
+        return RM_failure;
     }
+    __atomic_store_n(since(*in_ptr), RM_metrics_clock(), __ATOMIC_RELAXED);
+    RM_metrics_borrow(RM_METRICS_MEM, 1, wait_ns);
+    if (in_init) memset(*in_ptr, 0, POOL.object_size);
+    record_borrow(in_ptr, "mem", in_uid, in_file, in_line, in_function);
+    return RM_success;
 }
 
-static void
-record_free(
+/**
+ * @brief Borrow a buffer. If none is available, wait until a buffer is given back (see `RM_mem_borrow_at()`).
+ */
+
+RM_Status
+RM_mem_handler_borrow_timed(
+        void **in_ptr,
+        long in_timeout_ms,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    return RM_mem_borrow_at(in_ptr, in_timeout_ms, in_init, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Give back a buffer to the pool.
+ * @param in_ptr The address of a pointer that is assigned to the address of the buffer.
+ * The pointer is set to NULL.
+ * @param in_uid Unique ID of the call.
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (the buffer does not belong to the pool, or it has already been
+ * given back): RM_failure.
+ * @note Please note that you can call this function multiple times.
+ */
+
+RM_Status
+RM_mem_give_back_at(
         void **in_ptr,
+        long in_uid,
         const char *in_file,
         unsigned long in_line,
         const char *in_function) {
+    if (NULL == *in_ptr) return RM_success;
+    measure_give_back(in_ptr, 1);
+    if (RM_failure == put_one(*in_ptr)) {
+        record_give_back_failure(in_ptr, 1, "mem", in_uid, in_file, in_line, in_function);
+        return RM_failure;
+    }
+    RM_metrics_give_back(RM_METRICS_MEM, 1);
+
+    record_give_back(in_ptr, "mem", in_uid, in_file, in_line, in_function);
+    *in_ptr = NULL;
+    return RM_success;
+}
+
+/**
+ * @brief Give back a buffer (see `RM_mem_give_back_at()`).
+ */
+
+RM_Status
+RM_mem_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    return RM_mem_give_back_at(in_ptr, in_uid, in_file, in_line, in_function);
+}
+
+/**
+ * @brief Borrow several buffers from the pool, in a single pool operation.
+ * @param in_ptrs An array of `in_count` pointers that will be assigned to the addresses of the buffers.
+ * @param in_count The number of buffers to borrow.
+ * @param in_uid Unique ID of the call (see `RM_init()`).
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @param in_init Flag that tells whether the buffers must be filled with zeros or not.
+ * @return On success: RM_success. Otherwise (less than `in_count` buffers are free, or a failure is simulated),
+ * no buffer is borrowed: RM_failure.
+ */
+
+RM_Status
+RM_mem_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...) {
+    RM_Status status = RM_failure;
+    struct ThreadMagazine *cache;
+
+    // A batch does not wait, and does not take the buffers from the waiters. The buffers kept in the magazine of
+    // the calling thread are put back into the pool if the pool does not hold enough buffers.
+    if ((RM_false == RM_fault_check("mem", in_uid)) && (0 == __atomic_load_n(&WAITING, __ATOMIC_SEQ_CST))) {
+        status = RM_pool_pop_many(&POOL, in_ptrs, in_count);
+        if ((RM_failure == status) && (NULL != (cache = magazine())) && (drain(cache) > 0)) {
+            status = RM_pool_pop_many(&POOL, in_ptrs, in_count);
+        }
+    }
+    if (RM_failure == status) {
+        for (size_t i = 0; i < in_count; i++) {
+            in_ptrs[i] = NULL;
+        }
+        return RM_failure;
+    }
+    for (size_t i = 0; i < in_count; i++) {
+        __atomic_store_n(since(in_ptrs[i]), RM_metrics_clock(), __ATOMIC_RELAXED);
+        if (in_init) memset(in_ptrs[i], 0, POOL.object_size);
+    }
+    RM_metrics_borrow(RM_METRICS_MEM, in_count, 0);
+    record_borrow_many(in_ptrs, in_count, "mem", in_uid, in_file, in_line, in_function);
+    return RM_success;
+}
 
-    FILE *fd;
+/**
+ * @brief Give back several buffers to the pool, in a single pool operation.
+ * @param in_ptrs An array of `in_count` pointers that are assigned to the addresses of the buffers.
+ * The pointers are set to NULL. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @param in_uid Unique ID of the call.
+ * @param in_file Path to the file from which this function is called.
+ * @param in_line The line, within the file `in_file`, where this function is called.
+ * @param in_function Name of the function from which this function is called.
+ * @return On success: RM_success. Otherwise (a buffer does not belong to the pool, or it has already been given
+ * back), no buffer is given back: RM_failure.
+ */
 
-    if (NULL == DUMP_PATH) return;
+RM_Status
+RM_mem_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...) {
+    size_t count = 0;
 
-    fd = fopen(DUMP_PATH, "a");
-    if (NULL == fd) {
-        fprintf(stderr,
-                "WARNING: cannot open dump file \"%s\"!\n",
-                DUMP_PATH);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_FAILURE);
+    // If the batch is refused, then the holding times of its valid buffers are recorded anyway (and they will not
+    // be recorded again when the buffers are given back).
+    measure_give_back(in_ptrs, in_count);
+    if (RM_failure == put(in_ptrs, in_count)) {
+        record_give_back_failure(in_ptrs, in_count, "mem", in_uid, in_file, in_line, in_function);
+        return RM_failure;
     }
-    if (fprintf(fd,
-                "F %s[%s] %s[%s]:%lud %p %p\n",
-                (NULL != in_function) ? "+" : "-",
-                (NULL != in_function) ? in_function : "",
-                (NULL != in_file) ? "+" : "-",
-                (NULL != in_file) ? in_file : "",
-                in_line,
-                in_ptr,         // the address of the pointer used to store the address of the memory to free
-                *in_ptr) < 0) { // the address of the memory that to free
-        fprintf(stderr,
-                "WARNING: error while while writing into file \"%s\"!\n",
-                DUMP_PATH);
-        fclose(fd);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_FAILURE);
+    for (size_t i = 0; i < in_count; i++) {
+        if (NULL != in_ptrs[i]) count++;
     }
-    if (0 != fclose(fd)) {
-        fprintf(stderr,
-                "WARNING: error while closing dump file \"%s\"!\n", DUMP_PATH);
-        if (EXIT_ON_DATA_RECORDING_ERROR) exit(EXIT_FAILURE);
+    RM_metrics_give_back(RM_METRICS_MEM, count);
+
+    record_give_back_many(in_ptrs, in_count, "mem", in_uid, in_file, in_line, in_function);
+    for (size_t i = 0; i < in_count; i++) {
+        in_ptrs[i] = NULL;
     }
+    return RM_success;
+}
+
+/**
+ * @brief Release the pool of buffers.
+ * @note The threads that wait for a buffer are woken up: their calls to `borrow()` fail.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_mem_handler_terminate() {
+    // The magazines of the threads are forgotten (see `magazine()`).
+    __atomic_add_fetch(&GENERATION, 1, __ATOMIC_RELEASE);
+    BATCH = 0;
+    // The waiters are woken up before the pool is released, and the lock is held while it is released (see
+    // `serve_waiters()`).
+    pthread_mutex_lock(&LOCK);
+    RM_wait_queue_cancel_all(&QUEUE);
+    RM_pool_terminate(&POOL);
+    pthread_mutex_unlock(&LOCK);
+    free(SINCE);
+    SINCE = NULL;
+    RM_metrics_capacity(RM_METRICS_MEM, 0);
+}
+
+/**
+ * @brief Return the statistics of the wait queue (see `RM_mem_handler_borrow_timed()`).
+ * @param out_stats The statistics.
+ */
+
+void
+RM_mem_handler_wait_stats(RM_WaitStats *out_stats) {
+    pthread_mutex_lock(&LOCK);
+    *out_stats = QUEUE.stats;
+    pthread_mutex_unlock(&LOCK);
 }
@@ -5,4 +5,121 @@
 #ifndef C_PATTERNS_RM_MEM_H
 #define C_PATTERNS_RM_MEM_H
 
+#include "resource_manager.h"
+#include "rm_wait.h"
+
+// Memory resource handler: the resources are buffers of a fixed size (given to `RM_mem_handler_init()`),
+// served from a preallocated pool.
+//
+//      void *buffer;
+//      RM_mem_handler_init(4096, 64);
+//      if (RM_failure == RM_mem_handler_borrow(&buffer, 1, __FILE__, __LINE__, (char*)__func__, RM_true)) { ... }
+//      ...
+//      RM_mem_handler_give_back(&buffer, 2, __FILE__, __LINE__, (char*)__func__);
+//
+// If the pool is exhausted, `RM_mem_handler_borrow()` fails immediately, and `RM_mem_handler_borrow_timed()`
+// waits for a buffer (at most 100 ms here):
+//
+//      RM_mem_handler_borrow_timed(&buffer, 100, 3, __FILE__, __LINE__, (char*)__func__, RM_false);
+//
+// The typed macros call the handler without varargs, and capture the location of the call (see `RM_HERE`):
+//
+//      if (RM_failure == RM_mem_borrow(&buffer, 4, RM_false)) { ... }
+//      RM_mem_give_back(&buffer, 5);
+//
+// Each thread may cache buffers in front of the pool (here, batches of 16 buffers):
+//
+//      RM_mem_handler_configure(16);
+//      RM_mem_handler_init(4096, 1024);
+
+void
+RM_mem_handler_configure(
+        size_t in_batch_size);
+
+RM_Status
+RM_mem_handler_init(
+        size_t in_object_size,
+        size_t in_capacity);
+
+RM_Status
+RM_mem_handler_borrow(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_mem_handler_borrow_timed(
+        void **in_ptr,
+        long in_timeout_ms,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_mem_borrow_at(
+        void **in_ptr,
+        long in_timeout_ms,
+        RM_Bool in_init,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+#define RM_mem_borrow(ptr, uid, init) RM_mem_borrow_at((ptr), 0, (init), (uid), RM_HERE)
+#define RM_mem_borrow_timed(ptr, timeout_ms, uid, init) RM_mem_borrow_at((ptr), (timeout_ms), (init), (uid), RM_HERE)
+
+RM_Status
+RM_mem_give_back_at(
+        void **in_ptr,
+        long in_uid,
+        const char *in_file,
+        unsigned long in_line,
+        const char *in_function);
+
+#define RM_mem_give_back(ptr, uid) RM_mem_give_back_at((ptr), (uid), RM_HERE)
+
+RM_Status
+RM_mem_handler_give_back(
+        void **in_ptr,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+RM_Status
+RM_mem_handler_borrow_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        RM_Bool in_init,
+        ...);
+
+RM_Status
+RM_mem_handler_give_back_many(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+void
+RM_mem_handler_terminate();
+
+void
+RM_mem_handler_wait_stats(
+        RM_WaitStats *out_stats);
+
 #endif //C_PATTERNS_RM_MEM_H
@@ -0,0 +1,388 @@
+/**
+ * Metrics of the resource handlers.
+ *
+ * Each thread accumulates its metrics in its own block of counters (allocated on first use). A counter is only
+ * written by its thread: an update is a plain increment (no lock, no atomic read-modify-write). The counters are
+ * read by `RM_metrics_snapshot()`, which sums the blocks of all the threads. When a thread exits, its counters
+ * are added to RETIRED, and its block is released.
+ *
+ * Histogram buckets: the values below 4 have their own bucket. Above, each power of 2 [2^m, 2^(m+1)) is split
+ * into 4 buckets of equal width: the relative error is at most 25%.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "rm_metrics.h"
+
+#define SUB_BUCKETS_BITS 2
+#define SUB_BUCKETS (1 << SUB_BUCKETS_BITS)
+
+struct Counters {
+    uint64_t borrows[RM_METRICS_TYPES_COUNT];
+    uint64_t give_backs[RM_METRICS_TYPES_COUNT];
+    uint64_t wait[RM_METRICS_TYPES_COUNT][RM_METRICS_BUCKETS];
+    uint64_t hold[RM_METRICS_TYPES_COUNT][RM_METRICS_BUCKETS];
+};
+
+struct ThreadCounters {
+    struct Counters       counters;
+    struct ThreadCounters *next;
+};
+
+static const char *TYPE_NAMES[RM_METRICS_TYPES_COUNT] = { "mem", "file", "conn" };
+
+static int                   LEVEL     = RM_METRICS_COUNTS; // read without the lock
+static struct ThreadCounters *THREADS  = NULL;
+static struct Counters       RETIRED;
+static uint64_t              CAPACITY[RM_METRICS_TYPES_COUNT];
+static uint64_t              BASELINE[RM_METRICS_TYPES_COUNT]; // borrows - give backs when the capacity was set
+static pthread_mutex_t       LOCK      = PTHREAD_MUTEX_INITIALIZER; // THREADS, RETIRED, CAPACITY, BASELINE
+static pthread_key_t         KEY;
+static pthread_once_t        ONCE      = PTHREAD_ONCE_INIT;
+static __thread struct ThreadCounters *THREAD_COUNTERS = NULL;
+
+/**
+ * @brief Add a value to a counter of the calling thread (the only thread that writes it).
+ */
+
+static inline void
+add(
+        uint64_t *in_counter,
+        const uint64_t in_value) {
+    __atomic_store_n(in_counter, __atomic_load_n(in_counter, __ATOMIC_RELAXED) + in_value, __ATOMIC_RELAXED);
+}
+
+static inline size_t
+bucket(const uint64_t in_value) {
+    unsigned msb;
+    size_t index;
+
+    if (in_value < SUB_BUCKETS) return (size_t) in_value;
+    msb = 63u - (unsigned) __builtin_clzll(in_value);
+    index = (size_t)(msb - SUB_BUCKETS_BITS + 1) * SUB_BUCKETS
+            + (size_t)((in_value >> (msb - SUB_BUCKETS_BITS)) & (SUB_BUCKETS - 1));
+    return index < RM_METRICS_BUCKETS ? index : RM_METRICS_BUCKETS - 1;
+}
+
+static void
+merge(
+        struct Counters *in_out_total,
+        const struct Counters *in_counters) {
+    for (int t = 0; t < RM_METRICS_TYPES_COUNT; t++) {
+        in_out_total->borrows[t] += __atomic_load_n(&in_counters->borrows[t], __ATOMIC_RELAXED);
+        in_out_total->give_backs[t] += __atomic_load_n(&in_counters->give_backs[t], __ATOMIC_RELAXED);
+        for (size_t b = 0; b < RM_METRICS_BUCKETS; b++) {
+            in_out_total->wait[t][b] += __atomic_load_n(&in_counters->wait[t][b], __ATOMIC_RELAXED);
+            in_out_total->hold[t][b] += __atomic_load_n(&in_counters->hold[t][b], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Sum the counters of all the threads.
+ * @note The lock must be held.
+ */
+
+static void
+total(struct Counters *out_counters) {
+    *out_counters = RETIRED;
+    for (const struct ThreadCounters *thread = THREADS; NULL != thread; thread = thread->next) {
+        merge(out_counters, &thread->counters);
+    }
+}
+
+static void
+thread_exit(void *in_counters) {
+    struct ThreadCounters *counters = (struct ThreadCounters *) in_counters;
+    struct ThreadCounters **link;
+
+    pthread_mutex_lock(&LOCK);
+    merge(&RETIRED, &counters->counters);
+    for (link = &THREADS; counters != *link; link = &(*link)->next) {}
+    *link = counters->next;
+    pthread_mutex_unlock(&LOCK);
+    free(counters);
+    THREAD_COUNTERS = NULL;
+}
+
+static void
+setup() {
+    pthread_key_create(&KEY, thread_exit);
+}
+
+/**
+ * @brief Return the counters of the calling thread (they are allocated on first use).
+ * @return The counters, or NULL if they cannot be allocated (the metrics of the thread are lost).
+ */
+
+static inline struct Counters *
+counters() {
+    struct ThreadCounters *counters = THREAD_COUNTERS;
+
+    if (NULL != counters) return &counters->counters;
+    counters = (struct ThreadCounters *) calloc(1, sizeof(struct ThreadCounters));
+    if (NULL == counters) return NULL;
+    pthread_once(&ONCE, setup);
+    pthread_setspecific(KEY, counters);
+    pthread_mutex_lock(&LOCK);
+    counters->next = THREADS;
+    THREADS = counters;
+    pthread_mutex_unlock(&LOCK);
+    THREAD_COUNTERS = counters;
+    return &counters->counters;
+}
+
+/**
+ * @brief Set what the handlers measure.
+ * @param in_level The level. The default level is RM_METRICS_COUNTS.
+ * @note The holding time of a resource borrowed before the level is set to RM_METRICS_TIMING is not measured.
+ */
+
+void
+RM_metrics_set_level(const RM_MetricsLevel in_level) {
+    __atomic_store_n(&LEVEL, (int) in_level, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Take a snapshot of the metrics (the sum of the metrics of all the threads).
+ * @param out_metrics The metrics.
+ */
+
+void
+RM_metrics_snapshot(RM_Metrics *out_metrics) {
+    struct Counters *sum = (struct Counters *) malloc(sizeof(struct Counters));
+
+    memset(out_metrics, 0, sizeof(RM_Metrics));
+    if (NULL == sum) return;
+    pthread_mutex_lock(&LOCK);
+    total(sum);
+    for (int t = 0; t < RM_METRICS_TYPES_COUNT; t++) {
+        RM_TypeMetrics *metrics = &out_metrics->types[t];
+        metrics->capacity   = CAPACITY[t];
+        metrics->borrows    = sum->borrows[t];
+        metrics->give_backs = sum->give_backs[t];
+        // The counters of the threads are read one after the other: the difference may be transiently negative.
+        metrics->borrowed   = sum->borrows[t] - sum->give_backs[t] - BASELINE[t];
+        if (metrics->borrowed > UINT64_MAX / 2) metrics->borrowed = 0;
+        metrics->available  = metrics->capacity > metrics->borrowed ? metrics->capacity - metrics->borrowed : 0;
+        memcpy(metrics->wait, sum->wait[t], sizeof(metrics->wait));
+        memcpy(metrics->hold, sum->hold[t], sizeof(metrics->hold));
+    }
+    pthread_mutex_unlock(&LOCK);
+    free(sum);
+}
+
+/**
+ * @brief Return the smallest value that falls into a bucket.
+ * @param in_bucket The index of the bucket.
+ * @return The value.
+ */
+
+uint64_t
+RM_metrics_bucket_floor(const size_t in_bucket) {
+    if (in_bucket < SUB_BUCKETS) return (uint64_t) in_bucket;
+    return (uint64_t)(SUB_BUCKETS + in_bucket % SUB_BUCKETS) << (in_bucket / SUB_BUCKETS - 1);
+}
+
+/**
+ * @brief Return the number of values in a histogram.
+ * @param in_histogram The histogram (RM_METRICS_BUCKETS buckets).
+ * @return The number of values.
+ */
+
+uint64_t
+RM_metrics_count(const uint64_t *in_histogram) {
+    uint64_t count = 0;
+    for (size_t b = 0; b < RM_METRICS_BUCKETS; b++) {
+        count += in_histogram[b];
+    }
+    return count;
+}
+
+/**
+ * @brief Return a percentile of a histogram.
+ * @param in_histogram The histogram (RM_METRICS_BUCKETS buckets).
+ * @param in_percentile The percentile, between 0 and 100 (100: the maximum).
+ * @return The smallest value of the bucket that contains the percentile (0 if the histogram is empty).
+ */
+
+uint64_t
+RM_metrics_percentile(
+        const uint64_t *in_histogram,
+        const double in_percentile) {
+    const uint64_t count = RM_metrics_count(in_histogram);
+    double rank = (double) count * in_percentile / 100.0;
+    uint64_t seen = 0;
+
+    if (0 == count) return 0;
+    if (rank < 1.0) rank = 1.0;
+    for (size_t b = 0; b < RM_METRICS_BUCKETS; b++) {
+        seen += in_histogram[b];
+        if ((double) seen >= rank) return RM_metrics_bucket_floor(b);
+    }
+    return RM_metrics_bucket_floor(RM_METRICS_BUCKETS - 1);
+}
+
+static void
+print_histogram(
+        FILE *in_stream,
+        const char *in_name,
+        const uint64_t *in_histogram,
+        const RM_MetricsFormat in_format) {
+    const double percentiles[] = { 50.0, 90.0, 99.0, 100.0 };
+    const char *names[] = { "p50", "p90", "p99", "max" };
+    int first = 1;
+
+    if (RM_METRICS_JSON == in_format) {
+        fprintf(in_stream, "\"%s\":{\"count\":%llu", in_name, (unsigned long long) RM_metrics_count(in_histogram));
+    } else {
+        fprintf(in_stream, "    %s: count %llu", in_name, (unsigned long long) RM_metrics_count(in_histogram));
+    }
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        fprintf(in_stream,
+                RM_METRICS_JSON == in_format ? ",\"%s\":%llu" : ", %s %llu ns",
+                names[i],
+                (unsigned long long) RM_metrics_percentile(in_histogram, percentiles[i]));
+    }
+    if (RM_METRICS_TEXT == in_format) {
+        fputc('\n', in_stream);
+        return;
+    }
+    // The buckets that are not empty: [smallest value, count].
+    fputs(",\"buckets\":[", in_stream);
+    for (size_t b = 0; b < RM_METRICS_BUCKETS; b++) {
+        if (0 == in_histogram[b]) continue;
+        fprintf(in_stream, "%s[%llu,%llu]", first ? "" : ",",
+                (unsigned long long) RM_metrics_bucket_floor(b), (unsigned long long) in_histogram[b]);
+        first = 0;
+    }
+    fputs("]}", in_stream);
+}
+
+/**
+ * @brief Print metrics.
+ * @param in_metrics The metrics (see `RM_metrics_snapshot()`).
+ * @param in_stream The stream to print into.
+ * @param in_format The format: text (for humans) or JSON (one object per line, keyed by type).
+ */
+
+void
+RM_metrics_print(
+        const RM_Metrics *in_metrics,
+        FILE *in_stream,
+        const RM_MetricsFormat in_format) {
+    if (RM_METRICS_JSON == in_format) fputc('{', in_stream);
+    for (int t = 0; t < RM_METRICS_TYPES_COUNT; t++) {
+        const RM_TypeMetrics *metrics = &in_metrics->types[t];
+        fprintf(in_stream,
+                RM_METRICS_JSON == in_format
+                ? "%s\"%s\":{\"capacity\":%llu,\"borrowed\":%llu,\"available\":%llu,\"borrows\":%llu,\"give_backs\":%llu,"
+                : "%s%s: capacity %llu, borrowed %llu, available %llu, borrows %llu, give backs %llu\n",
+                (RM_METRICS_JSON == in_format) && (t > 0) ? "," : "",
+                TYPE_NAMES[t],
+                (unsigned long long) metrics->capacity,
+                (unsigned long long) metrics->borrowed,
+                (unsigned long long) metrics->available,
+                (unsigned long long) metrics->borrows,
+                (unsigned long long) metrics->give_backs);
+        print_histogram(in_stream, "wait_ns", metrics->wait, in_format);
+        if (RM_METRICS_JSON == in_format) fputc(',', in_stream);
+        print_histogram(in_stream, "hold_ns", metrics->hold, in_format);
+        if (RM_METRICS_JSON == in_format) fputc('}', in_stream);
+    }
+    if (RM_METRICS_JSON == in_format) fputs("}\n", in_stream);
+}
+
+/**
+ * @brief Set the capacity of a type of resources. The resources borrowed before this call are forgotten.
+ * @param in_type The type.
+ * @param in_capacity The capacity (0 if the handler is terminated).
+ * @note This function is called by the handlers, when they are initialized and terminated.
+ */
+
+void
+RM_metrics_capacity(
+        const RM_MetricsType in_type,
+        const size_t in_capacity) {
+    struct Counters *sum = (struct Counters *) malloc(sizeof(struct Counters));
+
+    pthread_mutex_lock(&LOCK);
+    if (NULL != sum) {
+        total(sum);
+        BASELINE[in_type] = sum->borrows[in_type] - sum->give_backs[in_type];
+    }
+    CAPACITY[in_type] = (uint64_t) in_capacity;
+    pthread_mutex_unlock(&LOCK);
+    free(sum);
+}
+
+/**
+ * @brief Record a borrow.
+ * @param in_type The type of the resources.
+ * @param in_count The number of resources borrowed (0: the borrower waited, and gave up).
+ * @param in_wait_ns The time spent waiting for the resources, in nanoseconds.
+ */
+
+void
+RM_metrics_borrow(
+        const RM_MetricsType in_type,
+        const size_t in_count,
+        const uint64_t in_wait_ns) {
+    struct Counters *thread;
+
+    if ((RM_METRICS_OFF == __atomic_load_n(&LEVEL, __ATOMIC_RELAXED)) || (NULL == (thread = counters()))) return;
+    add(&thread->borrows[in_type], (uint64_t) in_count);
+    add(&thread->wait[in_type][bucket(in_wait_ns)], 1);
+}
+
+/**
+ * @brief Record a give back.
+ * @param in_type The type of the resources.
+ * @param in_count The number of resources given back.
+ */
+
+void
+RM_metrics_give_back(
+        const RM_MetricsType in_type,
+        const size_t in_count) {
+    struct Counters *thread;
+
+    if ((RM_METRICS_OFF == __atomic_load_n(&LEVEL, __ATOMIC_RELAXED)) || (NULL == (thread = counters()))) return;
+    add(&thread->give_backs[in_type], (uint64_t) in_count);
+}
+
+/**
+ * @brief Read the clock used to measure the holding times.
+ * @return The time, in nanoseconds, if the level is RM_METRICS_TIMING. Otherwise: 0 (the clock is not read).
+ * @note The handlers store this value when a resource is borrowed, and give it to `RM_metrics_hold()` when the
+ * resource is given back.
+ */
+
+int64_t
+RM_metrics_clock() {
+    struct timespec ts;
+
+    if (RM_METRICS_TIMING != __atomic_load_n(&LEVEL, __ATOMIC_RELAXED)) return 0;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Record the holding time of a resource.
+ * @param in_type The type of the resource.
+ * @param in_since_ns The time when the resource was borrowed (see `RM_metrics_clock()`). If 0, then nothing is
+ * recorded.
+ */
+
+void
+RM_metrics_hold(
+        const RM_MetricsType in_type,
+        const int64_t in_since_ns) {
+    struct Counters *thread;
+    int64_t now;
+
+    if ((0 == in_since_ns) || (0 == (now = RM_metrics_clock())) || (NULL == (thread = counters()))) return;
+    add(&thread->hold[in_type][bucket(now > in_since_ns ? (uint64_t)(now - in_since_ns) : 0)], 1);
+}
@@ -0,0 +1,118 @@
+#ifndef C_PATTERNS_RM_METRICS_H
+#define C_PATTERNS_RM_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "resource_manager.h"
+
+// Metrics of the resource handlers: utilisation of the pools, and histograms of the waiting and holding times.
+//
+//      RM_metrics_set_level(RM_METRICS_TIMING); // also measure how long the resources are held
+//      ...
+//      RM_Metrics metrics;
+//      RM_metrics_snapshot(&metrics);
+//      RM_metrics_print(&metrics, stdout, RM_METRICS_JSON);
+//      printf("p99 hold: %llu ns\n",
+//             (unsigned long long) RM_metrics_percentile(metrics.types[RM_METRICS_MEM].hold, 99.0));
+//
+// The handlers accumulate the metrics per thread, without lock; a snapshot merges the accumulators of all the
+// threads. The times are given in nanoseconds.
+
+// The histograms are log-linear: 4 buckets per power of 2. The last bucket also holds all the larger values
+// (above half an hour).
+#define RM_METRICS_BUCKETS 160
+
+enum RM_EnumMetricsType {
+    RM_METRICS_MEM,
+    RM_METRICS_FILE,
+    RM_METRICS_CONN,
+    RM_METRICS_TYPES_COUNT
+};
+
+typedef enum RM_EnumMetricsType RM_MetricsType;
+
+enum RM_EnumMetricsLevel {
+    RM_METRICS_OFF,
+    RM_METRICS_COUNTS, // default: counters and waiting times (only the waits that block read the clock)
+    RM_METRICS_TIMING  // also the holding times (the clock is read when a resource is borrowed and given back)
+};
+
+typedef enum RM_EnumMetricsLevel RM_MetricsLevel;
+
+enum RM_EnumMetricsFormat { RM_METRICS_TEXT, RM_METRICS_JSON };
+
+typedef enum RM_EnumMetricsFormat RM_MetricsFormat;
+
+struct RM_StructTypeMetrics {
+    uint64_t capacity;   // maximum number of resources borrowed at the same time
+    uint64_t borrowed;   // number of resources borrowed now
+    uint64_t available;  // capacity - borrowed
+    uint64_t borrows;    // number of resources borrowed since the process started
+    uint64_t give_backs;
+    uint64_t wait[RM_METRICS_BUCKETS]; // one sample per call to borrow (0 if it did not wait), timeouts included
+    uint64_t hold[RM_METRICS_BUCKETS]; // one sample per resource given back (RM_METRICS_TIMING only)
+};
+
+typedef struct RM_StructTypeMetrics RM_TypeMetrics;
+
+struct RM_StructMetrics {
+    RM_TypeMetrics types[RM_METRICS_TYPES_COUNT];
+};
+
+typedef struct RM_StructMetrics RM_Metrics;
+
+void
+RM_metrics_set_level(
+        RM_MetricsLevel in_level);
+
+void
+RM_metrics_snapshot(
+        RM_Metrics *out_metrics);
+
+uint64_t
+RM_metrics_bucket_floor(
+        size_t in_bucket);
+
+uint64_t
+RM_metrics_count(
+        const uint64_t *in_histogram);
+
+uint64_t
+RM_metrics_percentile(
+        const uint64_t *in_histogram,
+        double in_percentile);
+
+void
+RM_metrics_print(
+        const RM_Metrics *in_metrics,
+        FILE *in_stream,
+        RM_MetricsFormat in_format);
+
+// Called by the resource handlers.
+
+void
+RM_metrics_capacity(
+        RM_MetricsType in_type,
+        size_t in_capacity);
+
+void
+RM_metrics_borrow(
+        RM_MetricsType in_type,
+        size_t in_count,
+        uint64_t in_wait_ns);
+
+void
+RM_metrics_give_back(
+        RM_MetricsType in_type,
+        size_t in_count);
+
+int64_t
+RM_metrics_clock();
+
+void
+RM_metrics_hold(
+        RM_MetricsType in_type,
+        int64_t in_since_ns);
+
+#endif //C_PATTERNS_RM_METRICS_H
@@ -0,0 +1,433 @@
+/**
+ * A lock-free pool of preallocated objects.
+ *
+ * The free objects are kept in a stack (a "Treiber stack"): popping and pushing an object is a single
+ * compare-and-swap on the head of the stack.
+ *
+ * The links between the free objects are stored in a separate array of indexes (`next`), so that the objects
+ * themselves are never written by the pool.
+ *
+ * The ABA problem: thread 1 reads head = A (next = B), and is interrupted. Thread 2 pops A, pops B, and pushes A.
+ * Thread 1 resumes: its compare-and-swap succeeds (the head is A again), and sets the head to B, which is not
+ * free! To prevent this, the head contains a tag which is incremented by each update: thread 1 sees that the
+ * tag has changed, and its compare-and-swap fails.
+ *
+ *      head (64 bits) = | tag (32 bits) | index of the first free object + 1 (32 bits) |
+ *
+ * A batch of N objects is popped (or pushed) as a chain, by a single compare-and-swap too.
+ *
+ * Each object also has a "taken" flag, so that an object pushed twice (given back twice) is detected instead of
+ * corrupting the stack.
+ *
+ * A magazine (see `RM_magazine_pop()`) is a small stack of objects owned by a single thread, in front of the
+ * pool: the objects are borrowed from, and given back to, the magazine without touching the shared head. The
+ * magazine exchanges batches of objects with the pool (a single compare-and-swap per batch). It holds at most
+ * two batches: when it is empty, a batch is taken from the pool; when it is full, a batch is put back. A thread
+ * that alternates borrow and give back never touches the pool.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "rm_pool.h"
+
+#define INDEX_MASK ((uint64_t)0xFFFFFFFF)
+#define TAG_UNIT   ((uint64_t)1 << 32)
+
+static inline size_t
+index_of(
+        const RM_Pool *in_pool,
+        const void *in_object) {
+    return (size_t)((const unsigned char *) in_object - in_pool->objects) / in_pool->stride;
+}
+
+/**
+ * @brief Change the state of an object (see `RM_StructPool.taken`), if it is in the expected state.
+ * @return If the object was in the expected state: 1. Otherwise: 0.
+ */
+
+static inline int
+change_state(
+        RM_Pool *in_pool,
+        const size_t in_index,
+        unsigned char in_expected,
+        const unsigned char in_state) {
+    return __atomic_compare_exchange_n(&in_pool->taken[in_index], &in_expected, in_state, 0,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Initialize the fields of a pool, so that `RM_pool_terminate()` can be called safely.
+ * @param in_pool The pool.
+ */
+
+void
+RM_pool_clear(RM_Pool *in_pool) {
+    in_pool->head        = 0;
+    in_pool->next        = NULL;
+    in_pool->taken       = NULL;
+    in_pool->objects     = NULL;
+    in_pool->object_size = 0;
+    in_pool->stride      = RM_POOL_ALIGNMENT;
+    in_pool->capacity    = 0;
+}
+
+/**
+ * @brief Allocate the objects of a pool. All the objects are free.
+ * @param in_pool The pool.
+ * @param in_object_size The size of an object, in bytes.
+ * @param in_capacity The number of objects.
+ * @return On success: RM_success. Otherwise: RM_failure.
+ */
+
+RM_Status
+RM_pool_init(
+        RM_Pool *in_pool,
+        const size_t in_object_size,
+        const size_t in_capacity) {
+    const size_t stride = in_object_size > 0
+            ? (in_object_size + RM_POOL_ALIGNMENT - 1) / RM_POOL_ALIGNMENT * RM_POOL_ALIGNMENT
+            : RM_POOL_ALIGNMENT;
+
+    RM_pool_clear(in_pool);
+    if (0 == in_capacity) return RM_success;
+    if ((in_capacity >= INDEX_MASK) || (in_capacity > SIZE_MAX / stride)) return RM_failure;
+
+    in_pool->objects = (unsigned char *) malloc(in_capacity * stride);
+    in_pool->next    = (uint32_t *) malloc(in_capacity * sizeof(uint32_t));
+    in_pool->taken   = (unsigned char *) calloc(in_capacity, 1);
+    if ((NULL == in_pool->objects) || (NULL == in_pool->next) || (NULL == in_pool->taken)) {
+        RM_pool_terminate(in_pool);
+        return RM_failure;
+    }
+    // The object 0 is on the top of the stack.
+    for (size_t i = 0; i < in_capacity; i++) {
+        in_pool->next[i] = i + 1 < in_capacity ? (uint32_t)(i + 2) : 0;
+    }
+    in_pool->object_size = in_object_size;
+    in_pool->stride      = stride;
+    in_pool->capacity    = in_capacity;
+    __atomic_store_n(&in_pool->head, (uint64_t)1, __ATOMIC_RELEASE);
+    return RM_success;
+}
+
+/**
+ * @brief Take an object from the pool.
+ * @param in_pool The pool.
+ * @return The object, or NULL if all the objects are taken.
+ */
+
+void *
+RM_pool_pop(RM_Pool *in_pool) {
+    uint64_t head = __atomic_load_n(&in_pool->head, __ATOMIC_ACQUIRE);
+    uint64_t index;
+
+    for (;;) {
+        uint64_t next;
+
+        index = head & INDEX_MASK;
+        if (0 == index) return NULL;
+        // `next[index - 1]` may be modified by another thread (if the object has been popped meanwhile). In this
+        // case, the tag has changed too, and the compare-and-swap fails.
+        next = __atomic_load_n(&in_pool->next[index - 1], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&in_pool->head,
+                                        &head,
+                                        ((head & ~INDEX_MASK) + TAG_UNIT) | next,
+                                        1,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+    __atomic_store_n(&in_pool->taken[index - 1], RM_POOL_TAKEN, __ATOMIC_RELAXED);
+    return in_pool->objects + (size_t)(index - 1) * in_pool->stride;
+}
+
+/**
+ * @brief Tell whether an object belongs to a pool.
+ * @param in_pool The pool.
+ * @param in_object The object.
+ * @return If the object belongs to the pool: RM_true. Otherwise: RM_false.
+ */
+
+RM_Bool
+RM_pool_contains(
+        const RM_Pool *in_pool,
+        const void *in_object) {
+    const unsigned char *object = (const unsigned char *) in_object;
+    if ((NULL == in_pool->objects) || (object < in_pool->objects)) return RM_false;
+    if (object >= in_pool->objects + in_pool->capacity * in_pool->stride) return RM_false;
+    return 0 == (size_t)(object - in_pool->objects) % in_pool->stride ? RM_true : RM_false;
+}
+
+/**
+ * @brief Put an object back into the pool.
+ * @param in_pool The pool.
+ * @param in_object The object.
+ * @return On success: RM_success. Otherwise (the object does not belong to the pool, or it is already in the
+ * pool): RM_failure.
+ */
+
+RM_Status
+RM_pool_push(
+        RM_Pool *in_pool,
+        void *in_object) {
+    uint64_t index;
+    uint64_t head;
+
+    if (RM_false == RM_pool_contains(in_pool, in_object)) return RM_failure;
+    index = (uint64_t)((size_t)((unsigned char *) in_object - in_pool->objects) / in_pool->stride) + 1;
+    if (! change_state(in_pool, (size_t) index - 1, RM_POOL_TAKEN, RM_POOL_FREE)) return RM_failure;
+
+    head = __atomic_load_n(&in_pool->head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&in_pool->next[index - 1], (uint32_t)(head & INDEX_MASK), __ATOMIC_RELAXED);
+    } while (! __atomic_compare_exchange_n(&in_pool->head,
+                                           &head,
+                                           ((head & ~INDEX_MASK) + TAG_UNIT) | index,
+                                           1,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED));
+    return RM_success;
+}
+
+/**
+ * @brief Take several objects from the pool, in a single atomic operation.
+ * @param in_pool The pool.
+ * @param out_objects An array of `in_count` pointers that will be assigned to the objects.
+ * @param in_count The number of objects to take.
+ * @return If `in_count` objects are free: RM_success. Otherwise, no object is taken (and the pointers are set to
+ * NULL): RM_failure.
+ */
+
+RM_Status
+RM_pool_pop_many(
+        RM_Pool *in_pool,
+        void **out_objects,
+        const size_t in_count) {
+    uint64_t head = __atomic_load_n(&in_pool->head, __ATOMIC_ACQUIRE);
+
+    if (0 == in_count) return RM_success;
+    for (;;) {
+        uint64_t index = head & INDEX_MASK;
+        size_t n;
+
+        // Walk down the chain of the first `in_count` free objects. As for `RM_pool_pop()`, the links may be
+        // modified meanwhile: in this case, the compare-and-swap fails.
+        for (n = 0; (n < in_count) && (0 != index); n++) {
+            out_objects[n] = in_pool->objects + (size_t)(index - 1) * in_pool->stride;
+            index = __atomic_load_n(&in_pool->next[index - 1], __ATOMIC_RELAXED);
+        }
+        if (n < in_count) {
+            uint64_t current = __atomic_load_n(&in_pool->head, __ATOMIC_ACQUIRE);
+            if (current != head) { // the chain may be longer now
+                head = current;
+                continue;
+            }
+            for (n = 0; n < in_count; n++) {
+                out_objects[n] = NULL;
+            }
+            return RM_failure;
+        }
+        if (__atomic_compare_exchange_n(&in_pool->head,
+                                        &head,
+                                        ((head & ~INDEX_MASK) + TAG_UNIT) | index,
+                                        1,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_ACQUIRE)) {
+            break;
+        }
+    }
+    for (size_t n = 0; n < in_count; n++) {
+        const size_t index = (size_t)((unsigned char *) out_objects[n] - in_pool->objects) / in_pool->stride;
+        __atomic_store_n(&in_pool->taken[index], RM_POOL_TAKEN, __ATOMIC_RELAXED);
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Put several objects back into the pool, in a single atomic operation.
+ * @param in_pool The pool.
+ * @param in_objects An array of `in_count` objects. The NULL pointers are ignored.
+ * @param in_count The number of pointers in the array.
+ * @return On success: RM_success. Otherwise (an object does not belong to the pool, or it is already in the
+ * pool, or it appears twice), no object is put back: RM_failure.
+ */
+
+RM_Status
+RM_pool_push_many(
+        RM_Pool *in_pool,
+        void **in_objects,
+        const size_t in_count) {
+    uint64_t first = 0;
+    uint64_t last = 0;
+    uint64_t head;
+    size_t n;
+
+    // Link the objects together, before publishing the whole chain.
+    for (n = 0; n < in_count; n++) {
+        uint64_t index;
+
+        if (NULL == in_objects[n]) continue;
+        if (RM_false == RM_pool_contains(in_pool, in_objects[n])) break;
+        index = (uint64_t)((size_t)((unsigned char *) in_objects[n] - in_pool->objects) / in_pool->stride) + 1;
+        if (! change_state(in_pool, (size_t) index - 1, RM_POOL_TAKEN, RM_POOL_FREE)) break;
+        if (0 == first) first = index;
+        else __atomic_store_n(&in_pool->next[last - 1], (uint32_t) index, __ATOMIC_RELAXED);
+        last = index;
+    }
+    if (n < in_count) {
+        for (size_t k = 0; k < n; k++) {
+            size_t index;
+            if (NULL == in_objects[k]) continue;
+            index = (size_t)((unsigned char *) in_objects[k] - in_pool->objects) / in_pool->stride;
+            __atomic_store_n(&in_pool->taken[index], RM_POOL_TAKEN, __ATOMIC_RELAXED);
+        }
+        return RM_failure;
+    }
+    if (0 == first) return RM_success;
+
+    head = __atomic_load_n(&in_pool->head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n(&in_pool->next[last - 1], (uint32_t)(head & INDEX_MASK), __ATOMIC_RELAXED);
+    } while (! __atomic_compare_exchange_n(&in_pool->head,
+                                           &head,
+                                           ((head & ~INDEX_MASK) + TAG_UNIT) | first,
+                                           1,
+                                           __ATOMIC_RELEASE,
+                                           __ATOMIC_RELAXED));
+    return RM_success;
+}
+
+/**
+ * @brief Release the objects of a pool.
+ * @param in_pool The pool.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_pool_terminate(RM_Pool *in_pool) {
+    free(in_pool->objects);
+    free(in_pool->next);
+    free(in_pool->taken);
+    RM_pool_clear(in_pool);
+}
+
+/**
+ * @brief Initialize an empty magazine.
+ * @param in_magazine The magazine.
+ * @param in_batch_size The number of objects exchanged with the pool at once. The magazine holds at most twice
+ * this number of objects.
+ * @return On success: RM_success. Otherwise: RM_failure.
+ */
+
+RM_Status
+RM_magazine_init(
+        RM_Magazine *in_magazine,
+        const size_t in_batch_size) {
+    in_magazine->count    = 0;
+    in_magazine->capacity = 0;
+    in_magazine->objects  = NULL;
+    if (0 == in_batch_size) return RM_failure;
+    in_magazine->objects = (void **) malloc(2 * in_batch_size * sizeof(void *));
+    if (NULL == in_magazine->objects) return RM_failure;
+    in_magazine->capacity = 2 * in_batch_size;
+    return RM_success;
+}
+
+/**
+ * @brief Take an object from a magazine. If the magazine is empty, then it is refilled from the pool.
+ * @param in_pool The pool.
+ * @param in_magazine The magazine (owned by the calling thread).
+ * @return The object, or NULL if all the objects are taken.
+ * @note If the pool holds less objects than a batch, then a single object is taken from the pool.
+ */
+
+void *
+RM_magazine_pop(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine) {
+    void *object;
+
+    if (0 == in_magazine->count) {
+        const size_t batch = in_magazine->capacity / 2;
+        if (RM_failure == RM_pool_pop_many(in_pool, in_magazine->objects, batch)) return RM_pool_pop(in_pool);
+        for (size_t i = 0; i < batch; i++) {
+            __atomic_store_n(&in_pool->taken[index_of(in_pool, in_magazine->objects[i])], RM_POOL_CACHED,
+                             __ATOMIC_RELAXED);
+        }
+        in_magazine->count = batch;
+    }
+    object = in_magazine->objects[--in_magazine->count];
+    __atomic_store_n(&in_pool->taken[index_of(in_pool, object)], RM_POOL_TAKEN, __ATOMIC_RELAXED);
+    return object;
+}
+
+/**
+ * @brief Put the oldest `in_count` objects of a magazine back into the pool.
+ */
+
+static void
+magazine_flush(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine,
+        const size_t in_count) {
+    for (size_t i = 0; i < in_count; i++) {
+        __atomic_store_n(&in_pool->taken[index_of(in_pool, in_magazine->objects[i])], RM_POOL_TAKEN,
+                         __ATOMIC_RELAXED);
+    }
+    RM_pool_push_many(in_pool, in_magazine->objects, in_count);
+    in_magazine->count -= in_count;
+    memmove(in_magazine->objects, in_magazine->objects + in_count, in_magazine->count * sizeof(void *));
+}
+
+/**
+ * @brief Put an object into a magazine. If the magazine is full, then a batch is put back into the pool first.
+ * @param in_pool The pool.
+ * @param in_magazine The magazine (owned by the calling thread).
+ * @param in_object The object.
+ * @return On success: RM_success. Otherwise (the object does not belong to the pool, or it is not taken): RM_failure.
+ */
+
+RM_Status
+RM_magazine_push(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine,
+        void *in_object) {
+    if ((RM_false == RM_pool_contains(in_pool, in_object))
+        || (! change_state(in_pool, index_of(in_pool, in_object), RM_POOL_TAKEN, RM_POOL_CACHED))) {
+        return RM_failure;
+    }
+    if (in_magazine->count == in_magazine->capacity) magazine_flush(in_pool, in_magazine, in_magazine->capacity / 2);
+    in_magazine->objects[in_magazine->count++] = in_object;
+    return RM_success;
+}
+
+/**
+ * @brief Put all the objects of a magazine back into the pool.
+ * @param in_pool The pool.
+ * @param in_magazine The magazine (owned by the calling thread).
+ * @return The number of objects put back.
+ */
+
+size_t
+RM_magazine_drain(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine) {
+    const size_t count = in_magazine->count;
+    if (count > 0) magazine_flush(in_pool, in_magazine, count);
+    return count;
+}
+
+/**
+ * @brief Release a magazine. The objects it holds are forgotten (see `RM_magazine_drain()`).
+ * @param in_magazine The magazine.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_magazine_terminate(RM_Magazine *in_magazine) {
+    free(in_magazine->objects);
+    in_magazine->objects  = NULL;
+    in_magazine->count    = 0;
+    in_magazine->capacity = 0;
+}
@@ -0,0 +1,124 @@
+#ifndef C_PATTERNS_RM_POOL_H
+#define C_PATTERNS_RM_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "resource_manager.h"
+
+// A pool of preallocated objects of a fixed size, shared by threads without lock.
+// This is the building block of the resource handlers (see "rm_mem.c").
+//
+//      RM_Pool pool;
+//      RM_pool_init(&pool, 4096, 64);
+//      void *object = RM_pool_pop(&pool); // NULL if all the objects are taken
+//      ...
+//      RM_pool_push(&pool, object);
+//      void *objects[8];
+//      RM_pool_pop_many(&pool, objects, 8); // all or nothing, in a single atomic operation
+//      ...
+//      RM_pool_push_many(&pool, objects, 8);
+//      RM_pool_terminate(&pool);
+//
+// A magazine is a per-thread cache in front of the pool: it exchanges batches of objects with the pool.
+//
+//      RM_Magazine magazine; // one per thread
+//      RM_magazine_init(&magazine, 16);
+//      void *object = RM_magazine_pop(&pool, &magazine);
+//      RM_magazine_push(&pool, &magazine, object);
+//      RM_magazine_drain(&pool, &magazine); // when the thread exits
+//      RM_magazine_terminate(&magazine);
+
+// The objects are aligned on this value (suitable for any type).
+#define RM_POOL_ALIGNMENT 16
+
+// The states of an object (see `RM_StructPool.taken`).
+#define RM_POOL_FREE   0 // in the pool
+#define RM_POOL_TAKEN  1 // borrowed
+#define RM_POOL_CACHED 2 // in a magazine
+
+struct RM_StructPool {
+    uint64_t      head;        // (tag << 32) | (index of the first free object + 1). 0 (index part): empty.
+    uint32_t      *next;       // next[i]: index of the free object that follows the object i (+ 1)
+    unsigned char *taken;      // taken[i]: the state of the object i (RM_POOL_FREE, RM_POOL_TAKEN...)
+    unsigned char *objects;
+    size_t        object_size;
+    size_t        stride;      // object_size rounded up to RM_POOL_ALIGNMENT
+    size_t        capacity;
+};
+
+typedef struct RM_StructPool RM_Pool;
+
+struct RM_StructMagazine {
+    void   **objects;
+    size_t count;
+    size_t capacity; // 2 batches
+};
+
+typedef struct RM_StructMagazine RM_Magazine;
+
+void
+RM_pool_clear(
+        RM_Pool *in_pool);
+
+RM_Status
+RM_pool_init(
+        RM_Pool *in_pool,
+        size_t in_object_size,
+        size_t in_capacity);
+
+void *
+RM_pool_pop(
+        RM_Pool *in_pool);
+
+RM_Status
+RM_pool_push(
+        RM_Pool *in_pool,
+        void *in_object);
+
+RM_Status
+RM_pool_pop_many(
+        RM_Pool *in_pool,
+        void **out_objects,
+        size_t in_count);
+
+RM_Status
+RM_pool_push_many(
+        RM_Pool *in_pool,
+        void **in_objects,
+        size_t in_count);
+
+RM_Bool
+RM_pool_contains(
+        const RM_Pool *in_pool,
+        const void *in_object);
+
+void
+RM_pool_terminate(
+        RM_Pool *in_pool);
+
+RM_Status
+RM_magazine_init(
+        RM_Magazine *in_magazine,
+        size_t in_batch_size);
+
+void *
+RM_magazine_pop(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine);
+
+RM_Status
+RM_magazine_push(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine,
+        void *in_object);
+
+size_t
+RM_magazine_drain(
+        RM_Pool *in_pool,
+        RM_Magazine *in_magazine);
+
+void
+RM_magazine_terminate(
+        RM_Magazine *in_magazine);
+
+#endif //C_PATTERNS_RM_POOL_H
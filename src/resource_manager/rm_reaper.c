@@ -0,0 +1,205 @@
+/**
+ * Background reaper: a thread that periodically calls the reap functions registered by the resource handlers
+ * (see `RM_PoolPolicy`), so that the idle resources are closed off the path of the borrowers.
+ *
+ * The handlers register their functions (reap, and optionally warm-up) when they are initialized, and unregister
+ * them when they are terminated. `RM_init()` calls the warm-up functions (see `RM_reaper_prewarm()`).
+ * The functions are called without holding the lock of the reaper: a function may be called once after it has
+ * been unregistered (the handlers check that they are initialized).
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "rm_reaper.h"
+
+static RM_ReapFunction    FUNCTIONS[RM_REAPER_CAPACITY];
+static RM_PrewarmFunction PREWARM_FUNCTIONS[RM_REAPER_CAPACITY]; // NULL: the handler has no warm-up
+static size_t             FUNCTIONS_COUNT = 0;
+static pthread_mutex_t    LOCK            = PTHREAD_MUTEX_INITIALIZER; // protects all the variables below
+static pthread_once_t     CONDITION_ONCE  = PTHREAD_ONCE_INIT;
+static pthread_cond_t     CONDITION; // signaled to stop the thread
+static pthread_t          THREAD;
+static int                RUNNING         = 0;
+static unsigned long      PERIOD_MS       = 0;
+
+static void
+init_condition() {
+    pthread_condattr_t attributes;
+
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&CONDITION, &attributes);
+    pthread_condattr_destroy(&attributes);
+}
+
+/**
+ * @brief Call the registered functions.
+ * @note The lock must not be held.
+ */
+
+static void
+reap() {
+    RM_ReapFunction functions[RM_REAPER_CAPACITY];
+    size_t count;
+
+    pthread_mutex_lock(&LOCK);
+    count = FUNCTIONS_COUNT;
+    for (size_t i = 0; i < count; i++) {
+        functions[i] = FUNCTIONS[i];
+    }
+    pthread_mutex_unlock(&LOCK);
+    for (size_t i = 0; i < count; i++) {
+        functions[i]();
+    }
+}
+
+static void *
+run(void *in_unused) {
+    (void) in_unused;
+    pthread_mutex_lock(&LOCK);
+    while (RUNNING) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += (time_t)(PERIOD_MS / 1000);
+        deadline.tv_nsec += (long)(PERIOD_MS % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+        while (RUNNING && (ETIMEDOUT != pthread_cond_timedwait(&CONDITION, &LOCK, &deadline))) {}
+        if (! RUNNING) break;
+        pthread_mutex_unlock(&LOCK);
+        reap();
+        pthread_mutex_lock(&LOCK);
+    }
+    pthread_mutex_unlock(&LOCK);
+    return NULL;
+}
+
+/**
+ * @brief Add a function to the list of functions called by the reaper.
+ * @param in_function The function.
+ * @param in_prewarm The warm-up function of the handler, called by `RM_reaper_prewarm()`. May be NULL.
+ * @return On success (or if the function is already registered): RM_success. Otherwise (the list is full):
+ * RM_failure.
+ */
+
+RM_Status
+RM_reaper_register(
+        RM_ReapFunction in_function,
+        RM_PrewarmFunction in_prewarm) {
+    RM_Status status = RM_success;
+
+    pthread_mutex_lock(&LOCK);
+    for (size_t i = 0; i < FUNCTIONS_COUNT; i++) {
+        if (in_function == FUNCTIONS[i]) {
+            pthread_mutex_unlock(&LOCK);
+            return RM_success;
+        }
+    }
+    if (FUNCTIONS_COUNT < RM_REAPER_CAPACITY) {
+        PREWARM_FUNCTIONS[FUNCTIONS_COUNT] = in_prewarm;
+        FUNCTIONS[FUNCTIONS_COUNT++] = in_function;
+    } else {
+        status = RM_failure;
+    }
+    pthread_mutex_unlock(&LOCK);
+    return status;
+}
+
+/**
+ * @brief Remove a function from the list of functions called by the reaper.
+ * @param in_function The function.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_reaper_unregister(RM_ReapFunction in_function) {
+    pthread_mutex_lock(&LOCK);
+    for (size_t i = 0; i < FUNCTIONS_COUNT; i++) {
+        if (in_function == FUNCTIONS[i]) {
+            FUNCTIONS_COUNT--;
+            FUNCTIONS[i] = FUNCTIONS[FUNCTIONS_COUNT];
+            PREWARM_FUNCTIONS[i] = PREWARM_FUNCTIONS[FUNCTIONS_COUNT];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&LOCK);
+}
+
+/**
+ * @brief Call the registered functions now, in the calling thread.
+ */
+
+void
+RM_reaper_run() {
+    reap();
+}
+
+/**
+ * @brief Call the registered warm-up functions now, in the calling thread: each handler opens its resources again,
+ * up to its `prewarm_size` (see `RM_PoolPolicy`).
+ * @return If all the functions succeeded: RM_success. Otherwise (a resource could not be opened): RM_failure.
+ * @note This function is called by `RM_init()`.
+ */
+
+RM_Status
+RM_reaper_prewarm() {
+    RM_PrewarmFunction functions[RM_REAPER_CAPACITY];
+    size_t count = 0;
+    RM_Status status = RM_success;
+
+    pthread_mutex_lock(&LOCK);
+    for (size_t i = 0; i < FUNCTIONS_COUNT; i++) {
+        if (NULL != PREWARM_FUNCTIONS[i]) functions[count++] = PREWARM_FUNCTIONS[i];
+    }
+    pthread_mutex_unlock(&LOCK);
+    for (size_t i = 0; i < count; i++) {
+        if (RM_failure == functions[i]()) status = RM_failure;
+    }
+    return status;
+}
+
+/**
+ * @brief Start the background thread that calls the registered functions.
+ * @param in_period_ms The time between two rounds, in milliseconds.
+ * @return On success: RM_success. Otherwise (the thread is already running, the period is 0, or the thread could
+ * not be created): RM_failure.
+ */
+
+RM_Status
+RM_reaper_start(const unsigned long in_period_ms) {
+    pthread_once(&CONDITION_ONCE, init_condition);
+    pthread_mutex_lock(&LOCK);
+    if (RUNNING || (0 == in_period_ms)) {
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    PERIOD_MS = in_period_ms;
+    RUNNING = 1;
+    if (0 != pthread_create(&THREAD, NULL, run, NULL)) {
+        RUNNING = 0;
+        pthread_mutex_unlock(&LOCK);
+        return RM_failure;
+    }
+    pthread_mutex_unlock(&LOCK);
+    return RM_success;
+}
+
+/**
+ * @brief Stop the background thread, and wait for it.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_reaper_stop() {
+    int running;
+
+    pthread_mutex_lock(&LOCK);
+    running = RUNNING;
+    RUNNING = 0;
+    if (running) pthread_cond_signal(&CONDITION);
+    pthread_mutex_unlock(&LOCK);
+    if (running) pthread_join(THREAD, NULL);
+}
@@ -0,0 +1,69 @@
+#ifndef C_PATTERNS_RM_REAPER_H
+#define C_PATTERNS_RM_REAPER_H
+
+#include <stddef.h>
+#include "resource_manager.h"
+
+// Elastic pools: the handlers that keep resources open (connections, file descriptors) open them on demand, up to
+// their capacity, and close the resources that stay idle too long, down to a minimum. The policy is set per
+// handler:
+//
+//      RM_PoolPolicy policy = { 2, 4, 60000 }; // keep 2 connections, open 4 at init, close the others after 60 s
+//      RM_conn_handler_set_policy(&policy);
+//      RM_conn_handler_init(0, 16);            // at most 16 connections, 4 are opened now (warm-up)
+//      RM_reaper_start(1000);                  // look for idle resources every second, in a background thread
+//      ...
+//      RM_init(-1, 0, NULL);                   // open the connections closed by the reaper again, up to 4
+//      ...
+//      RM_reaper_stop();
+//
+// Without the background thread, the idle resources are closed by the calls to `give_back()` (one resource per
+// call). The calls to `borrow()` never close a resource.
+//
+// The warm-up happens when a handler is initialized, and again when `RM_init()` is called (for the handlers
+// that are initialized): each handler registers its warm-up function along with its reap function.
+//
+// The policy applies to the connection handler ("rm_conn.h") and to the file handler ("rm_file.h", which has no
+// warm-up: the paths are not known in advance). The memory handler ("rm_mem.h") has no policy: its buffers are
+// allocated once, by `RM_mem_handler_init()`, and they are never reaped.
+
+struct RM_StructPoolPolicy {
+    size_t        min_size;     // the number of resources kept open, even if they are idle
+    size_t        prewarm_size; // the number of resources opened by the init of the handler, and by `RM_init()`
+    unsigned long idle_ttl_ms;  // the duration after which an idle resource is closed (0: never)
+};
+
+typedef struct RM_StructPoolPolicy RM_PoolPolicy;
+
+// A function that closes the idle resources of a handler. It must be thread safe.
+typedef void (*RM_ReapFunction)();
+
+// A function that opens the resources of a handler, up to its `prewarm_size`. It must be thread safe.
+typedef RM_Status (*RM_PrewarmFunction)();
+
+// The maximum number of functions called by the reaper.
+#define RM_REAPER_CAPACITY 8
+
+RM_Status
+RM_reaper_register(
+        RM_ReapFunction in_function,
+        RM_PrewarmFunction in_prewarm);
+
+void
+RM_reaper_unregister(
+        RM_ReapFunction in_function);
+
+void
+RM_reaper_run();
+
+RM_Status
+RM_reaper_prewarm();
+
+RM_Status
+RM_reaper_start(
+        unsigned long in_period_ms);
+
+void
+RM_reaper_stop();
+
+#endif //C_PATTERNS_RM_REAPER_H
@@ -0,0 +1,248 @@
+/**
+ * Buffered writer for the report file.
+ *
+ * The report file is opened once (by `RM_init()`), in append mode. Each thread appends its records to its own
+ * buffer, without contention. A buffer is written into the file:
+ * - when it cannot hold the next record,
+ * - when a record is added more than RM_REPORT_FLUSH_INTERVAL_MS milliseconds after the last write (there is no
+ *   background thread: the records of an idle thread stay in its buffer until one of the following events),
+ * - when the thread exits (destructor of a thread-specific key),
+ * - when `RM_report_flush()` is called: when the process exits, and when the report file is changed.
+ *
+ * Locks (always taken in this order): BUFFERS_LOCK (the list of buffers), the lock of a buffer (taken by its
+ * thread when it adds a record, and by the functions that flush all the buffers), FILE_LOCK (the descriptor).
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "rm_report.h"
+
+struct Buffer {
+    pthread_mutex_t lock;
+    char            data[RM_REPORT_BUFFER_CAPACITY];
+    size_t          length;
+    int64_t         last_flush_ns;
+    struct Buffer   *next;
+};
+
+static int             FD            = -1; // read without the lock
+static char            *PATH         = NULL;
+static pthread_mutex_t FILE_LOCK     = PTHREAD_MUTEX_INITIALIZER;
+static struct Buffer   *BUFFERS      = NULL;
+static pthread_mutex_t BUFFERS_LOCK  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t   KEY;
+static pthread_once_t  ONCE          = PTHREAD_ONCE_INIT;
+static __thread struct Buffer *THREAD_BUFFER = NULL;
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Write data into the report file.
+ * @note The lock FILE_LOCK must be held.
+ */
+
+static void
+write_all(
+        const char *in_data,
+        size_t in_length) {
+    while ((FD >= 0) && (in_length > 0)) {
+        ssize_t written = write(FD, in_data, in_length);
+        if (written < 0) {
+            if (EINTR == errno) continue;
+            fprintf(stderr, "WARNING: error while while writing into report file \"%s\"!\n", PATH);
+            return;
+        }
+        in_data += written;
+        in_length -= (size_t) written;
+    }
+}
+
+/**
+ * @brief Write the content of a buffer into the report file, and empty the buffer.
+ * @note The lock of the buffer must be held.
+ */
+
+static void
+flush_buffer(struct Buffer *in_buffer) {
+    if (in_buffer->length > 0) {
+        pthread_mutex_lock(&FILE_LOCK);
+        write_all(in_buffer->data, in_buffer->length);
+        pthread_mutex_unlock(&FILE_LOCK);
+        in_buffer->length = 0;
+    }
+    in_buffer->last_flush_ns = now_ns();
+}
+
+static void
+thread_exit(void *in_buffer) {
+    struct Buffer *buffer = (struct Buffer *) in_buffer;
+    struct Buffer **link;
+
+    pthread_mutex_lock(&BUFFERS_LOCK);
+    pthread_mutex_lock(&buffer->lock);
+    flush_buffer(buffer);
+    pthread_mutex_unlock(&buffer->lock);
+    for (link = &BUFFERS; buffer != *link; link = &(*link)->next) {}
+    *link = buffer->next;
+    pthread_mutex_unlock(&BUFFERS_LOCK);
+    pthread_mutex_destroy(&buffer->lock);
+    free(buffer);
+    THREAD_BUFFER = NULL;
+}
+
+static void
+setup() {
+    pthread_key_create(&KEY, thread_exit);
+    atexit(RM_report_flush);
+}
+
+/**
+ * @brief Return the buffer of the calling thread (it is created on first use).
+ * @return The buffer, or NULL if it cannot be allocated.
+ */
+
+static struct Buffer *
+thread_buffer() {
+    struct Buffer *buffer = THREAD_BUFFER;
+
+    if (NULL != buffer) return buffer;
+    buffer = (struct Buffer *) malloc(sizeof(struct Buffer));
+    if (NULL == buffer) return NULL;
+    pthread_mutex_init(&buffer->lock, NULL);
+    buffer->length = 0;
+    buffer->last_flush_ns = now_ns();
+    pthread_once(&ONCE, setup);
+    pthread_setspecific(KEY, buffer);
+    pthread_mutex_lock(&BUFFERS_LOCK);
+    buffer->next = BUFFERS;
+    BUFFERS = buffer;
+    pthread_mutex_unlock(&BUFFERS_LOCK);
+    THREAD_BUFFER = buffer;
+    return buffer;
+}
+
+/**
+ * @brief Open the report file. The records written into the previous report file are flushed, and the previous
+ * report file is closed (unless it is the same file).
+ * @param in_path Path to the report file. If NULL, then the report file is closed (and no data is recorded).
+ * @return On success: RM_success. Otherwise (the file cannot be opened): RM_failure.
+ * @note Please note that this function may be called multiple times. It must not be called while other threads
+ * write records (their records could be written into the new file).
+ */
+
+RM_Status
+RM_report_open(const char *in_path) {
+    int fd;
+
+    pthread_once(&ONCE, setup);
+    RM_report_flush();
+    pthread_mutex_lock(&FILE_LOCK);
+    if ((NULL != in_path) && (NULL != PATH) && (0 == strcmp(in_path, PATH))) {
+        pthread_mutex_unlock(&FILE_LOCK);
+        return RM_success;
+    }
+    if (FD >= 0) close(FD);
+    free(PATH);
+    __atomic_store_n(&FD, -1, __ATOMIC_RELAXED);
+    PATH = NULL;
+    if (NULL == in_path) {
+        pthread_mutex_unlock(&FILE_LOCK);
+        return RM_success;
+    }
+
+    PATH = strdup(in_path);
+    fd = NULL == PATH ? -1 : open(in_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "WARNING: cannot open report file \"%s\"!\n", in_path);
+        free(PATH);
+        PATH = NULL;
+        pthread_mutex_unlock(&FILE_LOCK);
+        return RM_failure;
+    }
+    __atomic_store_n(&FD, fd, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&FILE_LOCK);
+    return RM_success;
+}
+
+/**
+ * @brief Tell whether a report file is open.
+ * @return If a report file is open: RM_true. Otherwise: RM_false.
+ */
+
+RM_Bool
+RM_report_is_open() {
+    return __atomic_load_n(&FD, __ATOMIC_RELAXED) >= 0 ? RM_true : RM_false;
+}
+
+/**
+ * @brief Add a record to the buffer of the calling thread.
+ * @param in_record The record (a whole line, including the end of line).
+ * @param in_length The length of the record, in bytes.
+ * @note If no report file is open, then the record is ignored.
+ */
+
+void
+RM_report_write(
+        const char *in_record,
+        const size_t in_length) {
+    struct Buffer *buffer;
+
+    if (RM_false == RM_report_is_open()) return;
+    buffer = thread_buffer();
+    if ((NULL == buffer) || (in_length > RM_REPORT_BUFFER_CAPACITY)) {
+        // The record is written directly (after the records of the thread, so that the order is kept).
+        if (NULL != buffer) {
+            pthread_mutex_lock(&buffer->lock);
+            flush_buffer(buffer);
+        }
+        pthread_mutex_lock(&FILE_LOCK);
+        write_all(in_record, in_length);
+        pthread_mutex_unlock(&FILE_LOCK);
+        if (NULL != buffer) pthread_mutex_unlock(&buffer->lock);
+        return;
+    }
+
+    pthread_mutex_lock(&buffer->lock);
+    if (in_length > RM_REPORT_BUFFER_CAPACITY - buffer->length) flush_buffer(buffer);
+    memcpy(buffer->data + buffer->length, in_record, in_length);
+    buffer->length += in_length;
+    if (now_ns() - buffer->last_flush_ns >= (int64_t) RM_REPORT_FLUSH_INTERVAL_MS * 1000000) flush_buffer(buffer);
+    pthread_mutex_unlock(&buffer->lock);
+}
+
+/**
+ * @brief Write the buffers of all the threads into the report file.
+ * @note This function is called when the process exits.
+ */
+
+void
+RM_report_flush() {
+    pthread_mutex_lock(&BUFFERS_LOCK);
+    for (struct Buffer *buffer = BUFFERS; NULL != buffer; buffer = buffer->next) {
+        pthread_mutex_lock(&buffer->lock);
+        flush_buffer(buffer);
+        pthread_mutex_unlock(&buffer->lock);
+    }
+    pthread_mutex_unlock(&BUFFERS_LOCK);
+}
+
+/**
+ * @brief Flush the buffers, and close the report file.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_report_close() {
+    RM_report_open(NULL);
+}
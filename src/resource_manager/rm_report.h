@@ -0,0 +1,40 @@
+#ifndef C_PATTERNS_RM_REPORT_H
+#define C_PATTERNS_RM_REPORT_H
+
+#include <stddef.h>
+#include "resource_manager.h"
+
+// The writer of the report file (see `RM_init()`): the file stays open, and the records are buffered per thread.
+//
+//      RM_report_open("/tmp/report.txt");
+//      RM_report_write("B mem ...\n", length); // appended to the buffer of the calling thread
+//      RM_report_flush();                      // all the buffers are written into the file
+//      RM_report_close();
+//
+// The buffer of a thread is written into the file when it is full, when a record is added more than
+// RM_REPORT_FLUSH_INTERVAL_MS milliseconds after the last write, when the thread exits, when the report file is
+// changed (see `RM_init()`), and when the process exits. A buffer is written
+// by a single `write()` that contains whole records: the records of different threads are not mixed up.
+
+#define RM_REPORT_BUFFER_CAPACITY 8192
+#define RM_REPORT_FLUSH_INTERVAL_MS 100
+
+RM_Status
+RM_report_open(
+        const char *in_path);
+
+RM_Bool
+RM_report_is_open();
+
+void
+RM_report_write(
+        const char *in_record,
+        size_t in_length);
+
+void
+RM_report_flush();
+
+void
+RM_report_close();
+
+#endif //C_PATTERNS_RM_REPORT_H
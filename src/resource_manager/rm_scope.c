@@ -0,0 +1,73 @@
+/**
+ * Borrow frames (see "rm_scope.h"): a frame keeps the list of the resources borrowed through it, and gives them
+ * back when it is closed.
+ *
+ * The resources are grouped by handler: the resources of a handler are given back by a single call to its
+ * `give_back_many()` (for the memory handler, a single operation on the pool). A frame is a fixed array on the
+ * stack of the caller: tracking a resource does not allocate memory.
+ */
+
+#include <stdlib.h>
+#include "rm_scope.h"
+
+/**
+ * @brief Add a borrowed resource to a frame.
+ * @param in_frame The frame.
+ * @param in_give_back_many The function that gives back the resources of the handler that lent the resource.
+ * @param in_ptr The address of the pointer assigned to the resource.
+ * @param in_borrowed The status of the call to `borrow()`.
+ * @return If the resource was borrowed, and added to the frame: RM_success. Otherwise: RM_failure. If the frame is
+ * full, then the resource is given back immediately (and the pointer is set to NULL).
+ */
+
+RM_Status
+RM_frame_track(
+        RM_Frame *in_frame,
+        RM_GiveBackMany in_give_back_many,
+        void **in_ptr,
+        RM_Status in_borrowed) {
+    if (RM_failure == in_borrowed) return RM_failure;
+    if (RM_FRAME_CAPACITY == in_frame->count) {
+        in_give_back_many(in_ptr, 1, RM_SCOPE_UID, (char *) in_frame->file, in_frame->line,
+                          (char *) in_frame->function);
+        return RM_failure;
+    }
+    in_frame->resources[in_frame->count] = *in_ptr;
+    in_frame->give_back_many[in_frame->count] = in_give_back_many;
+    in_frame->count++;
+    return RM_success;
+}
+
+/**
+ * @brief Give back all the resources of a frame: one batch per handler.
+ * @param in_frame The frame. It is empty after the call (and it can be used again).
+ * @note If a handler refuses a batch (for example, because a resource was given back explicitly), then its
+ * resources are given back one by one: the valid resources are not lost.
+ * @note Please note that you can call this function multiple times.
+ */
+
+void
+RM_frame_close(RM_Frame *in_frame) {
+    void *batch[RM_FRAME_CAPACITY];
+
+    for (size_t i = 0; i < in_frame->count; i++) {
+        const RM_GiveBackMany give_back_many = in_frame->give_back_many[i];
+        size_t count = 0;
+
+        if (NULL == give_back_many) continue; // already given back with a previous batch
+        for (size_t j = i; j < in_frame->count; j++) {
+            if (give_back_many != in_frame->give_back_many[j]) continue;
+            batch[count++] = in_frame->resources[j];
+            in_frame->give_back_many[j] = NULL;
+        }
+        if (RM_success == give_back_many(batch, count, RM_SCOPE_UID, (char *) in_frame->file, in_frame->line,
+                                         (char *) in_frame->function)) {
+            continue;
+        }
+        for (size_t k = 0; k < count; k++) {
+            give_back_many(&batch[k], 1, RM_SCOPE_UID, (char *) in_frame->file, in_frame->line,
+                           (char *) in_frame->function);
+        }
+    }
+    in_frame->count = 0;
+}
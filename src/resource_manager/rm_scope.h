@@ -0,0 +1,132 @@
+#ifndef C_PATTERNS_RM_SCOPE_H
+#define C_PATTERNS_RM_SCOPE_H
+
+#include <stddef.h>
+#include "resource_manager.h"
+#include "rm_mem.h"
+#include "rm_file.h"
+#include "rm_conn.h"
+
+// Scoped borrowing: the resources are given back automatically when the execution leaves the scope.
+//
+// A scoped variable is given back when it goes out of scope. The `RM_SCOPED_*` macros are only defined when the
+// compiler supports it (GCC and Clang, see `RM_HAS_CLEANUP`): without compiler support, a scoped variable would
+// leak silently, so use `RM_FRAME` instead.
+//
+//      void *buffer RM_SCOPED_MEM = NULL;
+//      if (RM_failure == RM_mem_borrow(&buffer, 1, RM_false)) return -1;
+//      ...
+//      return 0; // the buffer is given back
+//
+// A frame gives back all the resources borrowed through it, in one batch per handler:
+//
+//      RM_FRAME(frame) {
+//          void *buffers[2];
+//          int *fd;
+//          if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[0], 2, RM_false)) break;
+//          if (RM_failure == RM_frame_mem_borrow(&frame, &buffers[1], 3, RM_false)) break;
+//          if (RM_failure == RM_frame_file_borrow(&frame, &fd, 4, RM_false, "/etc/hosts", O_RDONLY, 0)) break;
+//          ...
+//      } // 2 buffers are given back with 1 call to `RM_mem_handler_give_back_many()`, and the descriptor
+//
+// `RM_FRAME` is portable: the frame is closed at the end of the block, and by `break`. With GCC and Clang, it is
+// also closed when the execution leaves the block by `return` or `goto`. Without compiler support, do not leave a
+// frame by `return` or `goto` (the frame would not be closed).
+//
+// Please note: a resource borrowed through a frame must not be given back explicitly, and must not be used after
+// the end of the frame.
+
+#ifndef RM_HAS_CLEANUP
+#if defined(__GNUC__) || defined(__clang__)
+#define RM_HAS_CLEANUP 1
+#else
+#define RM_HAS_CLEANUP 0
+#endif
+#endif
+
+#if RM_HAS_CLEANUP
+#define RM_CLEANUP(function) __attribute__((cleanup(function)))
+#else
+#define RM_CLEANUP(function)
+#endif
+
+// The UID given to the handlers for the resources given back automatically.
+#define RM_SCOPE_UID 0L
+
+// The maximum number of resources borrowed through a frame.
+#define RM_FRAME_CAPACITY 16
+
+typedef RM_Status (*RM_GiveBackMany)(
+        void **in_ptrs,
+        size_t in_count,
+        long in_uid,
+        char *in_file,
+        unsigned long in_line,
+        char *in_function,
+        ...);
+
+struct RM_StructFrame {
+    const char      *file;     // the location of the frame (see `RM_HERE`), given to the handlers on give back
+    unsigned long   line;
+    const char      *function;
+    size_t          count;
+    void            *resources[RM_FRAME_CAPACITY];
+    RM_GiveBackMany give_back_many[RM_FRAME_CAPACITY]; // give_back_many[i]: the handler of resources[i]
+};
+
+typedef struct RM_StructFrame RM_Frame;
+
+#define RM_FRAME_INITIALIZER { RM_HERE, 0, { NULL }, { NULL } }
+
+RM_Status
+RM_frame_track(
+        RM_Frame *in_frame,
+        RM_GiveBackMany in_give_back_many,
+        void **in_ptr,
+        RM_Status in_borrowed);
+
+void
+RM_frame_close(
+        RM_Frame *in_frame);
+
+// The inner loop runs the block once: `break` leaves the inner loop, and the outer loop closes the frame.
+#define RM_FRAME(frame) \
+    for (RM_Frame frame RM_CLEANUP(RM_frame_close) = RM_FRAME_INITIALIZER, *frame##_open = &frame; \
+         NULL != frame##_open; \
+         RM_frame_close(&frame), frame##_open = NULL) \
+        for (; NULL != frame##_open; frame##_open = NULL)
+
+#define RM_frame_mem_borrow(frame, ptr, uid, init) \
+    RM_frame_track((frame), RM_mem_handler_give_back_many, (void **) (ptr), RM_mem_borrow((ptr), (uid), (init)))
+#define RM_frame_conn_borrow(frame, ptr, uid, init) \
+    RM_frame_track((frame), RM_conn_handler_give_back_many, (void **) (ptr), RM_conn_borrow((ptr), (uid), (init)))
+#define RM_frame_file_borrow(frame, fd, uid, init, path, flags, mode) \
+    RM_frame_track((frame), RM_file_handler_give_back_many, (void **) (fd), \
+                   RM_file_borrow((fd), (uid), (init), (path), (flags), (mode)))
+
+#if RM_HAS_CLEANUP
+
+// The functions called when a scoped variable goes out of scope.
+
+static inline void
+RM_mem_scope_exit(void **in_ptr) {
+    RM_mem_give_back_at(in_ptr, RM_SCOPE_UID, NULL, 0, NULL);
+}
+
+static inline void
+RM_conn_scope_exit(void **in_ptr) {
+    RM_conn_give_back_at(in_ptr, RM_SCOPE_UID, NULL, 0, NULL);
+}
+
+static inline void
+RM_file_scope_exit(int **in_fd) {
+    RM_file_give_back_at(in_fd, RM_SCOPE_UID, NULL, 0, NULL);
+}
+
+#define RM_SCOPED_MEM  RM_CLEANUP(RM_mem_scope_exit)
+#define RM_SCOPED_CONN RM_CLEANUP(RM_conn_scope_exit)
+#define RM_SCOPED_FILE RM_CLEANUP(RM_file_scope_exit)
+
+#endif // RM_HAS_CLEANUP: without compiler support, `RM_SCOPED_*` are not defined (use `RM_FRAME`)
+
+#endif //C_PATTERNS_RM_SCOPE_H
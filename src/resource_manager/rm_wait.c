@@ -0,0 +1,183 @@
+/**
+ * FIFO wait queue: the threads that cannot borrow a resource wait in a queue, and the resources that are given
+ * back are handed to the oldest waiter first.
+ *
+ * Each waiter waits on its own condition variable. Waking up the oldest waiter does not wake up the others
+ * (no "thundering herd"), and the resource cannot be stolen by a thread that arrives later: it is assigned to
+ * the waiter before the waiter wakes up.
+ *
+ * The conditions use the monotonic clock, so that the timeouts are not affected by changes of the system time.
+ */
+
+#include <time.h>
+#include "rm_wait.h"
+
+static int64_t
+now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+unlink_waiter(
+        RM_WaitQueue *in_queue,
+        const RM_Waiter *in_waiter) {
+    RM_Waiter **link = &in_queue->head;
+    RM_Waiter *previous = NULL;
+
+    while ((NULL != *link) && (in_waiter != *link)) {
+        previous = *link;
+        link = &(*link)->next;
+    }
+    if (NULL == *link) return;
+    *link = in_waiter->next;
+    if (in_queue->tail == in_waiter) in_queue->tail = previous;
+    in_queue->stats.depth--;
+}
+
+/**
+ * @brief Initialize an empty wait queue.
+ * @param in_queue The queue.
+ */
+
+void
+RM_wait_queue_init(RM_WaitQueue *in_queue) {
+    in_queue->head                = NULL;
+    in_queue->tail                = NULL;
+    in_queue->stats.depth         = 0;
+    in_queue->stats.max_depth     = 0;
+    in_queue->stats.waits         = 0;
+    in_queue->stats.timeouts      = 0;
+    in_queue->stats.total_wait_ns = 0;
+    in_queue->stats.max_wait_ns   = 0;
+}
+
+/**
+ * @brief Put a waiter at the end of the queue.
+ * @param in_queue The queue.
+ * @param in_waiter The waiter (typically, a variable on the stack of the waiting thread).
+ * @note The lock that protects the queue must be held.
+ */
+
+void
+RM_wait_queue_enqueue(
+        RM_WaitQueue *in_queue,
+        RM_Waiter *in_waiter) {
+    pthread_condattr_t attributes;
+
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&in_waiter->condition, &attributes);
+    pthread_condattr_destroy(&attributes);
+    in_waiter->item     = NULL;
+    in_waiter->served   = 0;
+    in_waiter->cancelled = 0;
+    in_waiter->since_ns = now_ns();
+    in_waiter->waited_ns = 0;
+    in_waiter->next     = NULL;
+
+    if (NULL == in_queue->tail) in_queue->head = in_waiter;
+    else in_queue->tail->next = in_waiter;
+    in_queue->tail = in_waiter;
+    in_queue->stats.waits++;
+    if (++in_queue->stats.depth > in_queue->stats.max_depth) in_queue->stats.max_depth = in_queue->stats.depth;
+}
+
+/**
+ * @brief Wait until a resource is handed to the waiter (see `RM_wait_queue_serve()`), until the timeout
+ * expires, or until the queue is cancelled (see `RM_wait_queue_cancel_all()`). In all cases, the waiter leaves
+ * the queue.
+ * @param in_queue The queue.
+ * @param in_waiter The waiter (see `RM_wait_queue_enqueue()`).
+ * @param in_lock The lock that protects the queue. It must be held: it is released while waiting.
+ * @param in_timeout_ms The maximum waiting time, in milliseconds, or `RM_WAIT_FOREVER`.
+ * @return If a resource is handed to the waiter (see `in_waiter->item`): RM_success. Otherwise: RM_failure.
+ */
+
+RM_Status
+RM_wait_queue_wait(
+        RM_WaitQueue *in_queue,
+        RM_Waiter *in_waiter,
+        pthread_mutex_t *in_lock,
+        const long in_timeout_ms) {
+    struct timespec deadline;
+    uint64_t waited;
+
+    if (in_timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += in_timeout_ms / 1000;
+        deadline.tv_nsec += (in_timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    while ((! in_waiter->served) && (! in_waiter->cancelled)) {
+        int status = in_timeout_ms >= 0
+                ? pthread_cond_timedwait(&in_waiter->condition, in_lock, &deadline)
+                : pthread_cond_wait(&in_waiter->condition, in_lock);
+        // The waiter may have been served just before the timeout: the resource is taken anyway.
+        if ((0 != status) && (! in_waiter->served)) break;
+    }
+
+    waited = (uint64_t)(now_ns() - in_waiter->since_ns);
+    in_waiter->waited_ns = waited;
+    in_queue->stats.total_wait_ns += waited;
+    if (waited > in_queue->stats.max_wait_ns) in_queue->stats.max_wait_ns = waited;
+    pthread_cond_destroy(&in_waiter->condition);
+    if (! in_waiter->served) {
+        unlink_waiter(in_queue, in_waiter);
+        if (! in_waiter->cancelled) in_queue->stats.timeouts++;
+        return RM_failure;
+    }
+    return RM_success;
+}
+
+/**
+ * @brief Hand a resource to the oldest waiter, and wake it up.
+ * @param in_queue The queue.
+ * @param in_item The resource.
+ * @return If a thread was waiting: RM_true (the resource belongs to the waiter now). Otherwise: RM_false.
+ * @note The lock that protects the queue must be held.
+ */
+
+RM_Bool
+RM_wait_queue_serve(
+        RM_WaitQueue *in_queue,
+        void *in_item) {
+    RM_Waiter *waiter = in_queue->head;
+
+    if (NULL == waiter) return RM_false;
+    in_queue->head = waiter->next;
+    if (NULL == in_queue->head) in_queue->tail = NULL;
+    in_queue->stats.depth--;
+    waiter->item   = in_item;
+    waiter->served = 1;
+    pthread_cond_signal(&waiter->condition);
+    return RM_true;
+}
+
+/**
+ * @brief Remove all the waiters from the queue, and wake them up: `RM_wait_queue_wait()` fails for each of them.
+ * @param in_queue The queue.
+ * @return The number of waiters that were cancelled.
+ * @note The lock that protects the queue must be held. Call this function before the resources the waiters
+ * wait for are released: once the lock is released, the waiters return without touching them.
+ */
+
+size_t
+RM_wait_queue_cancel_all(RM_WaitQueue *in_queue) {
+    size_t count = 0;
+
+    while (NULL != in_queue->head) {
+        RM_Waiter *waiter = in_queue->head;
+        in_queue->head = waiter->next;
+        waiter->cancelled = 1;
+        pthread_cond_signal(&waiter->condition);
+        count++;
+    }
+    in_queue->tail = NULL;
+    in_queue->stats.depth = 0;
+    return count;
+}
@@ -0,0 +1,87 @@
+#ifndef C_PATTERNS_RM_WAIT_H
+#define C_PATTERNS_RM_WAIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "resource_manager.h"
+
+// A FIFO queue of threads waiting for a resource. The queue is protected by the lock of the handler that owns it.
+//
+//      // Borrower (the lock is held):
+//      RM_Waiter waiter;
+//      RM_wait_queue_enqueue(&queue, &waiter);
+//      if (RM_success == RM_wait_queue_wait(&queue, &waiter, &lock, timeout_ms)) resource = waiter.item;
+//
+//      // Giver (the lock is held):
+//      if (RM_false == RM_wait_queue_serve(&queue, resource)) { /* nobody waits: keep the resource */ }
+//
+//      // Owner, before the resources are released (the lock is held): all the waiters fail.
+//      RM_wait_queue_cancel_all(&queue);
+//
+// The resource is handed directly to the oldest waiter: a thread that arrives later cannot take it first.
+
+// Timeout value that means "wait until a resource is available".
+#define RM_WAIT_FOREVER (-1L)
+
+struct RM_StructWaiter {
+    pthread_cond_t         condition; // each waiter has its own condition: the oldest waiter is woken up alone
+    void                   *item;     // the resource handed to the waiter
+    int                    served;
+    int                    cancelled; // set by `RM_wait_queue_cancel_all()`
+    int64_t                since_ns;
+    uint64_t               waited_ns; // set by `RM_wait_queue_wait()`
+    struct RM_StructWaiter *next;
+};
+
+typedef struct RM_StructWaiter RM_Waiter;
+
+/**
+ * The statistics of a wait queue (used to size the pools).
+ */
+
+struct RM_StructWaitStats {
+    size_t   depth;         // number of threads waiting now
+    size_t   max_depth;
+    uint64_t waits;         // number of borrowers that had to wait
+    uint64_t timeouts;      // number of borrowers that gave up
+    uint64_t total_wait_ns; // cumulated waiting time (served and timed out)
+    uint64_t max_wait_ns;
+};
+
+typedef struct RM_StructWaitStats RM_WaitStats;
+
+struct RM_StructWaitQueue {
+    RM_Waiter    *head; // the oldest waiter
+    RM_Waiter    *tail;
+    RM_WaitStats stats;
+};
+
+typedef struct RM_StructWaitQueue RM_WaitQueue;
+
+void
+RM_wait_queue_init(
+        RM_WaitQueue *in_queue);
+
+void
+RM_wait_queue_enqueue(
+        RM_WaitQueue *in_queue,
+        RM_Waiter *in_waiter);
+
+RM_Status
+RM_wait_queue_wait(
+        RM_WaitQueue *in_queue,
+        RM_Waiter *in_waiter,
+        pthread_mutex_t *in_lock,
+        long in_timeout_ms);
+
+RM_Bool
+RM_wait_queue_serve(
+        RM_WaitQueue *in_queue,
+        void *in_item);
+
+size_t
+RM_wait_queue_cancel_all(
+        RM_WaitQueue *in_queue);
+
+#endif //C_PATTERNS_RM_WAIT_H